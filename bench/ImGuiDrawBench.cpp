@@ -0,0 +1,362 @@
+// CPU microbenchmarks for the ImGui draw-list and font hot paths in imgui_draw.cpp.
+// Runs headless (no SDL/Vulkan backend) and prints ns per primitive/glyph and vertices per second.
+//
+// Usage: vklearn_imgui_bench [--filter <substring>] [--iterations <n>] [--font <path.ttf>]
+// The cyrillic and chinese-full atlas builds only run with --font, the default font has none of their glyphs.
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+struct SBenchResult
+{
+	double Nanoseconds = 0.0;
+	uint64_t Units = 0;
+	uint64_t Vertices = 0;
+};
+
+struct SBenchCase
+{
+	const char* Name;
+	const char* Unit;
+	// executes one iteration and reports the processed units and generated vertices
+	std::function<void(SBenchResult&)> Run;
+};
+
+const int kDefaultIterations = 200;
+const int kWarmupIterations = 5;
+const float kPi = 3.14159265358979f;
+
+static const char* const kLoremIpsum =
+	"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. "
+	"Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat. "
+	"Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur.\n";
+
+static void ResetDrawList(ImDrawList& drawList)
+{
+	// a clip rect covering the whole workload so that text lines are emitted instead of being culled
+	drawList._ResetForNewFrame();
+	drawList.PushClipRect(ImVec2(-1e7f, -1e7f), ImVec2(1e7f, 1e7f));
+	drawList.PushTextureID(ImGui::GetIO().Fonts->TexID);
+}
+
+static std::vector<ImVec2> MakeWavePolyline(const int count)
+{
+	std::vector<ImVec2> points(count);
+	for (int i = 0; i < count; i++)
+	{
+		const float t = static_cast<float>(i) / static_cast<float>(count);
+		points[i] = ImVec2(t * 1900.f + 10.f, 540.f + std::sin(t * 400.f) * 300.f);
+	}
+	return points;
+}
+
+static std::vector<ImVec2> MakeCircle(const int count, const ImVec2 center, const float radius)
+{
+	// clockwise, as required by the anti-aliased fill
+	std::vector<ImVec2> points(count);
+	for (int i = 0; i < count; i++)
+	{
+		const float a = -2.f * kPi * static_cast<float>(i) / static_cast<float>(count);
+		points[i] = ImVec2(center.x + std::cos(a) * radius, center.y + std::sin(a) * radius);
+	}
+	return points;
+}
+
+static std::vector<SBenchCase> MakeBenchCases(ImDrawList& drawList, ImFont* font, const std::string& longText)
+{
+	std::vector<SBenchCase> cases;
+
+	const auto addPolyline = [&](const char* name, const int pointCount, const float thickness, const bool antiAliased)
+	{
+		const std::vector<ImVec2> points = MakeWavePolyline(pointCount);
+		cases.push_back({ name, "segment", [&drawList, points, thickness, antiAliased](SBenchResult& result)
+		{
+			ResetDrawList(drawList);
+			drawList.Flags = antiAliased ? ImDrawListFlags_AntiAliasedLines : ImDrawListFlags_None;
+			drawList.AddPolyline(points.data(), static_cast<int>(points.size()), IM_COL32_WHITE, false, thickness);
+			result.Units += points.size() - 1;
+			result.Vertices += drawList.VtxBuffer.Size;
+		} });
+	};
+
+	addPolyline("AddPolyline/aa/1px/100k", 100000, 1.f, true);
+	addPolyline("AddPolyline/aa/3px/100k", 100000, 3.f, true);
+	addPolyline("AddPolyline/noaa/1px/100k", 100000, 1.f, false);
+
+	{
+		std::vector<std::vector<ImVec2>> polygons;
+		for (int i = 0; i < 1000; i++)
+		{
+			polygons.push_back(MakeCircle(32, ImVec2(static_cast<float>(i % 40) * 48.f + 24.f, static_cast<float>(i / 40) * 40.f + 24.f), 20.f));
+		}
+		cases.push_back({ "AddConvexPolyFilled/aa/32pt/1k", "polygon", [&drawList, polygons](SBenchResult& result)
+		{
+			ResetDrawList(drawList);
+			drawList.Flags = ImDrawListFlags_AntiAliasedFill;
+			for (const std::vector<ImVec2>& polygon : polygons)
+			{
+				drawList.AddConvexPolyFilled(polygon.data(), static_cast<int>(polygon.size()), IM_COL32(255, 128, 0, 255));
+			}
+			result.Units += polygons.size();
+			result.Vertices += drawList.VtxBuffer.Size;
+		} });
+	}
+
+	cases.push_back({ "PathArcTo/stroke/64seg/10k", "arc", [&drawList](SBenchResult& result)
+	{
+		ResetDrawList(drawList);
+		drawList.Flags = ImDrawListFlags_AntiAliasedLines;
+		for (int i = 0; i < 10000; i++)
+		{
+			const ImVec2 center(static_cast<float>(i % 100) * 19.f, static_cast<float>(i / 100) * 10.f);
+			drawList.PathArcTo(center, 8.f, 0.f, kPi * 1.5f, 64);
+			drawList.PathStroke(IM_COL32_WHITE, false, 1.f);
+		}
+		result.Units += 10000;
+		result.Vertices += drawList.VtxBuffer.Size;
+	} });
+
+	cases.push_back({ "AddRectFilled/rounded/10k", "rect", [&drawList](SBenchResult& result)
+	{
+		ResetDrawList(drawList);
+		drawList.Flags = ImDrawListFlags_AntiAliasedFill;
+		for (int i = 0; i < 10000; i++)
+		{
+			const ImVec2 min(static_cast<float>(i % 100) * 19.f, static_cast<float>(i / 100) * 10.f);
+			drawList.AddRectFilled(min, ImVec2(min.x + 16.f, min.y + 8.f), IM_COL32(40, 80, 160, 255), 4.f);
+		}
+		result.Units += 10000;
+		result.Vertices += drawList.VtxBuffer.Size;
+	} });
+
+	cases.push_back({ "AddRect/rounded/10k", "rect", [&drawList](SBenchResult& result)
+	{
+		ResetDrawList(drawList);
+		drawList.Flags = ImDrawListFlags_AntiAliasedLines;
+		for (int i = 0; i < 10000; i++)
+		{
+			const ImVec2 min(static_cast<float>(i % 100) * 19.f, static_cast<float>(i / 100) * 10.f);
+			drawList.AddRect(min, ImVec2(min.x + 16.f, min.y + 8.f), IM_COL32(40, 80, 160, 255), 4.f);
+		}
+		result.Units += 10000;
+		result.Vertices += drawList.VtxBuffer.Size;
+	} });
+
+	const uint64_t glyphCount = static_cast<uint64_t>(longText.size());
+
+	cases.push_back({ "AddText/unwrapped", "glyph", [&drawList, font, &longText, glyphCount](SBenchResult& result)
+	{
+		ResetDrawList(drawList);
+		drawList.AddText(font, font->FontSize, ImVec2(0, 0), IM_COL32_WHITE, longText.c_str(), longText.c_str() + longText.size());
+		result.Units += glyphCount;
+		result.Vertices += drawList.VtxBuffer.Size;
+	} });
+
+	cases.push_back({ "AddText/wrapped/600px", "glyph", [&drawList, font, &longText, glyphCount](SBenchResult& result)
+	{
+		ResetDrawList(drawList);
+		drawList.AddText(font, font->FontSize, ImVec2(0, 0), IM_COL32_WHITE, longText.c_str(), longText.c_str() + longText.size(), 600.f);
+		result.Units += glyphCount;
+		result.Vertices += drawList.VtxBuffer.Size;
+	} });
+
+	cases.push_back({ "CalcTextSizeA/unwrapped", "glyph", [font, &longText, glyphCount](SBenchResult& result)
+	{
+		const ImVec2 size = font->CalcTextSizeA(font->FontSize, FLT_MAX, 0.f, longText.c_str(), longText.c_str() + longText.size());
+		result.Units += glyphCount + (size.x < 0.f ? 1 : 0);
+	} });
+
+	cases.push_back({ "CalcTextSizeA/wrapped/600px", "glyph", [font, &longText, glyphCount](SBenchResult& result)
+	{
+		const ImVec2 size = font->CalcTextSizeA(font->FontSize, FLT_MAX, 600.f, longText.c_str(), longText.c_str() + longText.size());
+		result.Units += glyphCount + (size.x < 0.f ? 1 : 0);
+	} });
+
+	return cases;
+}
+
+static uint64_t CountRangeCodepoints(const ImWchar* ranges)
+{
+	uint64_t count = 0;
+	for (; ranges[0] != 0; ranges += 2)
+	{
+		count += static_cast<uint64_t>(ranges[1] - ranges[0]) + 1;
+	}
+	return count;
+}
+
+static SBenchResult RunAtlasBuild(const char* fontPath, const ImWchar* ranges, const int iterations)
+{
+	SBenchResult result;
+
+	for (int i = 0; i < iterations; i++)
+	{
+		ImFontAtlas atlas;
+		for (float size = 13.f; size <= 32.f; size += 6.f)
+		{
+			ImFontConfig config;
+			config.SizePixels = size;
+			if (fontPath != nullptr)
+			{
+				atlas.AddFontFromFileTTF(fontPath, size, &config, ranges);
+			}
+			else
+			{
+				config.GlyphRanges = ranges;
+				atlas.AddFontDefault(&config);
+			}
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		atlas.Build();
+		result.Nanoseconds += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		for (const ImFont* font : atlas.Fonts)
+		{
+			result.Units += font->Glyphs.Size;
+		}
+	}
+
+	return result;
+}
+
+static void PrintResult(const char* name, const char* unit, const SBenchResult& result, const int iterations)
+{
+	const double nsPerIteration = result.Nanoseconds / iterations;
+	const double nsPerUnit = result.Units != 0 ? result.Nanoseconds / static_cast<double>(result.Units) : 0.0;
+	const double verticesPerSecond = result.Nanoseconds > 0.0 ? static_cast<double>(result.Vertices) / (result.Nanoseconds * 1e-9) : 0.0;
+
+	printf("%-32s %12.1f us/iter %10.2f ns/%-8s %10.2f Mvtx/s\n", name, nsPerIteration * 1e-3, nsPerUnit, unit, verticesPerSecond * 1e-6);
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = nullptr;
+	const char* fontPath = nullptr;
+	int iterations = kDefaultIterations;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc)
+		{
+			fontPath = argv[++i];
+		}
+		else
+		{
+			printf("Usage: %s [--filter <substring>] [--iterations <n>] [--font <path.ttf>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.IniFilename = nullptr;
+	io.DisplaySize = ImVec2(1920.f, 1080.f);
+	io.DeltaTime = 1.f / 60.f;
+
+	ImFont* font = fontPath != nullptr ? io.Fonts->AddFontFromFileTTF(fontPath, 16.f) : io.Fonts->AddFontDefault();
+	if (font == nullptr)
+	{
+		printf("Unable to load font %s\n", fontPath);
+		return 1;
+	}
+
+	unsigned char* pixels;
+	int width, height;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+	// a frame must be active for the shared draw-list data (font, circle tables) to be set up
+	ImGui::NewFrame();
+
+	ImDrawList drawList(ImGui::GetDrawListSharedData());
+
+	std::string longText;
+	for (int i = 0; i < 200; i++)
+	{
+		longText += kLoremIpsum;
+	}
+
+	printf("%-32s %20s %22s %17s\n", "benchmark", "time", "per unit", "throughput");
+
+	for (const SBenchCase& benchCase : MakeBenchCases(drawList, font, longText))
+	{
+		if (filter != nullptr && strstr(benchCase.Name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		SBenchResult discarded;
+		for (int i = 0; i < kWarmupIterations; i++)
+		{
+			benchCase.Run(discarded);
+		}
+
+		SBenchResult result;
+		for (int i = 0; i < iterations; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			benchCase.Run(result);
+			result.Nanoseconds += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		PrintResult(benchCase.Name, benchCase.Unit, result, iterations);
+	}
+
+	const struct
+	{
+		const char* Name;
+		const ImWchar* Ranges;
+		// the built-in ProggyClean font only covers the default ranges, so the others would rasterize the
+		// same glyphs under a misleading name
+		bool NeedsFont;
+	} atlasCases[] = {
+		{ "FontAtlas::Build/default", io.Fonts->GetGlyphRangesDefault(), false },
+		{ "FontAtlas::Build/cyrillic", io.Fonts->GetGlyphRangesCyrillic(), true },
+		{ "FontAtlas::Build/chinese-full", io.Fonts->GetGlyphRangesChineseFull(), true },
+	};
+
+	// font atlas builds are much slower than draw-list calls, so they run fewer iterations
+	const int atlasIterations = std::max(1, iterations / 20);
+
+	for (const auto& atlasCase : atlasCases)
+	{
+		if (filter != nullptr && strstr(atlasCase.Name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		if (atlasCase.NeedsFont && fontPath == nullptr)
+		{
+			printf("%-32s skipped, needs --font with the glyphs\n", atlasCase.Name);
+			continue;
+		}
+
+		const SBenchResult result = RunAtlasBuild(fontPath, atlasCase.Ranges, atlasIterations);
+		PrintResult(atlasCase.Name, "glyph", result, atlasIterations);
+		printf("%-32s %12llu codepoints requested per font\n", "", static_cast<unsigned long long>(CountRangeCodepoints(atlasCase.Ranges)));
+	}
+
+	ImGui::EndFrame();
+	ImGui::DestroyContext();
+
+	return 0;
+}
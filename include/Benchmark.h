@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "Engine.h"
+#include "RenderProfiler.h"
+
+struct SBenchmarkSeries
+{
+	float Mean = 0.f;
+	float Min = 0.f;
+	float Max = 0.f;
+	float P50 = 0.f;
+	float P90 = 0.f;
+	float P95 = 0.f;
+	float P99 = 0.f;
+};
+
+class CBenchmark
+{
+public:
+	void Initialize(const SEngineOptions& options);
+	// records one frame, returns true once the measured run is complete
+	bool OnFrame(float frameTimeMs, const CRender* render);
+	bool WriteReport(const CRender* render) const;
+
+	bool IsWarmingUp() const;
+private:
+	static SBenchmarkSeries Summarize(std::vector<float> samples);
+
+	SEngineOptions m_Options;
+	uint32_t m_FrameIndex = 0;
+	float m_MeasuredTime = 0.f;
+
+	std::vector<float> m_FrameTimes;
+	std::vector<float> m_CpuPassTimes[kRenderPassCount];
+	std::vector<float> m_GpuPassTimes[kRenderPassCount];
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Engine.h"
+
+class CJobSystem;
+
+// below this many objects the cull runs on the calling thread alone
+const uint32_t kCullingParallelThreshold = 16384;
+// objects per batch handed to a thread, a multiple of the SIMD width
+const uint32_t kCullingBatchSize = 8192;
+
+enum class EFrustumPlane : uint8_t
+{
+	Left = 0,
+	Right,
+	Bottom,
+	Top,
+	Near,
+	Far,
+	Count
+};
+
+const uint32_t kFrustumPlaneCount = static_cast<uint32_t>(EFrustumPlane::Count);
+
+// planes point inwards and are normalized, so that dot(plane.xyz, p) + plane.w is a signed distance
+struct SFrustum
+{
+	glm::vec4 Planes[kFrustumPlaneCount];
+};
+
+// Vulkan clip space, depth in [0, 1]
+SFrustum ExtractFrustum(const glm::mat4& viewProjection);
+
+// structure-of-arrays bounding spheres, readable up to count rounded up to kSceneSimdWidth
+struct SCullingInput
+{
+	const float* PositionX;
+	const float* PositionY;
+	const float* PositionZ;
+	const float* Radius;
+	uint32_t Count;
+	// added to every radius, e.g. to cover the motion between the culled and the rendered state
+	float Margin;
+};
+
+struct SCullingStats
+{
+	uint32_t Tested = 0;
+	uint32_t Visible = 0;
+	uint32_t Threads = 0;
+	float CullMs = 0.f;
+};
+
+// Tests bounding spheres against a frustum, kSimdLanes objects at a time, splitting large inputs into
+// batches that run as jobs on every thread. The result is an ascending, compact list of visible object
+// indices.
+class CFrustumCuller
+{
+public:
+	EEngineStatus Initialize(CJobSystem* jobs);
+
+	// visible must hold input.Count indices; returns the visible count
+	uint32_t Cull(const SFrustum& frustum, const SCullingInput& input, uint32_t* visible);
+	const SCullingStats& GetStats() const;
+private:
+	struct SBatch
+	{
+		uint32_t Begin;
+		uint32_t End;
+		uint32_t Visible;
+	};
+
+	CJobSystem* m_Jobs = nullptr;
+	std::vector<SBatch> m_Batches;
+
+	SCullingStats m_Stats;
+};
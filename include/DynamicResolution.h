@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Engine.h"
+#include "RenderSync.h"
+#include "RenderVulkan.h"
+
+// smallest fraction of the output extent the scene is rendered at, per axis
+const float kMinResolutionScale = 0.5f;
+// the render extent is a multiple of this many pixels, so that small scale corrections do not resize it
+// every frame
+const uint32_t kResolutionGranularity = 8;
+// weight of the newest frame in the smoothed scene time that the scale rises on
+const float kResolutionSmoothing = 0.1f;
+// scene times within this fraction of the budget leave the scale alone
+const float kResolutionDeadband = 0.05f;
+// largest scale increase per adjustment; decreases are not limited
+const float kResolutionMaxIncrease = 0.02f;
+// GPU timings are read back once the frame slot comes around again, so a new extent only shows up in
+// them after this many frames
+const uint32_t kResolutionSettleFrames = kMaxFramesInFlight + 1;
+
+struct SDynamicResolutionStats
+{
+	// render extent over the output extent, per axis
+	float Scale = 1.f;
+	vk::Extent2D Extent;
+	// the part of the target left to the scene once the fixed cost of upscaling and the UI is taken out
+	float BudgetMs = 0.f;
+	float SmoothedSceneMs = 0.f;
+	// extent changes since startup
+	uint32_t Changes = 0;
+};
+
+// Picks the extent the scene is rendered at from its measured GPU time. The scene's cost is taken to be
+// proportional to its pixel count, so a frame over budget scales both axes by the square root of the
+// budget over its time right away, while a frame under budget raises the scale from the smoothed time and
+// by kResolutionMaxIncrease at most; a spike is answered on the next frame, and the scale creeps back
+// once it has passed. After every change the controller waits for the timings of the new extent.
+class CDynamicResolution
+{
+public:
+	void Initialize(vk::Extent2D outputExtent);
+
+	// with the last measured GPU times of the scene and of the passes that run at the output extent; a
+	// zero target or scene time, e.g. without timestamps, renders at the full extent
+	void Update(float targetMs, float sceneGpuMs, float fixedGpuMs);
+
+	vk::Extent2D GetOutputExtent() const;
+	// the top left corner of the output extent that the scene renders to
+	vk::Extent2D GetExtent() const;
+	const SDynamicResolutionStats& GetStats() const;
+private:
+	void SetScale(float scale);
+
+	vk::Extent2D m_OutputExtent;
+	float m_Scale = 1.f;
+	uint32_t m_SettleFrames = 0;
+	SDynamicResolutionStats m_Stats;
+};
@@ -1,6 +1,8 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <chrono>
+#include <string>
 
 enum class EEngineStatus : uint8_t
 {
@@ -10,10 +12,55 @@ enum class EEngineStatus : uint8_t
 
 class CViewport;
 class CRender;
+class CBenchmark;
+class CJobSystem;
 struct SEngineSubsystems;
 
 const uint16_t kFPSSampleCount = 4096;
 
+const double kSimulationTimeStep = 1.0 / 120.0;
+// ticks simulated per frame at most; any backlog beyond that is dropped instead of spiralling
+const uint32_t kMaxSimulationStepsPerFrame = 8;
+
+// process exit codes returned by CEngine::Run
+const int kExitCodeInitializeFailed = 1;
+const int kExitCodeUpdateFailed = 2;
+const int kExitCodeShutdownFailed = 3;
+const int kExitCodeInvalidArguments = 4;
+const int kExitCodeReportFailed = 5;
+
+struct SEngineOptions
+{
+	bool Benchmark = false;
+	uint32_t WarmupFrames = 120;
+	// when zero the measured run is bounded by BenchmarkDuration instead
+	uint32_t BenchmarkFrames = 0;
+	float BenchmarkDuration = 10.f;
+	float FixedDeltaTime = 1.f / 60.f;
+	std::string ReportPath = "benchmark.json";
+	// physical device index or name substring, empty to pick the highest-scoring device
+	std::string Device;
+	// allow and prefer software rasterizers such as lavapipe/SwiftShader
+	bool SoftwareDevice = false;
+	// use the bindless resource table when the device supports descriptor indexing
+	bool Bindless = true;
+	// one of kVertexLayouts, see VertexLayout.h
+	std::string VertexLayout = "snorm16";
+	// objects spawned into the scene, zero for the single spinning triangle
+	uint32_t SceneObjects = 0;
+	// .vkmesh file drawn instead of the triangle, empty for none
+	std::string Mesh;
+	// .vktex file streamed in and sampled by the scene, empty for none; needs the bindless table
+	std::string Texture;
+	// scene pass samples per pixel, resolved into the swap chain image inside the pass
+	uint32_t Msaa = 1;
+	// start frames only once the GPU has finished the previous one and latch the rotation at submission
+	bool LowLatency = false;
+	// GPU frame time in milliseconds that the scene resolution is scaled to meet, zero to always render
+	// the scene at the window resolution
+	float DynamicResolutionTargetMs = 0.f;
+};
+
 class CEngine
 {
 public:
@@ -21,15 +68,32 @@ public:
 
 	CViewport* GetViewport() const;
 	CRender* GetRender() const;
+	CBenchmark* GetBenchmark() const;
+	CJobSystem* GetJobSystem() const;
+	const SEngineOptions& GetOptions() const;
 	void Quit();
 	void OnRenderGui() const;
 private:
+	static bool ParseOptions(int argc, char** argv, SEngineOptions& options);
+	// runs Update until the engine quits
+	void FrameThreadMain();
+
+	void RenderPassStatisticsGui() const;
+	void RenderMemoryGui() const;
+
 	std::chrono::high_resolution_clock::time_point m_LastTime;
-	bool m_ShouldUpdate = true;
+	// written by the window and the frame thread
+	std::atomic<bool> m_ShouldUpdate{ true };
+	std::atomic<bool> m_UpdateFailed{ false };
 	SEngineSubsystems* m_Subsystems = nullptr;
+	SEngineOptions m_Options;
 	float m_FPSSum = 0.f;
 	uint16_t m_FPSCount = 0;
 	float m_FPS = 0.f;
+	float m_FrameTimeSum = 0.f;
+	float m_FrameTime = 0.f;
+	double m_SimulationAccumulator = 0.0;
+	uint32_t m_SimulationSteps = 0;
 	
 	EEngineStatus Initialize();
 	EEngineStatus Update();
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+// the largest vertex count that 16-bit indices can address; primitive restart is not used, so 0xFFFF is a valid index
+const uint32_t kMaxVertexCountUint16 = 0x10000;
+
+// 16-bit indices whenever the vertex count allows it, 32-bit otherwise
+vk::IndexType SelectIndexType(uint32_t vertexCount);
+uint32_t GetIndexSize(vk::IndexType indexType);
+
+// writes count indices of the given type, narrowing 32-bit source indices when indexType is eUint16
+void EncodeIndices(const uint32_t* indices, uint32_t count, vk::IndexType indexType, void* destination);
+// copies count indices of sourceIndexSize bytes, narrowing them like EncodeIndices; returns false when one of
+// them does not address one of vertexCount vertices, the destination is written in full either way
+bool CopyIndices(const void* source, uint32_t sourceIndexSize, uint32_t count, uint32_t vertexCount, vk::IndexType indexType, void* destination);
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Engine.h"
+
+// worker threads besides the attached thread, which runs jobs too while it waits
+const uint32_t kMaxJobWorkers = 15;
+
+enum class EJobAffinity : uint8_t
+{
+	// any worker or the main thread
+	Any = 0,
+	// only the main thread, e.g. for SDL calls that must stay on the thread that created the window
+	MainThread,
+	Count
+};
+
+// unfinished jobs of a group; it must outlive the jobs and the waits that refer to it
+struct SJobCounter
+{
+	std::atomic<uint32_t> Pending{ 0 };
+};
+
+struct SJobStats
+{
+	uint32_t Workers = 0;
+	// jobs run during the last frame, and how many of them were taken from another thread's queue
+	uint32_t Executed = 0;
+	uint32_t Stolen = 0;
+};
+
+// Work-stealing job scheduler. Every job thread owns a queue: it pushes and pops its own jobs at the back,
+// newest first, and idle threads steal the oldest jobs from the front of the others. Jobs signal
+// counters when they finish, which other jobs can depend on and any thread can wait for; a waiting
+// thread runs jobs instead of blocking, so waits may nest inside jobs. The thread that initializes the
+// system is the main thread, the only one to run main thread jobs. The first queue belongs to no worker
+// but to the thread that issues and waits for most jobs, which attaches itself with AttachThread; until
+// then, and from any other thread, jobs are spread over all queues.
+class CJobSystem
+{
+public:
+	// workerCount is clamped to kMaxJobWorkers, zero runs every job on the threads that wait for them
+	EEngineStatus Initialize(uint32_t workerCount);
+	// gives the calling thread the first queue, e.g. the frame thread; only one thread may attach
+	void AttachThread();
+	// runs the jobs still queued, then stops the workers; on the main thread, once the attached thread is done
+	void Shutdown();
+
+	// runs the main thread jobs queued so far, on the main thread only
+	void RunMainThreadJobs();
+	// collects the statistics, once per frame
+	void Update();
+
+	// counter, if given, is incremented now and decremented once the job has run
+	void Run(std::function<void()> job, SJobCounter* counter = nullptr, EJobAffinity affinity = EJobAffinity::Any);
+	// the job is held back until dependency has reached zero
+	void RunAfter(const SJobCounter& dependency, std::function<void()> job, SJobCounter* counter = nullptr, EJobAffinity affinity = EJobAffinity::Any);
+	// runs other jobs on the calling thread until the counter has reached zero
+	void Wait(const SJobCounter& counter);
+
+	// calls function(begin, end) for consecutive ranges of at most batchSize covering [0, count) on every
+	// thread, and returns once all of them have run
+	template <typename TFunction>
+	void ParallelFor(uint32_t count, uint32_t batchSize, const TFunction& function)
+	{
+		if (count <= batchSize || m_Threads.empty())
+		{
+			function(0u, count);
+			return;
+		}
+
+		SJobCounter counter;
+		// the calling thread takes the first range itself
+		for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			const uint32_t end = std::min(begin + batchSize, count);
+			Run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+		function(0u, batchSize);
+		Wait(counter);
+	}
+
+	uint32_t GetWorkerCount() const;
+	bool IsMainThread() const;
+	const SJobStats& GetStats() const;
+private:
+	struct SJob
+	{
+		std::function<void()> Function;
+		SJobCounter* Counter = nullptr;
+		EJobAffinity Affinity = EJobAffinity::Any;
+	};
+
+	struct SJobQueue
+	{
+		std::mutex Mutex;
+		std::deque<SJob> Jobs;
+	};
+
+	struct SDeferredJob
+	{
+		const SJobCounter* Dependency;
+		SJob Job;
+	};
+
+	void WorkerMain(uint32_t queue);
+	void Push(SJob&& job);
+	// runs one job from the thread's own queue, the main thread queue or another thread's queue
+	bool RunOne(uint32_t queue);
+	void Execute(SJob& job);
+	void ReleaseDeferred(const SJobCounter* dependency);
+
+	std::vector<std::thread> m_Threads;
+	// the attached thread's first, then one per worker
+	std::vector<std::unique_ptr<SJobQueue>> m_Queues;
+	SJobQueue m_MainThreadQueue;
+	std::thread::id m_MainThreadId;
+	// spreads the jobs of threads without a queue of their own over the others
+	std::atomic<uint32_t> m_NextQueue{ 0 };
+
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WorkAvailable;
+	// jobs in the thread queues, which the workers sleep on while it is zero
+	std::atomic<uint32_t> m_QueuedJobs{ 0 };
+	bool m_Quit = false;
+
+	std::mutex m_DeferredMutex;
+	std::vector<SDeferredJob> m_DeferredJobs;
+
+	std::atomic<uint64_t> m_Executed{ 0 };
+	std::atomic<uint64_t> m_Stolen{ 0 };
+	uint64_t m_LastExecuted = 0;
+	uint64_t m_LastStolen = 0;
+	SJobStats m_Stats;
+};
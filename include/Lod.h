@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Engine.h"
+
+const uint32_t kMaxMeshLods = 8;
+// screen-space error in pixels that an LOD may introduce at zero bias; every bias step doubles it
+const float kLodErrorPixels = 1.f;
+// an LOD switch needs the error to clear the threshold by this fraction, so that objects sitting on
+// a threshold do not flip between two LODs every frame
+const float kLodHysteresis = 0.25f;
+
+// one level of detail: a range of the mesh's shared index buffer
+struct SMeshLod
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	// object-space geometric error against LOD 0, non-decreasing from one LOD to the next
+	float Error;
+};
+
+struct SLodInput
+{
+	const SMeshLod* Lods;
+	uint32_t LodCount;
+	// world size of one object-space unit per object
+	const float* Scale;
+	// per object, read and updated; objects that are not visible keep their LOD
+	uint8_t* CurrentLods;
+	const uint32_t* Visible;
+	uint32_t VisibleCount;
+	// projected size of one world unit, in pixels
+	float PixelsPerUnit;
+	float Bias;
+};
+
+struct SLodStats
+{
+	uint32_t LodCount = 0;
+	uint32_t Instances[kMaxMeshLods] = {};
+	// indices drawn over all instances
+	uint64_t Indices = 0;
+};
+
+// picks the coarsest LOD whose projected error stays below the biased threshold for every visible object,
+// within the hysteresis band around its current LOD, then orders the visible objects by LOD with a counting
+// sort that keeps them ascending within each LOD; ordered must hold VisibleCount indices
+void SelectLods(const SLodInput& input, uint32_t* ordered, SLodStats& stats);
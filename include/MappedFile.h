@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// read-only memory mapping of a whole file
+class CMappedFile
+{
+public:
+	CMappedFile() = default;
+	~CMappedFile();
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile& operator=(const CMappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+	// hints the OS to start paging in a range that will be read soon
+	void Prefetch(size_t offset, size_t size) const;
+
+	bool IsOpen() const;
+	const uint8_t* GetData() const;
+	size_t GetSize() const;
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+};
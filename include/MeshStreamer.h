@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Engine.h"
+#include "Lod.h"
+#include "MappedFile.h"
+#include "RenderMemory.h"
+#include "RenderVulkan.h"
+#include "VertexLayout.h"
+
+class CRenderSync;
+class CRenderDeletionQueue;
+
+// .vkmesh layout (little endian): SMeshFileHeader, then the vertex data, index data and, from version 2 on,
+// an array of SMeshFileLod at the given offsets; version 1 files have a single LOD covering every index.
+// Version 3 records the vertex formats, older files are loaded but match no vertex layout
+const uint32_t kMeshFileMagic = 0x484D4B56; // "VKMH"
+const uint32_t kMeshFileVersion = 3;
+const uint32_t kMeshFileMaxVertexAttributes = 4;
+
+static_assert(kVertexAttributeCount <= kMeshFileMaxVertexAttributes, "the vertex formats must fit the mesh file header");
+
+// upload bandwidth per frame, meshes larger than this are spread over several frames
+const vk::DeviceSize kMeshStagingBytesPerFrame = 4ull << 20;
+
+const uint32_t kInvalidMesh = UINT32_MAX;
+
+struct SMeshFileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t VertexCount;
+	uint32_t VertexStride;
+	uint32_t IndexCount;
+	// bytes per index in the file, 2 or 4; the device buffer uses 16-bit indices whenever VertexCount allows it
+	uint32_t IndexSize;
+	uint64_t VertexOffset;
+	uint64_t IndexOffset;
+	// version 2
+	uint32_t LodCount;
+	// version 3: the EVertexFormat of every attribute in EVertexAttribute order, zero past kVertexAttributeCount
+	uint8_t VertexFormats[kMeshFileMaxVertexAttributes];
+	uint64_t LodOffset;
+};
+
+const size_t kMeshFileHeaderSizeV1 = offsetof(SMeshFileHeader, LodCount);
+
+struct SMeshFileLod
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	float Error;
+	uint32_t Reserved;
+};
+
+enum class EMeshState : uint8_t
+{
+	Loading = 0,
+	Ready,
+	Failed
+};
+
+struct SMeshStreamingStats
+{
+	uint32_t MeshCount = 0;
+	uint32_t UploadsInFlight = 0;
+	// staging bytes copied by the last frame
+	vk::DeviceSize UploadedBytes = 0;
+};
+
+// Loads meshes from memory-mapped files. Load maps the file and allocates the device buffers; Update then
+// copies the mapping straight into staging memory, at most kMeshStagingBytesPerFrame per frame, and the
+// mesh becomes drawable in the frame that records its last copy. Indices are checked against the vertex
+// count as they are copied, a mesh with one out of range fails instead.
+class CMeshStreamer
+{
+public:
+	EEngineStatus Initialize(vk::Device device, CRenderMemory* memory, CRenderSync* sync, CRenderDeletionQueue* deletionQueue);
+	void Shutdown();
+
+	// returns kInvalidMesh when the file cannot be mapped or its header is malformed
+	uint32_t Load(const std::string& path);
+	void Unload(uint32_t mesh);
+
+	// records this frame's copies, must be called outside of a render pass
+	void Update(vk::CommandBuffer commandBuffer);
+
+	EMeshState GetState(uint32_t mesh) const;
+	bool IsReady(uint32_t mesh) const;
+	uint32_t GetVertexStride(uint32_t mesh) const;
+	// true when the vertices were encoded with the layout's formats, a matching stride is not enough
+	bool HasVertexLayout(uint32_t mesh, const SVertexLayout& layout) const;
+	uint32_t GetIndexCount(uint32_t mesh) const;
+	const SMeshLod* GetLods(uint32_t mesh) const;
+	uint32_t GetLodCount(uint32_t mesh) const;
+	void Bind(vk::CommandBuffer commandBuffer, uint32_t mesh) const;
+	const SMeshStreamingStats& GetStats() const;
+private:
+	struct SBuffer
+	{
+		vk::Buffer Buffer;
+		vk::DeviceMemory Memory;
+	};
+
+	struct SMesh
+	{
+		bool InUse = false;
+		EMeshState State = EMeshState::Loading;
+		SMeshFileHeader Header;
+		std::string Path;
+		std::unique_ptr<CMappedFile> File;
+
+		SBuffer VertexBuffer;
+		SBuffer IndexBuffer;
+		vk::IndexType IndexType = vk::IndexType::eUint32;
+		SMeshLod Lods[kMaxMeshLods];
+		uint32_t LodCount = 0;
+
+		// bytes copied to the device buffers so far, vertex data first and index data after it
+		vk::DeviceSize UploadedBytes = 0;
+	};
+
+	bool CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, EMemoryCategory category, SBuffer& buffer);
+	void RetireBuffer(SBuffer& buffer);
+	void DestroyBuffer(SBuffer& buffer);
+	// copies as much of the mesh as the staging space allows, returns true once it is complete or has failed
+	bool UploadChunks(vk::CommandBuffer commandBuffer, SMesh& mesh);
+
+	vk::Device m_Device;
+	CRenderMemory* m_Memory = nullptr;
+	CRenderSync* m_Sync = nullptr;
+	CRenderDeletionQueue* m_DeletionQueue = nullptr;
+
+	vk::Buffer m_StagingBuffer;
+	vk::DeviceMemory m_StagingMemory;
+	uint8_t* m_StagingMapped = nullptr;
+	vk::DeviceSize m_StagingOffset = 0;
+
+	std::vector<SMesh> m_Meshes;
+	std::vector<uint32_t> m_FreeMeshes;
+	// meshes with an upload in progress, oldest first
+	std::deque<uint32_t> m_Uploads;
+
+	SMeshStreamingStats m_Stats;
+};
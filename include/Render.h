@@ -1,45 +1,114 @@
 #pragma once
 
 #include "Engine.h"
-
-#define VULKAN_HPP_NO_EXCEPTIONS
-#define VULKAN_HPP_ASSERT(e)
-#include "vulkan/vulkan.hpp"
+#include "RenderVulkan.h"
+#include "RenderProfiler.h"
+#include "RenderMemory.h"
+#include "RenderSync.h"
+#include "RenderBindless.h"
+#include "RenderDescriptors.h"
+#include "RenderDeletionQueue.h"
+#include "RenderGraph.h"
+#include "TextureStreamer.h"
+#include "MeshStreamer.h"
+#include "VertexLayout.h"
+#include "Scene.h"
+#include "Culling.h"
+#include "Lod.h"
+#include "DynamicResolution.h"
 
 const vk::ApplicationInfo kRenderApplicationInfo = {
 	"VkLearn",
 	0,
 	"VkLearnEngine",
 	0,
-	VK_API_VERSION_1_0
+	// the highest version the renderer uses; lowered at startup to what the loader supports
+	VK_API_VERSION_1_2
 };
 
-const uint32_t kVendorIdNvidia = 0x10de;
-const uint32_t kVendorIdAmd = 0x1002;
+// time in seconds for the actual rotation speed to cover ~63% of the way to the requested speed
+const float kRotationSpeedTimeConstant = 2.f;
+
+// descriptor sets the ImGui backend may allocate from its pool
+const uint32_t kImGuiDescriptorSets = 16;
+
+// weight of the newest frame in the smoothed latency estimate
+const float kLatencySmoothing = 0.05f;
+
+struct SLatencyStats
+{
+	// from the pump of the newest event the frame handled, or from its input sample without one, to its
+	// submission
+	float InputToSubmitMs = 0.f;
+	// from there to the GPU finishing the frame, which adds the frames queued ahead of it and
+	// the last measured GPU frame time; smoothed
+	float EstimatedMs = 0.f;
+};
 
 class CRender
 {
 public:
 	EEngineStatus Initialize();
-	EEngineStatus Update(float deltaTime);
+	// advances the simulation by one fixed tick
+	void Simulate(float timeStep);
+	// in low-latency mode, waits until the GPU has finished the previous frame; called before the frame
+	// samples its input, so that the CPU never runs ahead of the GPU
+	EEngineStatus Throttle();
+	// renders a frame, interpolating the simulated state between the last two ticks
+	EEngineStatus Update(float interpolation);
 	EEngineStatus Shutdown();
 	const char* GetGpuName() const;
 	float GetAngle() const;
 	void ResetAngle();
+	CRenderProfiler* GetProfiler();
+	const CRenderProfiler* GetProfiler() const;
+	const CRenderMemory* GetMemory() const;
+	CRenderSync* GetSync();
+	// nullptr when descriptor indexing is unavailable or disabled
+	CRenderBindless* GetBindless();
+	CTextureStreamer* GetTextureStreamer();
+	const CTextureStreamer* GetTextureStreamer() const;
+	CScene* GetScene();
+	const CScene* GetScene() const;
+	const CFrustumCuller* GetCuller() const;
+	const SLodStats& GetLodStats() const;
+	uint32_t GetSampleCount() const;
+	const CRenderGraph* GetRenderGraph() const;
+	CRenderDescriptors* GetDescriptors();
+	const CRenderDescriptors* GetDescriptors() const;
+	const CRenderDescriptorCache* GetDescriptorCache() const;
+	const CRenderDeletionQueue* GetDeletionQueue() const;
+	const SLatencyStats& GetLatencyStats() const;
+	// nullptr when dynamic resolution is disabled
+	const CDynamicResolution* GetDynamicResolution() const;
+	CMeshStreamer* GetMeshStreamer();
+	const CMeshStreamer* GetMeshStreamer() const;
 
 	float m_RotationSpeed = 5.f;
+	// log2 of the screen-space error threshold scale, positive values switch to coarser LODs earlier
+	float m_LodBias = 0.f;
+	// see SEngineOptions::LowLatency
+	bool m_LowLatency = false;
+	// GPU frame time the scene resolution is adjusted to with dynamic resolution, zero for the full resolution
+	float m_DynamicResolutionTargetMs = 0.f;
 private:
 	bool m_ShowDemoWindow = true;
 	float m_ActualRotationSpeed = m_RotationSpeed;
 	float m_Angle = 0.f;
+	float m_PreviousAngle = 0.f;
 	std::string m_GpuName;
+	SLatencyStats m_LatencyStats;
 
 	EEngineStatus LoadShadersTriangle();
+	EEngineStatus CreateUpscalePipeline();
+	void RecordScenePass(vk::CommandBuffer commandBuffer, uint32_t frameSlot, uint32_t imageIndex);
+	void RecordUpscalePass(vk::CommandBuffer commandBuffer, uint32_t frameSlot, uint32_t imageIndex);
 	uint32_t FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
 	
 	vk::DispatchLoaderDynamic m_DispatchLoader;
 	
 	vk::Instance m_Instance;
+	bool m_HasPhysicalDeviceProperties2 = false;
 #ifdef _DEBUG
 	vk::DebugReportCallbackEXT m_DebugReportCallback;
 #endif
@@ -52,31 +121,81 @@ private:
 	vk::Extent2D m_SwapChainExtent;
 	vk::SwapchainKHR m_SwapChain;
 	std::vector<vk::ImageView> m_SwapChainImageViews;
-	vk::RenderPass m_RenderPass1;
-	vk::RenderPass m_RenderPassImGui;
-	std::vector<vk::Framebuffer> m_SwapChainFrameBuffers;
+	// owns the render passes, framebuffers and transient attachments of the frame
+	CRenderGraph m_RenderGraph;
+	uint32_t m_ScenePass = kInvalidRenderGraphPass;
+	uint32_t m_ImGuiPass = kInvalidRenderGraphPass;
+	// with dynamic resolution the scene renders into part of an offscreen image, which the upscale pass
+	// stretches over the swap chain image before the UI is drawn at the output resolution
+	bool m_UseDynamicResolution = false;
+	CDynamicResolution m_DynamicResolution;
+	uint32_t m_UpscalePass = kInvalidRenderGraphPass;
+	uint32_t m_SceneOutput = kInvalidRenderGraphResource;
+	// the part of the scene attachments rendered this frame, the swap chain extent without dynamic resolution
+	vk::Extent2D m_SceneExtent;
+	// scene pass samples per pixel, from --msaa clamped to what the device supports
+	vk::SampleCountFlagBits m_SampleCount = vk::SampleCountFlagBits::e1;
+	vk::Format m_DepthFormat = vk::Format::eD16Unorm;
 	vk::CommandPool m_CommandPool;
-	std::vector<vk::CommandBuffer> m_CommandBuffers;
-	std::vector<vk::CommandBuffer> m_CommandBuffersImGui;
+	// one per frame slot, re-recorded every frame
+	vk::CommandBuffer m_CommandBuffers[kMaxFramesInFlight];
 	vk::PipelineLayout m_PipelineLayout;
 	vk::Pipeline m_Pipeline;
+	vk::DescriptorSetLayout m_UpscaleSetLayout;
+	vk::PipelineLayout m_UpscalePipelineLayout;
+	vk::Pipeline m_UpscalePipeline;
+	vk::Sampler m_UpscaleSampler;
 
-	vk::Buffer m_UniformBuffer;
-	vk::DeviceMemory m_UniformBufferMemory;
-	vk::DescriptorPool m_DescriptorPool;
-	vk::DescriptorSet m_DescriptorSet;
+	// one uniform buffer per frame slot so that the CPU never writes one the GPU is still reading
+	vk::Buffer m_UniformBuffers[kMaxFramesInFlight];
+	vk::DeviceMemory m_UniformBufferMemory[kMaxFramesInFlight];
+	void* m_UniformBufferMapped[kMaxFramesInFlight] = {};
+	CRenderDescriptors m_Descriptors;
+	CRenderDescriptorCache m_DescriptorCache;
+	// table indices of the uniform buffers on the bindless path
+	uint32_t m_UniformBufferIndices[kMaxFramesInFlight] = { kBindlessInvalidIndex, kBindlessInvalidIndex };
 	vk::DescriptorSetLayout m_DescriptorSetLayout;
 
+	// selected with --vertex-layout, shared by the triangle and the scene mesh
+	SVertexLayout m_VertexLayout = kVertexLayouts[0];
 	vk::Buffer m_VertexBuffer;
 	vk::DeviceMemory m_VertexBufferMemory;
 	vk::Buffer m_IndexBuffer;
+	// chosen from the vertex count by SelectIndexType
+	vk::IndexType m_IndexType = vk::IndexType::eUint32;
 	vk::DeviceMemory m_IndexBufferMemory;
 
-	/* SEMAPHORES */
-	vk::Semaphore m_ImageAvailableSemaphore;
-	vk::Semaphore m_RenderFinished1Semaphore;
-	vk::Semaphore m_RenderFinished2Semaphore;
+	CScene m_Scene;
+	// per frame slot, kSceneStreamCount arrays of m_InstanceStreamCapacity floats each
+	vk::Buffer m_InstanceBuffers[kMaxFramesInFlight];
+	vk::DeviceMemory m_InstanceBufferMemory[kMaxFramesInFlight];
+	float* m_InstanceBufferMapped[kMaxFramesInFlight] = {};
+	uint32_t m_InstanceStreamCapacity = 0;
+	CFrustumCuller m_Culler;
+	// ascending indices of this frame's visible objects, the instance streams follow this order
+	std::vector<uint32_t> m_VisibleObjects;
+	uint32_t m_VisibleObjectCount = 0;
+	// the visible objects grouped by LOD
+	std::vector<uint32_t> m_LodOrderedObjects;
+	SLodStats m_LodStats;
+	bool m_DrawSceneMesh = false;
+
+	CRenderSync m_Sync;
+	// resources released mid-run are destroyed through it once the GPU is done with them
+	CRenderDeletionQueue m_DeletionQueue;
+	CRenderBindless m_Bindless;
+	bool m_UseBindless = false;
+	CTextureStreamer m_TextureStreamer;
+	CMeshStreamer m_MeshStreamer;
+	// mesh given with --mesh, drawn instead of the triangle once it is ready
+	uint32_t m_SceneMesh = kInvalidMesh;
+	// texture given with --texture, sampled by the scene once its mip tail is resident
+	uint32_t m_SceneTexture = kInvalidTexture;
+	CRenderProfiler m_Profiler;
+	CRenderMemory m_Memory;
 
 	vk::ShaderModule m_TriangleVS;
 	vk::ShaderModule m_TriangleFS;
+	vk::ShaderModule m_UpscaleVS;
+	vk::ShaderModule m_UpscaleFS;
 };
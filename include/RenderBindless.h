@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+class CRenderSync;
+
+// upper bounds of the table, clamped to the device's update-after-bind limits
+const uint32_t kBindlessMaxTextures = 16384;
+const uint32_t kBindlessMaxBuffers = 4096;
+
+const uint32_t kBindlessTextureBinding = 0;
+const uint32_t kBindlessBufferBinding = 1;
+
+const uint32_t kBindlessInvalidIndex = UINT32_MAX;
+
+// per-draw resource indices, must match DrawConstants in shaders/bindless.glsli
+struct SBindlessDrawConstants
+{
+	uint32_t UniformBuffer = kBindlessInvalidIndex;
+	uint32_t MaterialBuffer = kBindlessInvalidIndex;
+	uint32_t BaseColorTexture = kBindlessInvalidIndex;
+	uint32_t Flags = 0;
+};
+
+// A single descriptor set holding every sampled image and storage buffer of the renderer as
+// partially bound update-after-bind arrays. The set is bound once per command buffer and draws
+// select their resources through SBindlessDrawConstants.
+class CRenderBindless
+{
+public:
+	// the descriptor indexing features the table needs, to be chained into device creation
+	static vk::PhysicalDeviceDescriptorIndexingFeatures GetRequiredFeatures();
+	static bool IsSupported(const vk::PhysicalDeviceDescriptorIndexingFeatures& supportedFeatures);
+
+	EEngineStatus Initialize(vk::PhysicalDevice physicalDevice, vk::Device device, CRenderSync* sync, const vk::DispatchLoaderDynamic* dispatchLoader);
+	void Shutdown();
+
+	// returns kBindlessInvalidIndex when the table is full
+	uint32_t RegisterTexture(vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal);
+	uint32_t RegisterBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+	// the slot is reused once the frames that could still reference it have finished
+	void ReleaseTexture(uint32_t index);
+	void ReleaseBuffer(uint32_t index);
+
+	void Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, uint32_t firstSet) const;
+	void PushDrawConstants(vk::CommandBuffer commandBuffer, vk::PipelineLayout pipelineLayout, const SBindlessDrawConstants& constants) const;
+
+	vk::DescriptorSetLayout GetSetLayout() const;
+	vk::PushConstantRange GetPushConstantRange() const;
+	uint32_t GetTextureCapacity() const;
+	uint32_t GetBufferCapacity() const;
+	uint32_t GetTextureCount() const;
+	uint32_t GetBufferCount() const;
+private:
+	struct SRetiredIndex
+	{
+		uint32_t Index;
+		uint64_t Frame;
+	};
+
+	struct SIndexAllocator
+	{
+		uint32_t Capacity = 0;
+		uint32_t Next = 0;
+		std::vector<uint32_t> Free;
+		std::vector<SRetiredIndex> Retired;
+
+		uint32_t Allocate();
+		uint32_t GetCount() const;
+	};
+
+	void RecycleRetired(SIndexAllocator& allocator);
+
+	vk::Device m_Device;
+	CRenderSync* m_Sync = nullptr;
+
+	vk::DescriptorSetLayout m_SetLayout;
+	vk::DescriptorPool m_Pool;
+	vk::DescriptorSet m_Set;
+
+	SIndexAllocator m_Textures;
+	SIndexAllocator m_Buffers;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstring>
+#include <deque>
+
+#include "Engine.h"
+#include "RenderSync.h"
+#include "RenderVulkan.h"
+
+class CRenderMemory;
+class CRenderDescriptorCache;
+
+enum class EDeletionType : uint8_t
+{
+	Buffer = 0,
+	BufferView,
+	Image,
+	ImageView,
+	Sampler,
+	Memory,
+	Framebuffer,
+	RenderPass,
+	Pipeline,
+	PipelineLayout,
+	DescriptorSetLayout,
+	DescriptorPool,
+	ShaderModule,
+	Count
+};
+
+const uint32_t kDeletionTypeCount = static_cast<uint32_t>(EDeletionType::Count);
+
+struct SDeletionQueueStats
+{
+	uint32_t Pending = 0;
+	// destroyed by the last Update
+	uint32_t Destroyed = 0;
+	uint64_t TotalDestroyed = 0;
+};
+
+// Destroys GPU resources once the GPU is done with them, so that they can be released mid-run without
+// waiting for the device to go idle. Every request is tagged with the frame being recorded, or with a
+// queue value for work submitted outside of the frame, and executed by the first Update that finds it
+// complete. Requests run in the order they were made, so an image queued before its memory is destroyed
+// first. Buffers, image views and samplers are evicted from the descriptor cache when they are queued.
+class CRenderDeletionQueue
+{
+public:
+	EEngineStatus Initialize(vk::Device device, CRenderMemory* memory, CRenderSync* sync, CRenderDescriptorCache* descriptorCache);
+	// destroys everything still queued; the caller has waited for the device to go idle
+	void Shutdown();
+
+	// must follow CRenderSync::BeginFrame, once per frame
+	void Update();
+
+	// destroyed once the frame being recorded has finished; null handles are ignored
+	template <typename THandle>
+	void Destroy(THandle handle)
+	{
+		if (handle)
+		{
+			Invalidate(handle);
+			Push(m_FrameEntries, m_Sync->GetFrame(), GetType(handle), ToValue(handle));
+		}
+	}
+
+	// destroyed once the queue has reached the value. Entries of a queue run in order, so a value older
+	// than one queued before it waits for that one as well
+	template <typename THandle>
+	void DestroyAfter(ERenderQueue queue, uint64_t value, THandle handle)
+	{
+		if (handle)
+		{
+			Invalidate(handle);
+			Push(m_QueueEntries[static_cast<uint32_t>(queue)], value, GetType(handle), ToValue(handle));
+		}
+	}
+
+	const SDeletionQueueStats& GetStats() const;
+private:
+	struct SEntry
+	{
+		EDeletionType Type;
+		uint64_t Handle;
+		// frame number or queue value the entry waits for
+		uint64_t Value;
+	};
+
+	template <typename THandle>
+	static uint64_t ToValue(THandle handle)
+	{
+		static_assert(sizeof(THandle) <= sizeof(uint64_t), "handles must fit in 64 bits");
+		uint64_t value = 0;
+		std::memcpy(&value, &handle, sizeof(handle));
+		return value;
+	}
+
+	static EDeletionType GetType(vk::Buffer) { return EDeletionType::Buffer; }
+	static EDeletionType GetType(vk::BufferView) { return EDeletionType::BufferView; }
+	static EDeletionType GetType(vk::Image) { return EDeletionType::Image; }
+	static EDeletionType GetType(vk::ImageView) { return EDeletionType::ImageView; }
+	static EDeletionType GetType(vk::Sampler) { return EDeletionType::Sampler; }
+	static EDeletionType GetType(vk::DeviceMemory) { return EDeletionType::Memory; }
+	static EDeletionType GetType(vk::Framebuffer) { return EDeletionType::Framebuffer; }
+	static EDeletionType GetType(vk::RenderPass) { return EDeletionType::RenderPass; }
+	static EDeletionType GetType(vk::Pipeline) { return EDeletionType::Pipeline; }
+	static EDeletionType GetType(vk::PipelineLayout) { return EDeletionType::PipelineLayout; }
+	static EDeletionType GetType(vk::DescriptorSetLayout) { return EDeletionType::DescriptorSetLayout; }
+	static EDeletionType GetType(vk::DescriptorPool) { return EDeletionType::DescriptorPool; }
+	static EDeletionType GetType(vk::ShaderModule) { return EDeletionType::ShaderModule; }
+
+	// only the resource types descriptor sets can reference are cached
+	template <typename THandle>
+	void Invalidate(THandle)
+	{
+	}
+	void Invalidate(vk::Buffer buffer);
+	void Invalidate(vk::ImageView imageView);
+	void Invalidate(vk::Sampler sampler);
+
+	void Push(std::deque<SEntry>& entries, uint64_t value, EDeletionType type, uint64_t handle);
+	void Execute(const SEntry& entry);
+
+	vk::Device m_Device;
+	CRenderMemory* m_Memory = nullptr;
+	CRenderSync* m_Sync = nullptr;
+	CRenderDescriptorCache* m_DescriptorCache = nullptr;
+
+	// oldest first; frame numbers only grow, so the front is always the first to complete
+	std::deque<SEntry> m_FrameEntries;
+	std::deque<SEntry> m_QueueEntries[kRenderQueueCount];
+	SDeletionQueueStats m_Stats;
+};
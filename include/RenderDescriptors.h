@@ -0,0 +1,171 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Engine.h"
+#include "RenderSync.h"
+#include "RenderVulkan.h"
+
+// sets in the first pool of a chain; every new pool doubles that, up to the maximum
+const uint32_t kDescriptorPoolInitialSets = 64;
+const uint32_t kDescriptorPoolMaxSets = 4096;
+
+// descriptors of a type a pool reserves per set; a layout with a type missing here can never be allocated
+struct SDescriptorPoolRatio
+{
+	vk::DescriptorType Type;
+	float PerSet;
+};
+
+const SDescriptorPoolRatio kDescriptorPoolRatios[] = {
+	{ vk::DescriptorType::eUniformBuffer, 2.f },
+	{ vk::DescriptorType::eUniformBufferDynamic, 1.f },
+	{ vk::DescriptorType::eStorageBuffer, 2.f },
+	{ vk::DescriptorType::eStorageBufferDynamic, 1.f },
+	{ vk::DescriptorType::eUniformTexelBuffer, 1.f },
+	{ vk::DescriptorType::eStorageTexelBuffer, 1.f },
+	{ vk::DescriptorType::eCombinedImageSampler, 4.f },
+	{ vk::DescriptorType::eSampledImage, 2.f },
+	{ vk::DescriptorType::eStorageImage, 1.f },
+	{ vk::DescriptorType::eSampler, 1.f },
+	{ vk::DescriptorType::eInputAttachment, 1.f }
+};
+
+struct SDescriptorStats
+{
+	uint32_t StaticPools = 0;
+	uint32_t FramePools = 0;
+	uint32_t StaticSets = 0;
+	// sets allocated from the current frame slot's pools so far
+	uint32_t FrameSets = 0;
+};
+
+// Allocates descriptor sets from chains of pools. A chain allocates from its newest pool and moves on to
+// the next one, creating it if needed, when that pool runs out, so an allocation only fails when the
+// device is out of memory or the layout does not fit even a fresh pool. Static sets live as long as the
+// allocator. Frame sets come from the current frame slot's chain, which is reset in bulk when the slot
+// is reused, so they are valid for one frame.
+class CRenderDescriptors
+{
+public:
+	EEngineStatus Initialize(vk::Device device);
+	void Shutdown();
+
+	// must follow CRenderSync::BeginFrame, which guarantees the slot's previous frame has finished
+	void BeginFrame(uint32_t frameSlot);
+
+	// return null when the device is out of memory or the layout needs more descriptors than a pool holds
+	vk::DescriptorSet AllocateStatic(vk::DescriptorSetLayout layout);
+	vk::DescriptorSet AllocateFrame(vk::DescriptorSetLayout layout);
+
+	// a pool outside of the chains, for code that manages its own sets such as the ImGui backend
+	vk::DescriptorPool CreateDedicatedPool(uint32_t maxSets);
+
+	const SDescriptorStats& GetStats() const;
+private:
+	struct SPoolChain
+	{
+		std::vector<vk::DescriptorPool> Pools;
+		// the pool allocations are made from, the ones after it are empty
+		uint32_t Current = 0;
+	};
+
+	vk::DescriptorSet Allocate(SPoolChain& chain, vk::DescriptorSetLayout layout);
+	vk::DescriptorPool CreatePool(uint32_t maxSets, vk::DescriptorPoolCreateFlags flags);
+
+	vk::Device m_Device;
+	SPoolChain m_StaticChain;
+	SPoolChain m_FrameChains[kMaxFramesInFlight];
+	uint32_t m_FrameSlot = 0;
+	uint32_t m_NextPoolSets = kDescriptorPoolInitialSets;
+	std::vector<vk::DescriptorPool> m_DedicatedPools;
+	SDescriptorStats m_Stats;
+};
+
+// one descriptor of a cached set; only the fields of the descriptor type are read
+struct SDescriptorBinding
+{
+	uint32_t Binding = 0;
+	vk::DescriptorType Type = vk::DescriptorType::eUniformBuffer;
+	vk::Buffer Buffer;
+	vk::DeviceSize Offset = 0;
+	vk::DeviceSize Range = VK_WHOLE_SIZE;
+	vk::ImageView ImageView;
+	vk::Sampler Sampler;
+	vk::ImageLayout ImageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+};
+
+struct SDescriptorCacheStats
+{
+	uint32_t Sets = 0;
+	uint32_t Hits = 0;
+	uint32_t Misses = 0;
+	uint32_t Evictions = 0;
+};
+
+// Hands out one descriptor set per layout and set of bound resources, written once on the first request.
+// Sets that reference a destroyed resource are evicted and, once the frames that used them have finished,
+// rewritten for later misses with the same layout instead of being allocated anew.
+class CRenderDescriptorCache
+{
+public:
+	EEngineStatus Initialize(vk::Device device, CRenderDescriptors* descriptors, CRenderSync* sync);
+	void Shutdown();
+
+	// recycles the evicted sets whose frames have finished, once per frame
+	void Update();
+
+	// returns null when no set can be allocated
+	vk::DescriptorSet Get(vk::DescriptorSetLayout layout, const SDescriptorBinding* bindings, uint32_t bindingCount);
+
+	// evicts every set that references the resource, to be called when it is destroyed
+	void Invalidate(vk::Buffer buffer);
+	void Invalidate(vk::ImageView imageView);
+	void Invalidate(vk::Sampler sampler);
+
+	const SDescriptorCacheStats& GetStats() const;
+private:
+	struct SEntry
+	{
+		vk::DescriptorSetLayout Layout;
+		std::vector<SDescriptorBinding> Bindings;
+		vk::DescriptorSet Set;
+		uint64_t Hash = 0;
+		uint64_t LastFrame = 0;
+		// bumped on eviction, so that stale references from m_ResourceEntries are ignored
+		uint32_t Generation = 0;
+		bool Alive = false;
+	};
+
+	struct SEntryReference
+	{
+		uint32_t Entry;
+		uint32_t Generation;
+	};
+
+	struct SRetiredSet
+	{
+		vk::DescriptorSetLayout Layout;
+		vk::DescriptorSet Set;
+		uint64_t Frame;
+	};
+
+	void InvalidateHandle(uint64_t handle);
+	void Evict(uint32_t index);
+
+	vk::Device m_Device;
+	CRenderDescriptors* m_Descriptors = nullptr;
+	CRenderSync* m_Sync = nullptr;
+
+	std::vector<SEntry> m_Entries;
+	std::vector<uint32_t> m_FreeEntries;
+	// entries by the hash of their layout and bindings
+	std::unordered_multimap<uint64_t, uint32_t> m_Lookup;
+	// entries by the handles of the resources they reference
+	std::unordered_map<uint64_t, std::vector<SEntryReference>> m_ResourceEntries;
+	std::vector<SRetiredSet> m_RetiredSets;
+	// recycled sets by the handle of their layout
+	std::unordered_multimap<uint64_t, vk::DescriptorSet> m_FreeSets;
+	SDescriptorCacheStats m_Stats;
+};
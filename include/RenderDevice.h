@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+const uint32_t kVendorIdNvidia = 0x10de;
+const uint32_t kVendorIdAmd = 0x1002;
+const uint32_t kVendorIdIntel = 0x8086;
+
+struct SPhysicalDeviceCandidate
+{
+	vk::PhysicalDevice Device;
+	uint32_t Index = 0;
+	std::string Name;
+	vk::PhysicalDeviceType Type = vk::PhysicalDeviceType::eOther;
+	uint32_t GraphicsFamily = 0;
+	bool Suitable = false;
+	// why the device was rejected, empty for suitable devices
+	std::string RejectReason;
+	int64_t Score = 0;
+};
+
+// checks the hard requirements of a device and scores it by type, device-local memory, queue topology,
+// limits and optional extensions; software (CPU) devices are rejected unless preferSoftware is set,
+// in which case they are ranked above hardware devices
+SPhysicalDeviceCandidate EvaluatePhysicalDevice(vk::PhysicalDevice physicalDevice, uint32_t index, vk::SurfaceKHR surface, const vk::DispatchLoaderDynamic& dispatchLoader, bool preferSoftware);
+
+// picks the device requested on the command line (index or case-insensitive name substring) or the
+// highest-scoring suitable one; returns nullptr when nothing matches
+const SPhysicalDeviceCandidate* SelectPhysicalDevice(const std::vector<SPhysicalDeviceCandidate>& candidates, const std::string& request);
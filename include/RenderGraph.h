@@ -0,0 +1,179 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Engine.h"
+#include "RenderMemory.h"
+#include "RenderVulkan.h"
+
+const uint32_t kInvalidRenderGraphResource = UINT32_MAX;
+const uint32_t kInvalidRenderGraphPass = UINT32_MAX;
+
+// how a pass uses a resource; the graph derives stages, access masks, image layouts and usage flags from it
+enum class ERenderGraphAccess : uint8_t
+{
+	ColorAttachment = 0,
+	DepthAttachment,
+	ResolveAttachment,
+	Sampled,
+	StorageRead,
+	StorageWrite,
+	TransferRead,
+	TransferWrite,
+	Count
+};
+
+struct SRenderGraphImageDesc
+{
+	vk::Format Format;
+	vk::Extent2D Extent;
+	vk::SampleCountFlagBits Samples = vk::SampleCountFlagBits::e1;
+};
+
+struct SRenderGraphStats
+{
+	uint32_t PassCount = 0;
+	uint32_t CulledPassCount = 0;
+	uint32_t TransientCount = 0;
+	// transient images backed by lazily allocated memory, which neither count nor alias
+	uint32_t LazyCount = 0;
+	// transient memory if every resource had its own allocation, and what aliasing brought it down to
+	vk::DeviceSize TransientBytes = 0;
+	vk::DeviceSize AllocatedBytes = 0;
+	uint32_t BarrierCount = 0;
+};
+
+// Describes one frame as passes that declare the resources they read and write. Compile culls the passes
+// whose results nothing uses, creates the transient resources and aliases those whose lifetimes do not
+// overlap onto shared memory, and turns every hazard into a subpass dependency, a render pass layout
+// transition or a pipeline barrier. A pass uses every resource at most once. The frame is then recorded by
+// bracketing every pass, in declaration order, with BeginPass and EndPass.
+class CRenderGraph
+{
+public:
+	EEngineStatus Initialize(vk::PhysicalDevice physicalDevice, vk::Device device, CRenderMemory* memory);
+	void Shutdown();
+
+	// an image owned outside of the graph, e.g. the swap chain; imageIndex in BeginPass picks the view.
+	// Imported images may only be used as attachments, their contents are undefined at the start of the
+	// frame, and the first pass that uses them waits for initialStages
+	uint32_t ImportImage(const char* name, vk::Format format, vk::Extent2D extent, const std::vector<vk::ImageView>& views, vk::PipelineStageFlags initialStages, vk::ImageLayout finalLayout);
+	uint32_t CreateImage(const char* name, const SRenderGraphImageDesc& desc);
+	uint32_t CreateBuffer(const char* name, vk::DeviceSize size);
+
+	uint32_t AddPass(const char* name);
+	// loading the previous contents makes the pass a reader of the image as well; the optional resolve
+	// image receives the resolved color at the end of the pass
+	void AddColorAttachment(uint32_t pass, uint32_t image, vk::AttachmentLoadOp loadOp, const vk::ClearColorValue& clearColor = {}, uint32_t resolveImage = kInvalidRenderGraphResource);
+	void SetDepthAttachment(uint32_t pass, uint32_t image, vk::AttachmentLoadOp loadOp, const vk::ClearDepthStencilValue& clearValue = {});
+	// shader and transfer accesses, synchronized with a pipeline barrier before the pass begins
+	void AddAccess(uint32_t pass, uint32_t resource, ERenderGraphAccess access, vk::PipelineStageFlags shaderStages = vk::PipelineStageFlagBits::eFragmentShader);
+	// keeps a pass that writes nothing the frame uses, e.g. a readback
+	void SetSideEffects(uint32_t pass);
+
+	EEngineStatus Compile();
+
+	// returns false for a culled pass, which must then not be recorded. A non-zero renderExtent limits the
+	// render area to the top left corner of the attachments, e.g. for a scene rendered at a lower resolution
+	bool BeginPass(vk::CommandBuffer commandBuffer, uint32_t pass, uint32_t imageIndex, vk::Extent2D renderExtent = {}) const;
+	void EndPass(vk::CommandBuffer commandBuffer, uint32_t pass) const;
+
+	// null for passes without attachments and for culled passes
+	vk::RenderPass GetRenderPass(uint32_t pass) const;
+	vk::Image GetImage(uint32_t resource) const;
+	vk::ImageView GetImageView(uint32_t resource) const;
+	vk::Buffer GetBuffer(uint32_t resource) const;
+	const SRenderGraphStats& GetStats() const;
+private:
+	struct SResource
+	{
+		std::string Name;
+		bool IsImage = true;
+		bool Imported = false;
+		SRenderGraphImageDesc Desc;
+		vk::DeviceSize Size = 0;
+		std::vector<vk::ImageView> ImportedViews;
+		vk::PipelineStageFlags InitialStages;
+		vk::ImageLayout FinalLayout = vk::ImageLayout::eUndefined;
+
+		// filled in by Compile
+		vk::ImageUsageFlags ImageUsage;
+		vk::BufferUsageFlags BufferUsage;
+		vk::Image Image;
+		vk::ImageView View;
+		vk::Buffer Buffer;
+		vk::MemoryRequirements Requirements;
+		// only for lazily allocated images, the others are placed in a shared heap
+		vk::DeviceMemory DedicatedMemory;
+		uint32_t Heap = UINT32_MAX;
+		vk::DeviceSize Offset = 0;
+		uint32_t FirstPass = UINT32_MAX;
+		uint32_t LastPass = 0;
+		// accesses of the resource's last use in the frame, which the next frame's first use waits for
+		vk::PipelineStageFlags LastStages;
+		vk::AccessFlags LastAccess;
+	};
+
+	struct SAccess
+	{
+		uint32_t Resource;
+		ERenderGraphAccess Access;
+		vk::PipelineStageFlags Stages;
+		vk::AttachmentLoadOp LoadOp = vk::AttachmentLoadOp::eDontCare;
+		vk::ClearValue ClearValue;
+		// for color attachments, the index of the resolve access in the pass
+		uint32_t Resolve = UINT32_MAX;
+		// filled in by Compile: for attachments, the layout the render pass leaves the image in
+		vk::ImageLayout FinalLayout = vk::ImageLayout::eUndefined;
+	};
+
+	struct SPass
+	{
+		std::string Name;
+		std::vector<SAccess> Accesses;
+		bool SideEffects = false;
+
+		// filled in by Compile
+		bool Culled = false;
+		vk::RenderPass RenderPass;
+		// one per view of the imported images the pass renders to
+		std::vector<vk::Framebuffer> FrameBuffers;
+		vk::Extent2D Extent;
+		std::vector<vk::ClearValue> ClearValues;
+		vk::PipelineStageFlags BarrierSrcStages;
+		vk::PipelineStageFlags BarrierDstStages;
+		vk::MemoryBarrier MemoryBarrier;
+		std::vector<vk::ImageMemoryBarrier> ImageBarriers;
+	};
+
+	struct SHeap
+	{
+		uint32_t MemoryType;
+		vk::DeviceSize Size;
+		vk::DeviceMemory Memory;
+	};
+
+	// one use of a resource by a pass that survived culling
+	struct SUse
+	{
+		uint32_t Pass;
+		uint32_t Access;
+	};
+
+	void CullPasses();
+	EEngineStatus CreateResources();
+	void PlaceResources();
+	EEngineStatus CreateRenderPass(uint32_t pass, const std::vector<std::vector<SUse>>& uses);
+	void CreateBarriers(uint32_t pass, const std::vector<std::vector<SUse>>& uses);
+	bool SharesMemory(const SResource& a, const SResource& b) const;
+
+	vk::Device m_Device;
+	CRenderMemory* m_Memory = nullptr;
+	vk::DeviceSize m_BufferImageGranularity = 1;
+
+	std::vector<SResource> m_Resources;
+	std::vector<SPass> m_Passes;
+	std::vector<SHeap> m_Heaps;
+	SRenderGraphStats m_Stats;
+};
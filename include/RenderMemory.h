@@ -0,0 +1,81 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+enum class EMemoryCategory : uint8_t
+{
+	Uniform = 0,
+	Vertex,
+	Index,
+	Staging,
+	Texture,
+	RenderTarget,
+	Other,
+	Count
+};
+
+const uint32_t kMemoryCategoryCount = static_cast<uint32_t>(EMemoryCategory::Count);
+const char* const kMemoryCategoryNames[kMemoryCategoryCount] = { "Uniform", "Vertex", "Index", "Staging", "Texture", "Render target", "Other" };
+
+// fraction of a heap budget after which the heap is reported as running low
+const float kMemoryBudgetWarningThreshold = 0.9f;
+
+struct SMemoryHeapInfo
+{
+	vk::DeviceSize Size = 0;
+	vk::DeviceSize Budget = 0;
+	vk::DeviceSize Usage = 0;
+	vk::DeviceSize PeakUsage = 0;
+	vk::DeviceSize TrackedUsage = 0;
+	bool DeviceLocal = false;
+};
+
+class CRenderMemory
+{
+public:
+	void Initialize(vk::PhysicalDevice physicalDevice, vk::Device device, bool hasMemoryBudget, const vk::DispatchLoaderDynamic* dispatchLoader);
+	void Shutdown();
+
+	vk::Result Allocate(const vk::MemoryAllocateInfo& allocateInfo, EMemoryCategory category, vk::DeviceMemory& memory);
+	void Free(vk::DeviceMemory memory);
+	// returns UINT32_MAX when no memory type matches
+	uint32_t FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+	uint32_t GetMemoryTypeHeap(uint32_t memoryType) const;
+	// refreshes the per-heap budget and usage
+	void Update();
+
+	bool HasMemoryBudget() const;
+	uint32_t GetHeapCount() const;
+	const SMemoryHeapInfo& GetHeapInfo(uint32_t heap) const;
+	bool IsHeapLow(uint32_t heap) const;
+	uint32_t GetAllocationCount() const;
+	uint32_t GetMaxAllocationCount() const;
+	vk::DeviceSize GetCategoryBytes(EMemoryCategory category) const;
+	vk::DeviceSize GetTrackedBytes() const;
+	vk::DeviceSize GetPeakTrackedBytes() const;
+private:
+	struct SAllocation
+	{
+		vk::DeviceSize Size;
+		uint32_t Heap;
+		EMemoryCategory Category;
+	};
+
+	vk::PhysicalDevice m_PhysicalDevice;
+	vk::Device m_Device;
+	const vk::DispatchLoaderDynamic* m_DispatchLoader = nullptr;
+	bool m_HasMemoryBudget = false;
+
+	vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+	uint32_t m_MaxAllocationCount = 0;
+
+	std::unordered_map<VkDeviceMemory, SAllocation> m_Allocations;
+	SMemoryHeapInfo m_Heaps[VK_MAX_MEMORY_HEAPS];
+	bool m_HeapLowReported[VK_MAX_MEMORY_HEAPS] = {};
+	vk::DeviceSize m_CategoryBytes[kMemoryCategoryCount] = {};
+	vk::DeviceSize m_TrackedBytes = 0;
+	vk::DeviceSize m_PeakTrackedBytes = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+enum class ERenderPass : uint8_t
+{
+	Scene = 0,
+	// scales the scene onto the swap chain image with dynamic resolution, empty otherwise
+	Upscale = 1,
+	ImGui = 2,
+	Count
+};
+
+const uint32_t kRenderPassCount = static_cast<uint32_t>(ERenderPass::Count);
+const char* const kRenderPassNames[kRenderPassCount] = { "Scene", "Upscale", "ImGui" };
+
+// input assembly vertices/primitives, vertex shader invocations, clipping invocations/primitives, fragment shader invocations
+const uint32_t kPipelineStatisticCount = 6;
+
+struct SRenderPassStatistics
+{
+	float CpuTimeMs = 0.f;
+	float GpuTimeMs = 0.f;
+	uint64_t InputAssemblyVertices = 0;
+	uint64_t InputAssemblyPrimitives = 0;
+	uint64_t VertexShaderInvocations = 0;
+	uint64_t ClippingInvocations = 0;
+	uint64_t ClippingPrimitives = 0;
+	uint64_t FragmentShaderInvocations = 0;
+	uint64_t SamplesPassed = 0;
+};
+
+class CRenderProfiler
+{
+public:
+	EEngineStatus Initialize(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t queueFamily, uint32_t frameCount, const vk::PhysicalDeviceFeatures& enabledFeatures);
+	void Shutdown();
+
+	// must be recorded outside of a render pass, before any pass of the frame
+	void ResetQueries(vk::CommandBuffer commandBuffer, uint32_t frame) const;
+	void BeginPass(vk::CommandBuffer commandBuffer, uint32_t frame, ERenderPass pass) const;
+	void EndPass(vk::CommandBuffer commandBuffer, uint32_t frame, ERenderPass pass) const;
+	// reads back the results of a frame whose command buffers have finished executing
+	void CollectResults(uint32_t frame);
+	void SetCpuTime(ERenderPass pass, float cpuTimeMs);
+
+	bool HasTimestamps() const;
+	bool HasPipelineStatistics() const;
+	bool HasOcclusionQueries() const;
+	const SRenderPassStatistics& GetPassStatistics(ERenderPass pass) const;
+
+	bool m_PipelineStatisticsEnabled = true;
+private:
+	vk::Device m_Device;
+	uint32_t m_FrameCount = 0;
+	float m_TimestampPeriod = 0.f;
+	uint64_t m_TimestampMask = 0;
+	bool m_PreciseOcclusion = false;
+
+	vk::QueryPool m_TimestampPool;
+	vk::QueryPool m_PipelineStatisticsPool;
+	vk::QueryPool m_OcclusionPool;
+
+	SRenderPassStatistics m_PassStatistics[kRenderPassCount];
+};
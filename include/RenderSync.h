@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+const uint32_t kMaxFramesInFlight = 2;
+const uint32_t kMaxQueueDependencies = 4;
+
+enum class ERenderQueue : uint8_t
+{
+	Graphics = 0,
+	Count
+};
+
+const uint32_t kRenderQueueCount = static_cast<uint32_t>(ERenderQueue::Count);
+
+// makes a submission wait until another queue has reached a value
+struct SQueueDependency
+{
+	ERenderQueue Queue;
+	uint64_t Value;
+	vk::PipelineStageFlags Stage;
+};
+
+// Frame and queue synchronization. Every submission on a queue advances that queue's value by one.
+// With timeline semaphores (Vulkan 1.2) each queue owns a single timeline semaphore carrying its value;
+// otherwise every submission signals a pooled fence that stands in for the value.
+class CRenderSync
+{
+public:
+	EEngineStatus Initialize(vk::Device device, bool useTimelineSemaphores, const vk::DispatchLoaderDynamic* dispatchLoader);
+	void Shutdown();
+
+	void SetQueue(ERenderQueue queue, vk::Queue vkQueue);
+
+	// starts the next frame, waiting until the previous frame that used the same frame slot has finished
+	EEngineStatus BeginFrame();
+	// submits the frame's command buffers to the graphics queue, waiting on image acquisition and signalling presentation
+	vk::Result SubmitFrame(const vk::CommandBuffer* commandBuffers, uint32_t commandBufferCount, const SQueueDependency* dependencies = nullptr, uint32_t dependencyCount = 0);
+	// submits work outside of the frame, returns the queue value that marks its completion (0 on failure)
+	uint64_t Submit(ERenderQueue queue, const vk::CommandBuffer* commandBuffers, uint32_t commandBufferCount, const SQueueDependency* dependencies = nullptr, uint32_t dependencyCount = 0);
+
+	uint64_t GetFrame() const;
+	uint32_t GetFrameSlot() const;
+	vk::Semaphore GetImageAvailableSemaphore() const;
+	vk::Semaphore GetRenderFinishedSemaphore() const;
+
+	bool IsFrameComplete(uint64_t frame);
+	EEngineStatus WaitForFrame(uint64_t frame);
+	// the newest frame known to have finished on the GPU
+	uint64_t GetCompletedFrame();
+
+	uint64_t GetQueueValue(ERenderQueue queue) const;
+	bool IsQueueValueComplete(ERenderQueue queue, uint64_t value);
+	EEngineStatus WaitForQueueValue(ERenderQueue queue, uint64_t value);
+
+	bool UsesTimelineSemaphores() const;
+private:
+	vk::Result SubmitInternal(ERenderQueue queue, const vk::CommandBuffer* commandBuffers, uint32_t commandBufferCount, const SQueueDependency* dependencies, uint32_t dependencyCount, bool frameSubmit);
+	void RefreshCompletedValue(ERenderQueue queue);
+
+	vk::Device m_Device;
+	const vk::DispatchLoaderDynamic* m_DispatchLoader = nullptr;
+	bool m_UseTimelineSemaphores = false;
+
+	vk::Queue m_Queues[kRenderQueueCount];
+	uint64_t m_SubmittedValues[kRenderQueueCount] = {};
+	uint64_t m_CompletedValues[kRenderQueueCount] = {};
+
+	// timeline mode
+	vk::Semaphore m_Timelines[kRenderQueueCount];
+
+	// fallback mode: fences of submissions that have not been observed as complete yet, oldest first
+	std::deque<std::pair<uint64_t, vk::Fence>> m_PendingFences[kRenderQueueCount];
+	std::vector<vk::Fence> m_FreeFences;
+
+	uint64_t m_Frame = 0;
+	// graphics queue value of each frame slot's last submission, zero while the frame has not been submitted
+	uint64_t m_FrameValues[kMaxFramesInFlight] = {};
+	uint64_t m_FrameNumbers[kMaxFramesInFlight] = {};
+	uint64_t m_CompletedFrame = 0;
+
+	vk::Semaphore m_ImageAvailableSemaphores[kMaxFramesInFlight];
+	vk::Semaphore m_RenderFinishedSemaphores[kMaxFramesInFlight];
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#define VULKAN_HPP_NO_EXCEPTIONS
+#define VULKAN_HPP_ASSERT(e)
+#include "vulkan/vulkan.hpp"
+
+#define VKR(res) if((res) != vk::Result::eSuccess){return EEngineStatus::Failed;}
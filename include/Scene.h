@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Engine.h"
+
+class CJobSystem;
+
+// per-object streams handed to the GPU as instance data, in binding order
+enum class ESceneStream : uint8_t
+{
+	PositionX = 0,
+	PositionY,
+	PositionZ,
+	// degrees, added to the global rotation
+	Angle,
+	Scale,
+	Count
+};
+
+const uint32_t kSceneStreamCount = static_cast<uint32_t>(ESceneStream::Count);
+
+// arrays are padded to a multiple of the widest SIMD width so that the kernels never need a scalar tail
+const uint32_t kSceneSimdWidth = 8;
+
+// objects per simulation job, a multiple of kSceneSimdWidth
+const uint32_t kSceneSimulateBatchSize = 16384;
+
+// objects bounce inside this box; it is larger than the view so that only part of the scene is visible
+const glm::vec3 kSceneBoundsMin = { -2.f, -2.f, 0.f };
+const glm::vec3 kSceneBoundsMax = { 2.f, 2.f, 1.f };
+
+struct SSceneStats
+{
+	uint32_t ObjectCount = 0;
+	// the last fixed tick
+	float SimulateMs = 0.f;
+	// the last WriteInstances call
+	float WriteMs = 0.f;
+	// objects written by the last WriteInstances call
+	uint32_t WrittenCount = 0;
+};
+
+// Structure-of-arrays object store: every property lives in its own contiguous float array, the update
+// kernels process kSceneSimdWidth objects per iteration with SSE2 or AVX, and the per-stream arrays are
+// written to instance buffers without any gathering.
+class CScene
+{
+public:
+	void Reserve(uint32_t capacity);
+	void Clear();
+	// boundsRadius is the object-space bounding sphere radius, scaled with the object
+	uint32_t AddObject(const glm::vec3& position, const glm::vec3& velocity, float angle, float angularVelocity, float scale, float boundsRadius);
+	// adds count objects with pseudo-random positions, velocities and spins inside the scene bounds
+	void Spawn(uint32_t count, uint32_t seed, float boundsRadius);
+
+	// advances every object by one fixed tick, keeping the previous state for interpolation
+	void Simulate(float timeStep, CJobSystem* jobs);
+	// writes the interpolated state of the listed objects, objectCount floats per stream, streams[i] receives ESceneStream i
+	void WriteInstances(float interpolation, const uint32_t* objects, uint32_t objectCount, float* const streams[kSceneStreamCount]);
+
+	uint32_t GetObjectCount() const;
+	// the object count rounded up to kSceneSimdWidth
+	uint32_t GetPaddedObjectCount() const;
+	const float* GetPositionX() const;
+	const float* GetPositionY() const;
+	const float* GetPositionZ() const;
+	const float* GetScale() const;
+	// world-space bounding sphere radius
+	const float* GetBoundsRadius() const;
+	// the LOD each object was last drawn with, updated by SelectLods
+	uint8_t* GetLods();
+	// the fastest object's speed; bounces only flip velocities, so this bounds the motion of every object per tick
+	float GetMaxSpeed() const;
+	const SSceneStats& GetStats() const;
+private:
+	uint32_t m_Count = 0;
+	float m_MaxSpeed = 0.f;
+
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	std::vector<float> m_PositionZ;
+	std::vector<float> m_Angle;
+	std::vector<float> m_PreviousX;
+	std::vector<float> m_PreviousY;
+	std::vector<float> m_PreviousZ;
+	std::vector<float> m_PreviousAngle;
+	std::vector<float> m_VelocityX;
+	std::vector<float> m_VelocityY;
+	std::vector<float> m_VelocityZ;
+	std::vector<float> m_AngularVelocity;
+	std::vector<float> m_Scale;
+	std::vector<float> m_BoundsRadius;
+	std::vector<uint8_t> m_Lods;
+
+	SSceneStats m_Stats;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// A minimal vector abstraction so that the data-oriented kernels are written once: AVX when it is enabled
+// at compile time, SSE2 on every x64 target and plain floats elsewhere. Masks hold all-ones lanes,
+// SimdMoveMask packs them into one bit per lane.
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VKLEARN_SIMD_SSE2
+#endif
+
+#if defined(__AVX__)
+using SimdFloat = __m256;
+using SimdMask = __m256;
+const uint32_t kSimdLanes = 8;
+
+inline SimdFloat SimdLoad(const float* p) { return _mm256_loadu_ps(p); }
+inline void SimdStore(float* p, const SimdFloat v) { _mm256_storeu_ps(p, v); }
+inline SimdFloat SimdSet(const float v) { return _mm256_set1_ps(v); }
+inline SimdFloat SimdAdd(const SimdFloat a, const SimdFloat b) { return _mm256_add_ps(a, b); }
+inline SimdFloat SimdSub(const SimdFloat a, const SimdFloat b) { return _mm256_sub_ps(a, b); }
+inline SimdFloat SimdMul(const SimdFloat a, const SimdFloat b) { return _mm256_mul_ps(a, b); }
+inline SimdFloat SimdMin(const SimdFloat a, const SimdFloat b) { return _mm256_min_ps(a, b); }
+inline SimdFloat SimdMax(const SimdFloat a, const SimdFloat b) { return _mm256_max_ps(a, b); }
+inline SimdMask SimdLess(const SimdFloat a, const SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline SimdMask SimdGreaterEqual(const SimdFloat a, const SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline SimdMask SimdOr(const SimdMask a, const SimdMask b) { return _mm256_or_ps(a, b); }
+inline SimdMask SimdAnd(const SimdMask a, const SimdMask b) { return _mm256_and_ps(a, b); }
+inline uint32_t SimdMoveMask(const SimdMask mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+inline SimdFloat SimdSelect(const SimdMask mask, const SimdFloat a, const SimdFloat b) { return _mm256_blendv_ps(b, a, mask); }
+#elif defined(VKLEARN_SIMD_SSE2)
+using SimdFloat = __m128;
+using SimdMask = __m128;
+const uint32_t kSimdLanes = 4;
+
+inline SimdFloat SimdLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void SimdStore(float* p, const SimdFloat v) { _mm_storeu_ps(p, v); }
+inline SimdFloat SimdSet(const float v) { return _mm_set1_ps(v); }
+inline SimdFloat SimdAdd(const SimdFloat a, const SimdFloat b) { return _mm_add_ps(a, b); }
+inline SimdFloat SimdSub(const SimdFloat a, const SimdFloat b) { return _mm_sub_ps(a, b); }
+inline SimdFloat SimdMul(const SimdFloat a, const SimdFloat b) { return _mm_mul_ps(a, b); }
+inline SimdFloat SimdMin(const SimdFloat a, const SimdFloat b) { return _mm_min_ps(a, b); }
+inline SimdFloat SimdMax(const SimdFloat a, const SimdFloat b) { return _mm_max_ps(a, b); }
+inline SimdMask SimdLess(const SimdFloat a, const SimdFloat b) { return _mm_cmplt_ps(a, b); }
+inline SimdMask SimdGreaterEqual(const SimdFloat a, const SimdFloat b) { return _mm_cmpge_ps(a, b); }
+inline SimdMask SimdOr(const SimdMask a, const SimdMask b) { return _mm_or_ps(a, b); }
+inline SimdMask SimdAnd(const SimdMask a, const SimdMask b) { return _mm_and_ps(a, b); }
+inline uint32_t SimdMoveMask(const SimdMask mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+inline SimdFloat SimdSelect(const SimdMask mask, const SimdFloat a, const SimdFloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#else
+using SimdFloat = float;
+using SimdMask = bool;
+const uint32_t kSimdLanes = 1;
+
+inline SimdFloat SimdLoad(const float* p) { return *p; }
+inline void SimdStore(float* p, const SimdFloat v) { *p = v; }
+inline SimdFloat SimdSet(const float v) { return v; }
+inline SimdFloat SimdAdd(const SimdFloat a, const SimdFloat b) { return a + b; }
+inline SimdFloat SimdSub(const SimdFloat a, const SimdFloat b) { return a - b; }
+inline SimdFloat SimdMul(const SimdFloat a, const SimdFloat b) { return a * b; }
+inline SimdFloat SimdMin(const SimdFloat a, const SimdFloat b) { return std::min(a, b); }
+inline SimdFloat SimdMax(const SimdFloat a, const SimdFloat b) { return std::max(a, b); }
+inline SimdMask SimdLess(const SimdFloat a, const SimdFloat b) { return a < b; }
+inline SimdMask SimdGreaterEqual(const SimdFloat a, const SimdFloat b) { return a >= b; }
+inline SimdMask SimdOr(const SimdMask a, const SimdMask b) { return a || b; }
+inline SimdMask SimdAnd(const SimdMask a, const SimdMask b) { return a && b; }
+inline uint32_t SimdMoveMask(const SimdMask mask) { return mask ? 1 : 0; }
+inline SimdFloat SimdSelect(const SimdMask mask, const SimdFloat a, const SimdFloat b) { return mask ? a : b; }
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+const uint32_t kCacheLineSize = 64;
+
+// Lock-free ring buffer between exactly one producer thread and one consumer thread. The indices only
+// grow and wrap at 2^32, which a power of two capacity divides evenly.
+template <typename T, uint32_t Capacity>
+class CSpscQueue
+{
+	static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "the capacity must be a power of two");
+public:
+	// producer only; returns false when the queue is full
+	bool Push(const T& value)
+	{
+		const uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_Head.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		m_Items[tail & (Capacity - 1)] = value;
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer only; returns false when the queue is empty
+	bool Pop(T& value)
+	{
+		const uint32_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_Tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		value = m_Items[head & (Capacity - 1)];
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+private:
+	T m_Items[Capacity];
+	// each index on its own cache line, so that the two threads do not keep stealing it from each other
+	std::atomic<uint32_t> m_Head{ 0 };
+	uint8_t m_HeadPadding[kCacheLineSize - sizeof(std::atomic<uint32_t>)];
+	std::atomic<uint32_t> m_Tail{ 0 };
+	uint8_t m_TailPadding[kCacheLineSize - sizeof(std::atomic<uint32_t>)];
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+class CRenderMemory;
+class CRenderSync;
+class CRenderDeletionQueue;
+class CRenderBindless;
+
+// .vktex layout (little endian): STextureFileHeader, MipCount STextureFileMip entries (finest mip first),
+// then the tightly packed mip data in the image format
+const uint32_t kTextureFileMagic = 0x58544B56; // "VKTX"
+const uint32_t kTextureFileVersion = 1;
+const uint32_t kMaxTextureMips = 16;
+
+// mips no larger than this in either dimension form the tail that is loaded up front
+const uint32_t kTextureMipTailDimension = 64;
+const vk::DeviceSize kTextureStagingBytesPerFrame = 8ull << 20;
+// upper bound of the resident texture memory, lowered to half of the device-local heap budget
+const vk::DeviceSize kTextureStreamingBudget = 512ull << 20;
+const uint32_t kTextureStreamingWorkerCount = 2;
+const uint32_t kMaxTextureDecodesInFlight = 4;
+// textures unused for this many frames stop upgrading and become eviction candidates
+const uint32_t kTextureEvictionFrames = 120;
+
+const uint32_t kInvalidTexture = UINT32_MAX;
+
+struct STextureFileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	// VkFormat of the mip data
+	uint32_t Format;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t MipCount;
+};
+
+struct STextureFileMip
+{
+	uint64_t Offset;
+	uint64_t Size;
+};
+
+enum class ETextureState : uint8_t
+{
+	Loading = 0,
+	Resident,
+	Failed
+};
+
+struct STextureStreamingStats
+{
+	uint32_t TextureCount = 0;
+	uint32_t DecodesInFlight = 0;
+	uint32_t UploadsInFlight = 0;
+	vk::DeviceSize ResidentBytes = 0;
+	vk::DeviceSize Budget = 0;
+	// staging bytes copied by the last frame
+	vk::DeviceSize UploadedBytes = 0;
+	uint32_t Evictions = 0;
+};
+
+// Streams textures into device memory without stalling the frame. Files are read on worker threads,
+// the mip tail is uploaded first and textures in use are upgraded one mip at a time while the budget
+// allows. Upgrades and evictions reallocate the image with one mip more or less and copy the resident
+// mips over on the GPU; the old image is destroyed once the frames sampling it have completed.
+class CTextureStreamer
+{
+public:
+	EEngineStatus Initialize(vk::Device device, CRenderMemory* memory, CRenderSync* sync, CRenderDeletionQueue* deletionQueue, CRenderBindless* bindless);
+	void Shutdown();
+
+	// returns immediately, the texture becomes resident after its mip tail has been read and uploaded
+	uint32_t Load(const std::string& path);
+	void Unload(uint32_t texture);
+	// marks the texture as used by the current frame, keeping it from being evicted and letting it upgrade
+	void Touch(uint32_t texture);
+
+	// records this frame's copies and layout transitions, must be called outside of a render pass
+	void Update(vk::CommandBuffer commandBuffer);
+
+	ETextureState GetState(uint32_t texture) const;
+	// the view and bindless index change whenever the residency does, query them every frame
+	vk::ImageView GetImageView(uint32_t texture) const;
+	uint32_t GetBindlessIndex(uint32_t texture) const;
+	uint32_t GetResidentMip(uint32_t texture) const;
+	vk::Sampler GetSampler() const;
+	const STextureStreamingStats& GetStats() const;
+private:
+	struct SDecodeRequest
+	{
+		uint32_t Texture;
+		uint32_t Generation;
+		std::string Path;
+		// kMaxTextureMips requests the header and the mip tail
+		uint32_t Mip;
+	};
+
+	struct SDecodeResult
+	{
+		uint32_t Texture;
+		uint32_t Generation;
+		bool Succeeded = false;
+		STextureFileHeader Header;
+		uint32_t FirstMip = 0;
+		uint32_t LastMip = 0;
+		// mips FirstMip..LastMip back to back, offsets relative to Data
+		std::vector<uint8_t> Data;
+		vk::DeviceSize MipOffsets[kMaxTextureMips] = {};
+	};
+
+	struct SImage
+	{
+		vk::Image Image;
+		vk::DeviceMemory Memory;
+		vk::ImageView View;
+		vk::DeviceSize Size = 0;
+		// file mip stored in level 0 of the image
+		uint32_t FirstMip = 0;
+	};
+
+	struct STexture
+	{
+		bool InUse = false;
+		uint32_t Generation = 0;
+		std::string Path;
+		ETextureState State = ETextureState::Loading;
+
+		vk::Format Format = vk::Format::eUndefined;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t MipCount = 0;
+		uint32_t TailMip = 0;
+
+		SImage Current;
+		uint32_t BindlessIndex = UINT32_MAX;
+
+		// upload in progress into Pending, swapped with Current when the last row has been copied
+		SImage Pending;
+		bool Uploading = false;
+		std::vector<uint8_t> UploadData;
+		vk::DeviceSize UploadMipOffsets[kMaxTextureMips] = {};
+		uint32_t UploadMip = 0;
+		uint32_t UploadLastMip = 0;
+		uint32_t UploadRow = 0;
+
+		bool DecodeInFlight = false;
+		bool UpgradeFailed = false;
+		uint64_t LastUsedFrame = 0;
+	};
+
+	static void DecodeFile(const SDecodeRequest& request, SDecodeResult& result);
+	void WorkerMain();
+
+	void ProcessDecodeResults(vk::CommandBuffer commandBuffer);
+	void ContinueUploads(vk::CommandBuffer commandBuffer);
+	void UpdateResidency(vk::CommandBuffer commandBuffer);
+	bool BeginUpload(vk::CommandBuffer commandBuffer, STexture& texture, SDecodeResult& result);
+	bool UploadRows(vk::CommandBuffer commandBuffer, STexture& texture);
+	bool EvictMip(vk::CommandBuffer commandBuffer, STexture& texture);
+	void SwapPending(vk::CommandBuffer commandBuffer, STexture& texture);
+
+	bool CreateImage(const STexture& texture, uint32_t firstMip, SImage& image);
+	void RetireImage(SImage& image);
+	void DestroyImage(SImage& image);
+	void CopyMips(vk::CommandBuffer commandBuffer, const STexture& texture, const SImage& source, const SImage& destination) const;
+	vk::DeviceSize EstimateImageBytes(const STexture& texture, uint32_t firstMip) const;
+	void QueueDecode(uint32_t texture, uint32_t mip);
+
+	vk::Device m_Device;
+	CRenderMemory* m_Memory = nullptr;
+	CRenderSync* m_Sync = nullptr;
+	CRenderDeletionQueue* m_DeletionQueue = nullptr;
+	CRenderBindless* m_Bindless = nullptr;
+
+	vk::Sampler m_Sampler;
+	vk::Buffer m_StagingBuffer;
+	vk::DeviceMemory m_StagingMemory;
+	uint8_t* m_StagingMapped = nullptr;
+	vk::DeviceSize m_StagingOffset = 0;
+	uint32_t m_ImageMemoryHeap = 0;
+
+	std::vector<STexture> m_Textures;
+	std::vector<uint32_t> m_FreeTextures;
+	// textures with an upload in progress, oldest first
+	std::deque<uint32_t> m_Uploads;
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_DecodeMutex;
+	std::condition_variable m_DecodeCondition;
+	std::deque<SDecodeRequest> m_DecodeRequests;
+	std::vector<SDecodeResult> m_DecodeResults;
+	bool m_StopWorkers = false;
+
+	STextureStreamingStats m_Stats;
+};
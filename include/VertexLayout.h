@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Engine.h"
+#include "RenderVulkan.h"
+
+enum class EVertexAttribute : uint8_t
+{
+	Position = 0,
+	// octahedral-encoded, decoded in the vertex shader
+	Normal,
+	Color,
+	Count
+};
+
+const uint32_t kVertexAttributeCount = static_cast<uint32_t>(EVertexAttribute::Count);
+
+// storage formats, all of them are mandatory vertex buffer formats
+enum class EVertexFormat : uint8_t
+{
+	Float3 = 0,
+	Float2,
+	// 16-bit floats, the fourth component is padding
+	Half4,
+	// [-1, 1], the fourth component is padding
+	Snorm16x4,
+	Snorm16x2,
+	Unorm8x4,
+	Count
+};
+
+const uint32_t kVertexFormatCount = static_cast<uint32_t>(EVertexFormat::Count);
+const uint32_t kVertexFormatSizes[kVertexFormatCount] = { 12, 8, 8, 8, 4, 4 };
+
+// unquantized vertex, encoded into a layout with SVertexLayout::Encode
+struct SVertexInput
+{
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec3 Color;
+};
+
+// a single interleaved vertex stream; the binding and attribute descriptions, the stride and the
+// encoder are all derived from the per-attribute formats, attribute locations follow EVertexAttribute
+struct SVertexLayout
+{
+	const char* Name;
+	EVertexFormat Formats[kVertexAttributeCount];
+	// positions are divided by this before they are stored, the vertex shader multiplies it back;
+	// normalized position formats need every component of Position / PositionScale in [-1, 1]
+	float PositionScale;
+
+	uint32_t GetStride() const;
+	uint32_t GetOffset(EVertexAttribute attribute) const;
+	vk::VertexInputBindingDescription GetBindingDescription(uint32_t binding) const;
+	// fills kVertexAttributeCount descriptions
+	void GetAttributeDescriptions(uint32_t binding, vk::VertexInputAttributeDescription* descriptions) const;
+	// writes GetStride() bytes
+	void Encode(const SVertexInput& vertex, uint8_t* destination) const;
+};
+
+const SVertexLayout kVertexLayouts[] = {
+	// 32 bytes, reference layout
+	{ "float", { EVertexFormat::Float3, EVertexFormat::Float2, EVertexFormat::Float3 }, 1.f },
+	// 16 bytes
+	{ "half", { EVertexFormat::Half4, EVertexFormat::Snorm16x2, EVertexFormat::Unorm8x4 }, 1.f },
+	// 16 bytes, positions need to fit the PositionScale cube
+	{ "snorm16", { EVertexFormat::Snorm16x4, EVertexFormat::Snorm16x2, EVertexFormat::Unorm8x4 }, 1.f },
+};
+
+// returns nullptr for unknown names
+const SVertexLayout* FindVertexLayout(const std::string& name);
+
+// octahedral mapping of a unit vector to [-1, 1]^2
+glm::vec2 EncodeOctahedral(glm::vec3 normal);
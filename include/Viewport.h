@@ -1,23 +1,101 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
 #include "Engine.h"
 #include "SDL.h"
+#include "SpscQueue.h"
 
 const int kViewportInitialWidth = 1920;
 const int kViewportInitialHeight = 1080;
 const char* const kViewportWindowTitle = "Vulkan Sample";
 
+// events buffered between the pumping thread and the frame; further events are dropped while it is full
+const uint32_t kInputQueueCapacity = 1024;
+// how long PumpEvents blocks without events, which bounds the delay of main thread jobs
+const uint32_t kInputPumpTimeoutMs = 2;
+
+struct SInputEvent
+{
+	SDL_Event Event;
+	// when the event was pumped
+	std::chrono::high_resolution_clock::time_point Time;
+};
+
+// window and mouse state sampled on the window thread along with the events
+struct SWindowState
+{
+	// zero while the window is minimized
+	int Width = 0;
+	int Height = 0;
+	int DrawableWidth = 0;
+	int DrawableHeight = 0;
+	bool Focused = false;
+	// relative to the window, only meaningful while it has the focus
+	int MouseX = 0;
+	int MouseY = 0;
+	uint32_t MouseButtons = 0;
+};
+
+// system cursors for the ImGui cursor shapes, ImGuiMouseCursor_COUNT of them
+const uint32_t kViewportCursorCount = 9;
+
+struct SInputStats
+{
+	// events handled by the last Update
+	uint32_t Events = 0;
+	// the longest an event of the last Update waited in the queue
+	float MaxQueueDelayMs = 0.f;
+	uint32_t Dropped = 0;
+};
+
+// Owns the window. SDL only delivers events to the thread that created it, so that thread calls
+// PumpEvents in a loop, which timestamps the events and hands them to the frame through a lock-free
+// queue along with a snapshot of the window and mouse state, while the frame runs on another thread and
+// handles them in Update. The window thread also owns the cursor and the mouse capture, so the frame
+// feeds ImGui from the snapshot in NewFrame and sends cursor changes back as main thread jobs.
 class CViewport
 {
 public:
 	EEngineStatus Initialize();
+	// on the window thread; waits at most timeoutMs for the first event
+	void PumpEvents(uint32_t timeoutMs);
+	// on the frame thread, handles the events pumped so far
 	EEngineStatus Update();
+	// on the frame thread, in place of the SDL backend's NewFrame, before ImGui::NewFrame
+	void NewFrame();
+	// on the window thread, once the frame thread has stopped
 	EEngineStatus Shutdown();
 	
 	inline SDL_Window* GetWindow() const
 	{
 		return m_Window;
 	}
+
+	// when the newest event handled by the last Update was pumped, or when that Update ran if it handled
+	// none
+	std::chrono::high_resolution_clock::time_point GetLastInputTime() const;
+	const SInputStats& GetStats() const;
 private:
 	SDL_Window* m_Window = nullptr;
-};
\ No newline at end of file
+	SDL_Cursor* m_Cursors[kViewportCursorCount] = {};
+	// Wayland has no global mouse position
+	bool m_UseGlobalMouseState = true;
+
+	std::mutex m_WindowStateMutex;
+	SWindowState m_WindowState;
+
+	// frame thread state: presses seen since the last NewFrame, so that a click shorter than a frame is not
+	// missed, and what has been requested from the window thread so far
+	bool m_MousePressed[3] = {};
+	uint64_t m_LastFrameCounter = 0;
+	int m_RequestedCursor = INT32_MIN;
+	bool m_RequestedCapture = false;
+
+	CSpscQueue<SInputEvent, kInputQueueCapacity> m_InputQueue;
+	std::atomic<uint32_t> m_DroppedEvents{ 0 };
+	std::chrono::high_resolution_clock::time_point m_LastInputTime;
+	SInputStats m_Stats;
+};
@@ -4,4 +4,8 @@ echo Using Vulkan SDK at %VULKAN_SDK%
 set "_GLSLC_PATH=%VULKAN_SDK%\Bin\glslc.exe"
 echo Using GLSLC at %_GLSLC_PATH%
 %_GLSLC_PATH% --target-env=vulkan1.0 -c triangle.vert
-%_GLSLC_PATH% --target-env=vulkan1.0 -c triangle.frag
\ No newline at end of file
+%_GLSLC_PATH% --target-env=vulkan1.0 -c triangle.frag
+%_GLSLC_PATH% --target-env=vulkan1.2 -DVKLEARN_BINDLESS -o triangle_bindless.vert.spv -c triangle.vert
+%_GLSLC_PATH% --target-env=vulkan1.2 -DVKLEARN_BINDLESS -o triangle_bindless.frag.spv -c triangle.frag
+%_GLSLC_PATH% --target-env=vulkan1.0 -c upscale.vert
+%_GLSLC_PATH% --target-env=vulkan1.0 -c upscale.frag
\ No newline at end of file
@@ -3,11 +3,17 @@
 #include "triangle.glsli"
 
 layout(location = 0) in vec3 inColor;
+layout(location = 1) in vec2 inTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
 	vec4 oc = vec4(inColor, 1.0f);
 	oc.r *= mapRange(ub.speed, 0, 100000, 0, 1);
+#ifdef VKLEARN_BINDLESS
+	if (draw.baseColorTexture != BINDLESS_INVALID_INDEX) {
+		oc *= texture(bindlessTextures[draw.baseColorTexture], inTexCoord);
+	}
+#endif
 	outColor = oc;
 }
\ No newline at end of file
@@ -2,20 +2,33 @@
 #extension GL_ARB_separate_shader_objects : enable
 #include "triangle.glsli"
 
+// locations follow EVertexAttribute, normalized formats are expanded by the vertex fetch
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec3 inColor;
+// per instance, one stream each (see ESceneStream)
+layout(location = 3) in float inInstanceX;
+layout(location = 4) in float inInstanceY;
+layout(location = 5) in float inInstanceZ;
+layout(location = 6) in float inInstanceAngle;
+layout(location = 7) in float inInstanceScale;
 
 layout(location = 0) out vec3 fragColor;
+// the meshes carry no texture coordinates, the texture is projected onto the object's XY plane
+layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-	vec3 pos = inPosition;
-	float rad = -radians(ub.angle);
+	vec3 pos = inPosition * ub.positionScale * inInstanceScale;
+	float rad = -radians(ub.angle + inInstanceAngle);
 	mat3 rotMat = mat3( cos(rad), -sin(rad), 0.0,
 						sin(rad), cos(rad), 0.0,
 						0.0, 0.0, 1.0);
 	
-	pos = rotMat * pos;
+	pos = rotMat * pos + vec3(inInstanceX, inInstanceY, inInstanceZ);
 	
     gl_Position = vec4(pos, 1.0);
-    fragColor = inColor;
+    // headlight shading, faces pointing at the viewer keep their full color
+    vec3 normal = rotMat * decodeOctahedral(inNormal);
+    fragColor = inColor * abs(normal.z);
+    fragTexCoord = inPosition.xy * 0.5 + 0.5;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform UpscaleConstants {
+    vec2 uvScale;
+    vec2 uvMax;
+} pc;
+
+layout(binding = 0) uniform sampler2D sceneColor;
+
+layout(location = 0) in vec2 fragUV;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // the scene only covers the top left of the image, bilinear taps past its edge would blend in stale texels
+    outColor = texture(sceneColor, min(fragUV, pc.uvMax));
+}
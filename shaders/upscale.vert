@@ -0,0 +1,17 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// render extent over the output extent, and the last texel center inside the rendered area
+layout(push_constant) uniform UpscaleConstants {
+    vec2 uvScale;
+    vec2 uvMax;
+} pc;
+
+layout(location = 0) out vec2 fragUV;
+
+// one triangle covering the whole target, without a vertex buffer
+void main() {
+    vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    fragUV = uv * pc.uvScale;
+}
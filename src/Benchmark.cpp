@@ -0,0 +1,219 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#include "Render.h"
+#include "SDL.h"
+
+#ifndef VKLEARN_GIT_REVISION
+#define VKLEARN_GIT_REVISION "unknown"
+#endif
+
+#ifdef _DEBUG
+const char* const kBenchmarkConfiguration = "Debug";
+#else
+const char* const kBenchmarkConfiguration = "Release";
+#endif
+
+static std::string GetCompilerName()
+{
+#if defined(__clang__)
+	return "Clang " __clang_version__;
+#elif defined(_MSC_VER)
+	return "MSVC " + std::to_string(_MSC_FULL_VER);
+#elif defined(__GNUC__)
+	return "GCC " __VERSION__;
+#else
+	return "unknown";
+#endif
+}
+
+static void WriteJsonString(FILE* file, const char* value)
+{
+	fputc('"', file);
+	for (const char* c = value; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+			fputc(*c, file);
+		}
+		else if (static_cast<unsigned char>(*c) < 0x20)
+		{
+			fprintf(file, "\\u%04x", static_cast<unsigned char>(*c));
+		}
+		else
+		{
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+static void WriteJsonSeries(FILE* file, const SBenchmarkSeries& series)
+{
+	fprintf(file, "{\"mean\": %.4f, \"min\": %.4f, \"max\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f}",
+		series.Mean, series.Min, series.Max, series.P50, series.P90, series.P95, series.P99);
+}
+
+void CBenchmark::Initialize(const SEngineOptions& options)
+{
+	m_Options = options;
+
+	const size_t expectedFrames = options.BenchmarkFrames != 0 ? options.BenchmarkFrames : static_cast<size_t>(options.BenchmarkDuration * 240.f);
+	m_FrameTimes.reserve(expectedFrames);
+	for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+	{
+		m_CpuPassTimes[pass].reserve(expectedFrames);
+		m_GpuPassTimes[pass].reserve(expectedFrames);
+	}
+
+	if (options.BenchmarkFrames != 0)
+	{
+		SDL_Log("[CBenchmark] %u warm-up frames, %u measured frames, fixed delta time %.6f s", options.WarmupFrames, options.BenchmarkFrames, options.FixedDeltaTime);
+	}
+	else
+	{
+		SDL_Log("[CBenchmark] %u warm-up frames, %.2f s measured, fixed delta time %.6f s", options.WarmupFrames, options.BenchmarkDuration, options.FixedDeltaTime);
+	}
+}
+
+bool CBenchmark::OnFrame(const float frameTimeMs, const CRender* render)
+{
+	m_FrameIndex++;
+
+	if (m_FrameIndex <= m_Options.WarmupFrames)
+	{
+		return false;
+	}
+
+	m_FrameTimes.push_back(frameTimeMs);
+	m_MeasuredTime += frameTimeMs * 0.001f;
+
+	const CRenderProfiler* profiler = render->GetProfiler();
+	for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+	{
+		const SRenderPassStatistics& statistics = profiler->GetPassStatistics(static_cast<ERenderPass>(pass));
+		m_CpuPassTimes[pass].push_back(statistics.CpuTimeMs);
+		m_GpuPassTimes[pass].push_back(statistics.GpuTimeMs);
+	}
+
+	if (m_Options.BenchmarkFrames != 0)
+	{
+		return m_FrameTimes.size() >= m_Options.BenchmarkFrames;
+	}
+	return m_MeasuredTime >= m_Options.BenchmarkDuration;
+}
+
+bool CBenchmark::WriteReport(const CRender* render) const
+{
+	FILE* file = fopen(m_Options.ReportPath.c_str(), "w");
+	if (file == nullptr)
+	{
+		SDL_Log("[CBenchmark] Unable to open %s for writing", m_Options.ReportPath.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\n");
+
+	fprintf(file, "  \"device\": ");
+	WriteJsonString(file, render->GetGpuName());
+	fprintf(file, ",\n");
+
+	fprintf(file, "  \"build\": {\"revision\": ");
+	WriteJsonString(file, VKLEARN_GIT_REVISION);
+	fprintf(file, ", \"configuration\": ");
+	WriteJsonString(file, kBenchmarkConfiguration);
+	fprintf(file, ", \"compiler\": ");
+	WriteJsonString(file, GetCompilerName().c_str());
+	fprintf(file, ", \"date\": ");
+	WriteJsonString(file, __DATE__ " " __TIME__);
+	fprintf(file, "},\n");
+
+	fprintf(file, "  \"settings\": {\"warmup_frames\": %u, \"frames\": %u, \"duration_s\": %.3f, \"fixed_delta_time_s\": %.6f},\n",
+		m_Options.WarmupFrames, m_Options.BenchmarkFrames, m_Options.BenchmarkDuration, m_Options.FixedDeltaTime);
+
+	fprintf(file, "  \"measured_frames\": %u,\n", static_cast<uint32_t>(m_FrameTimes.size()));
+	fprintf(file, "  \"measured_time_s\": %.4f,\n", m_MeasuredTime);
+
+	fprintf(file, "  \"frame_time_ms\": ");
+	WriteJsonSeries(file, Summarize(m_FrameTimes));
+	fprintf(file, ",\n");
+
+	fprintf(file, "  \"passes\": {\n");
+	for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+	{
+		fprintf(file, "    ");
+		WriteJsonString(file, kRenderPassNames[pass]);
+		fprintf(file, ": {\"cpu_ms\": ");
+		WriteJsonSeries(file, Summarize(m_CpuPassTimes[pass]));
+		fprintf(file, ", \"gpu_ms\": ");
+		WriteJsonSeries(file, Summarize(m_GpuPassTimes[pass]));
+		fprintf(file, "}%s\n", pass + 1 < kRenderPassCount ? "," : "");
+	}
+	fprintf(file, "  },\n");
+
+	const CRenderMemory* memory = render->GetMemory();
+	fprintf(file, "  \"memory\": {\"peak_tracked_bytes\": %llu, \"budget_source\": \"%s\", \"heaps\": [",
+		static_cast<unsigned long long>(memory->GetPeakTrackedBytes()), memory->HasMemoryBudget() ? "VK_EXT_memory_budget" : "tracked");
+	for (uint32_t heap = 0; heap < memory->GetHeapCount(); heap++)
+	{
+		const SMemoryHeapInfo& heapInfo = memory->GetHeapInfo(heap);
+		fprintf(file, "%s{\"size\": %llu, \"budget\": %llu, \"peak_usage\": %llu, \"device_local\": %s}",
+			heap != 0 ? ", " : "",
+			static_cast<unsigned long long>(heapInfo.Size),
+			static_cast<unsigned long long>(heapInfo.Budget),
+			static_cast<unsigned long long>(heapInfo.PeakUsage),
+			heapInfo.DeviceLocal ? "true" : "false");
+	}
+	fprintf(file, "]}\n");
+
+	fprintf(file, "}\n");
+
+	const bool ok = ferror(file) == 0;
+	fclose(file);
+
+	if (ok)
+	{
+		SDL_Log("[CBenchmark] Report written to %s", m_Options.ReportPath.c_str());
+	}
+
+	return ok;
+}
+
+bool CBenchmark::IsWarmingUp() const
+{
+	return m_FrameIndex < m_Options.WarmupFrames;
+}
+
+SBenchmarkSeries CBenchmark::Summarize(std::vector<float> samples)
+{
+	SBenchmarkSeries series;
+
+	if (samples.empty())
+	{
+		return series;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	// nearest-rank percentile
+	const auto percentile = [&](const float p)
+	{
+		const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<float>(samples.size())));
+		return samples[std::min(std::max(rank, size_t(1)), samples.size()) - 1];
+	};
+
+	series.Mean = std::accumulate(samples.begin(), samples.end(), 0.f) / static_cast<float>(samples.size());
+	series.Min = samples.front();
+	series.Max = samples.back();
+	series.P50 = percentile(0.50f);
+	series.P90 = percentile(0.90f);
+	series.P95 = percentile(0.95f);
+	series.P99 = percentile(0.99f);
+
+	return series;
+}
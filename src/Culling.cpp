@@ -0,0 +1,143 @@
+#include "Culling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "JobSystem.h"
+#include "Simd.h"
+
+SFrustum ExtractFrustum(const glm::mat4& viewProjection)
+{
+	// rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for (uint32_t row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	SFrustum frustum;
+	frustum.Planes[static_cast<uint32_t>(EFrustumPlane::Left)] = rows[3] + rows[0];
+	frustum.Planes[static_cast<uint32_t>(EFrustumPlane::Right)] = rows[3] - rows[0];
+	frustum.Planes[static_cast<uint32_t>(EFrustumPlane::Bottom)] = rows[3] + rows[1];
+	frustum.Planes[static_cast<uint32_t>(EFrustumPlane::Top)] = rows[3] - rows[1];
+	frustum.Planes[static_cast<uint32_t>(EFrustumPlane::Near)] = rows[2];
+	frustum.Planes[static_cast<uint32_t>(EFrustumPlane::Far)] = rows[3] - rows[2];
+
+	for (glm::vec4& plane : frustum.Planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return frustum;
+}
+
+// culls [begin, end) and writes the visible indices to destination, returns how many were written
+static uint32_t CullRange(const SFrustum& frustum, const SCullingInput& input, const uint32_t begin, const uint32_t end, uint32_t* destination)
+{
+	SimdFloat planes[kFrustumPlaneCount][4];
+	for (uint32_t plane = 0; plane < kFrustumPlaneCount; plane++)
+	{
+		for (uint32_t component = 0; component < 4; component++)
+		{
+			planes[plane][component] = SimdSet(frustum.Planes[plane][component]);
+		}
+	}
+
+	const SimdFloat zero = SimdSet(0.f);
+	const SimdFloat margin = SimdSet(input.Margin);
+
+	uint32_t visible = 0;
+	for (uint32_t i = begin; i < end; i += kSimdLanes)
+	{
+		const SimdFloat x = SimdLoad(input.PositionX + i);
+		const SimdFloat y = SimdLoad(input.PositionY + i);
+		const SimdFloat z = SimdLoad(input.PositionZ + i);
+		const SimdFloat negativeRadius = SimdSub(zero, SimdAdd(SimdLoad(input.Radius + i), margin));
+
+		// a sphere is outside as soon as it lies entirely behind one plane
+		SimdMask inside = SimdLess(negativeRadius, SimdAdd(SimdAdd(SimdMul(planes[0][0], x), SimdMul(planes[0][1], y)), SimdAdd(SimdMul(planes[0][2], z), planes[0][3])));
+		for (uint32_t plane = 1; plane < kFrustumPlaneCount; plane++)
+		{
+			const SimdFloat distance = SimdAdd(SimdAdd(SimdMul(planes[plane][0], x), SimdMul(planes[plane][1], y)), SimdAdd(SimdMul(planes[plane][2], z), planes[plane][3]));
+			inside = SimdAnd(inside, SimdLess(negativeRadius, distance));
+		}
+
+		uint32_t bits = SimdMoveMask(inside);
+		if (end - i < kSimdLanes)
+		{
+			// padding lanes past the last object
+			bits &= (1u << (end - i)) - 1;
+		}
+
+		for (uint32_t lane = 0; bits != 0; lane++, bits >>= 1)
+		{
+			if (bits & 1)
+			{
+				destination[visible++] = i + lane;
+			}
+		}
+	}
+
+	return visible;
+}
+
+EEngineStatus CFrustumCuller::Initialize(CJobSystem* jobs)
+{
+	m_Jobs = jobs;
+	return EEngineStatus::Ok;
+}
+
+uint32_t CFrustumCuller::Cull(const SFrustum& frustum, const SCullingInput& input, uint32_t* visible)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	const bool parallel = m_Jobs->GetWorkerCount() != 0 && input.Count >= kCullingParallelThreshold;
+	uint32_t visibleCount = 0;
+
+	if (!parallel)
+	{
+		visibleCount = CullRange(frustum, input, 0, input.Count, visible);
+		m_Stats.Threads = 1;
+	}
+	else
+	{
+		m_Batches.clear();
+		for (uint32_t begin = 0; begin < input.Count; begin += kCullingBatchSize)
+		{
+			m_Batches.push_back({ begin, std::min(begin + kCullingBatchSize, input.Count), 0 });
+		}
+
+		m_Jobs->ParallelFor(static_cast<uint32_t>(m_Batches.size()), 1, [&](const uint32_t first, const uint32_t last)
+		{
+			for (uint32_t batch = first; batch < last; batch++)
+			{
+				SBatch& entry = m_Batches[batch];
+				entry.Visible = CullRange(frustum, input, entry.Begin, entry.End, visible + entry.Begin);
+			}
+		});
+
+		// every batch wrote its indices at its own offset, close the gaps in order
+		for (const SBatch& batch : m_Batches)
+		{
+			if (batch.Begin != visibleCount)
+			{
+				memmove(visible + visibleCount, visible + batch.Begin, batch.Visible * sizeof(uint32_t));
+			}
+			visibleCount += batch.Visible;
+		}
+
+		m_Stats.Threads = std::min(m_Jobs->GetWorkerCount() + 1, static_cast<uint32_t>(m_Batches.size()));
+	}
+
+	m_Stats.Tested = input.Count;
+	m_Stats.Visible = visibleCount;
+	m_Stats.CullMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	return visibleCount;
+}
+
+const SCullingStats& CFrustumCuller::GetStats() const
+{
+	return m_Stats;
+}
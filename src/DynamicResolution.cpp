@@ -0,0 +1,87 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+static uint32_t ScaleDimension(const uint32_t output, const float scale)
+{
+	const uint32_t scaled = static_cast<uint32_t>(std::lround(output * scale / kResolutionGranularity)) * kResolutionGranularity;
+	return std::min(output, std::max(scaled, kResolutionGranularity));
+}
+
+void CDynamicResolution::Initialize(const vk::Extent2D outputExtent)
+{
+	m_OutputExtent = outputExtent;
+	m_Scale = 1.f;
+	m_SettleFrames = 0;
+	m_Stats = SDynamicResolutionStats();
+	m_Stats.Extent = outputExtent;
+}
+
+void CDynamicResolution::Update(const float targetMs, const float sceneGpuMs, const float fixedGpuMs)
+{
+	if (targetMs <= 0.f || sceneGpuMs <= 0.f)
+	{
+		SetScale(1.f);
+		return;
+	}
+
+	m_Stats.SmoothedSceneMs = m_Stats.SmoothedSceneMs > 0.f ? m_Stats.SmoothedSceneMs + kResolutionSmoothing * (sceneGpuMs - m_Stats.SmoothedSceneMs) : sceneGpuMs;
+	// never below a tenth of the target, so that an expensive UI cannot drive the scene to the minimum alone
+	m_Stats.BudgetMs = std::max(targetMs - fixedGpuMs, 0.1f * targetMs);
+
+	if (m_SettleFrames != 0)
+	{
+		m_SettleFrames--;
+		return;
+	}
+
+	// over budget the latest frame counts, under budget the smoothed time, so that the scale drops on a
+	// spike and rises only once it is over
+	const float sceneMs = sceneGpuMs > m_Stats.BudgetMs ? sceneGpuMs : m_Stats.SmoothedSceneMs;
+	const float ratio = m_Stats.BudgetMs / sceneMs;
+	if (std::abs(ratio - 1.f) < kResolutionDeadband)
+	{
+		return;
+	}
+
+	const float scale = std::min(m_Scale * std::sqrt(ratio), m_Scale + kResolutionMaxIncrease);
+	SetScale(std::min(std::max(scale, kMinResolutionScale), 1.f));
+}
+
+vk::Extent2D CDynamicResolution::GetOutputExtent() const
+{
+	return m_OutputExtent;
+}
+
+vk::Extent2D CDynamicResolution::GetExtent() const
+{
+	return m_Stats.Extent;
+}
+
+const SDynamicResolutionStats& CDynamicResolution::GetStats() const
+{
+	return m_Stats;
+}
+
+void CDynamicResolution::SetScale(const float scale)
+{
+	m_Scale = scale;
+
+	const vk::Extent2D extent = {
+		ScaleDimension(m_OutputExtent.width, scale),
+		ScaleDimension(m_OutputExtent.height, scale)
+	};
+
+	if (extent != m_Stats.Extent)
+	{
+		// the smoothed time was measured at the old extent, carried over it would undo the change
+		const float pixelRatio = static_cast<float>(extent.width * extent.height) / static_cast<float>(m_Stats.Extent.width * m_Stats.Extent.height);
+		m_Stats.SmoothedSceneMs *= pixelRatio;
+		m_Stats.Extent = extent;
+		m_Stats.Changes++;
+		m_SettleFrames = kResolutionSettleFrames;
+	}
+
+	m_Stats.Scale = static_cast<float>(extent.width) / static_cast<float>(m_OutputExtent.width);
+}
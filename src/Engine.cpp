@@ -1,7 +1,13 @@
 #include "Engine.h"
 #include "Viewport.h"
 #include "Render.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
 #include <gsl/gsl>
 
 #include "imgui.h"
@@ -10,39 +16,197 @@ CEngine* gEngine = nullptr;
 
 struct SEngineSubsystems
 {
+	CJobSystem Jobs;
 	CViewport Viewport;
 	CRender Render;
+	CBenchmark Benchmark;
 };
 
+const char* const kEngineUsage =
+	"Usage: vklearn [options]\n"
+	"  --benchmark             run a fixed benchmark and exit\n"
+	"  --warmup-frames <n>     frames rendered before measuring (default 120)\n"
+	"  --frames <n>            number of measured frames\n"
+	"  --duration <seconds>    measured duration when --frames is not given (default 10)\n"
+	"  --fixed-dt <seconds>    simulation delta time in benchmark mode (default 1/60)\n"
+	"  --report <path>         JSON report path (default benchmark.json)\n"
+	"  --gpu <index|name>      force a physical device by index or name substring\n"
+	"  --software-device       allow and prefer CPU (software) Vulkan devices\n"
+	"  --no-bindless           use per-frame descriptor sets even if descriptor indexing is available\n"
+	"  --vertex-layout <name>  vertex storage: float (32 bytes), half or snorm16 (16 bytes, default)\n"
+	"  --objects <n>           spawn n bouncing objects instead of the single triangle\n"
+	"  --mesh <path>           stream a .vkmesh file and draw it instead of the triangle\n"
+	"  --texture <path>        stream a .vktex file and sample it in the scene (bindless only)\n"
+	"  --msaa <samples>        scene pass samples per pixel: 1 (default), 2, 4 or 8, clamped to the device\n"
+	"  --low-latency           keep one frame in flight and latch the rotation just before submitting\n"
+	"  --dynamic-resolution <ms> scale the scene resolution to meet a GPU frame time, the UI stays sharp\n";
+
 int CEngine::Run(int argc, char** argv)
 {
 	static CEngine engine;
 	gEngine = &engine;
+
+	if (!ParseOptions(argc, argv, engine.m_Options))
+	{
+		SDL_Log("%s", kEngineUsage);
+		return kExitCodeInvalidArguments;
+	}
+
 	EEngineStatus status = engine.Initialize();
 
 	if (status != EEngineStatus::Ok)
 	{
-		return 1;
+		return kExitCodeInitializeFailed;
 	}
 
+	// SDL only delivers events to the thread that created the window, so this thread keeps pumping them
+	// and running main thread jobs while the frames run on a thread of their own
+	std::thread frameThread(&CEngine::FrameThreadMain, &engine);
+
 	while (engine.m_ShouldUpdate)
 	{
-		status = engine.Update();
+		engine.GetViewport()->PumpEvents(kInputPumpTimeoutMs);
+		engine.GetJobSystem()->RunMainThreadJobs();
+	}
 
-		if (status != EEngineStatus::Ok)
-		{
-			engine.Shutdown();
-			return 2;
-		}
+	frameThread.join();
+
+	if (engine.m_UpdateFailed)
+	{
+		engine.Shutdown();
+		return kExitCodeUpdateFailed;
+	}
+
+	bool reportWritten = true;
+	if (engine.m_Options.Benchmark)
+	{
+		reportWritten = engine.GetBenchmark()->WriteReport(engine.GetRender());
 	}
 
 	status = engine.Shutdown();
 	if (status != EEngineStatus::Ok)
 	{
-		return 3;
+		return kExitCodeShutdownFailed;
 	}
 
-	return 0;
+	return reportWritten ? 0 : kExitCodeReportFailed;
+}
+
+bool CEngine::ParseOptions(const int argc, char** argv, SEngineOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--benchmark")
+		{
+			options.Benchmark = true;
+		}
+		else if (arg == "--warmup-frames" && hasValue)
+		{
+			options.WarmupFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--frames" && hasValue)
+		{
+			options.BenchmarkFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--duration" && hasValue)
+		{
+			options.BenchmarkDuration = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "--fixed-dt" && hasValue)
+		{
+			options.FixedDeltaTime = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "--report" && hasValue)
+		{
+			options.ReportPath = argv[++i];
+		}
+		else if (arg == "--gpu" && hasValue)
+		{
+			options.Device = argv[++i];
+		}
+		else if (arg == "--software-device")
+		{
+			options.SoftwareDevice = true;
+		}
+		else if (arg == "--no-bindless")
+		{
+			options.Bindless = false;
+		}
+		else if (arg == "--vertex-layout" && hasValue)
+		{
+			options.VertexLayout = argv[++i];
+			if (FindVertexLayout(options.VertexLayout) == nullptr)
+			{
+				SDL_Log("[CEngine] Unknown vertex layout: %s", options.VertexLayout.c_str());
+				return false;
+			}
+		}
+		else if (arg == "--objects" && hasValue)
+		{
+			options.SceneObjects = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--mesh" && hasValue)
+		{
+			options.Mesh = argv[++i];
+		}
+		else if (arg == "--texture" && hasValue)
+		{
+			options.Texture = argv[++i];
+		}
+		else if (arg == "--msaa" && hasValue)
+		{
+			options.Msaa = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			if (options.Msaa != 1 && options.Msaa != 2 && options.Msaa != 4 && options.Msaa != 8)
+			{
+				SDL_Log("[CEngine] Unsupported MSAA sample count: %u", options.Msaa);
+				return false;
+			}
+		}
+		else if (arg == "--low-latency")
+		{
+			options.LowLatency = true;
+		}
+		else if (arg == "--dynamic-resolution" && hasValue)
+		{
+			options.DynamicResolutionTargetMs = std::strtof(argv[++i], nullptr);
+			if (options.DynamicResolutionTargetMs <= 0.f)
+			{
+				SDL_Log("[CEngine] Dynamic resolution target must be positive");
+				return false;
+			}
+		}
+		else
+		{
+			SDL_Log("[CEngine] Unknown or incomplete option: %s", arg.c_str());
+			return false;
+		}
+	}
+
+	if (options.FixedDeltaTime <= 0.f || (options.BenchmarkFrames == 0 && options.BenchmarkDuration <= 0.f))
+	{
+		SDL_Log("[CEngine] Benchmark frame count, duration and fixed delta time must be positive");
+		return false;
+	}
+
+	return true;
+}
+
+void CEngine::FrameThreadMain()
+{
+	// the frame issues the parallel loops and waits for them, so its jobs go to its own queue first
+	GetJobSystem()->AttachThread();
+
+	while (m_ShouldUpdate)
+	{
+		if (Update() != EEngineStatus::Ok)
+		{
+			m_UpdateFailed = true;
+			Quit();
+		}
+	}
 }
 
 CViewport* CEngine::GetViewport() const
@@ -55,6 +219,21 @@ CRender* CEngine::GetRender() const
 	return &m_Subsystems->Render;
 }
 
+CBenchmark* CEngine::GetBenchmark() const
+{
+	return &m_Subsystems->Benchmark;
+}
+
+CJobSystem* CEngine::GetJobSystem() const
+{
+	return &m_Subsystems->Jobs;
+}
+
+const SEngineOptions& CEngine::GetOptions() const
+{
+	return m_Options;
+}
+
 void CEngine::Quit()
 {
 	m_ShouldUpdate = false;
@@ -62,7 +241,7 @@ void CEngine::Quit()
 
 void CEngine::OnRenderGui() const
 {
-	const ImVec2 size(400, 140);
+	const ImVec2 size(400, 300);
 
 	ImGui::SetNextWindowSize(size);
 
@@ -70,18 +249,208 @@ void CEngine::OnRenderGui() const
 
 	ImGui::Text("Welcome to VkLearn!\nGPU: %s", GetRender()->GetGpuName());
 
-	ImGui::LabelText("FPS", "%.0f", m_FPS);
+	ImGui::LabelText("FPS", "%.0f (%.3f ms)", m_FPS, m_FrameTime);
+
+	if (m_Options.Benchmark)
+	{
+		ImGui::TextColored(ImVec4(0.90f, 0.70f, 0.00f, 1.00f), "Benchmark: %s", GetBenchmark()->IsWarmingUp() ? "warming up" : "measuring");
+	}
 
 	ImGui::DragFloat("Rotation speed", &GetRender()->m_RotationSpeed, 1, 0, 100000, "%.2f deg/s");
 
 	ImGui::LabelText("Rotation angle", "%.0f deg", GetRender()->GetAngle());
 
+	ImGui::LabelText("Simulation", "%.0f Hz, %u steps/frame", 1.0 / kSimulationTimeStep, m_SimulationSteps);
+
+	const SSceneStats& scene = GetRender()->GetScene()->GetStats();
+	const SCullingStats& culling = GetRender()->GetCuller()->GetStats();
+	ImGui::LabelText("Scene", "%u objects, %.2f ms/step, %.2f ms upload", scene.ObjectCount, scene.SimulateMs, scene.WriteMs);
+	ImGui::LabelText("Culling", "%u visible, %.2f ms on %u threads", culling.Visible, culling.CullMs, culling.Threads);
+
+	const SJobStats& jobs = GetJobSystem()->GetStats();
+	ImGui::LabelText("Jobs", "%u workers, %u jobs (%u stolen)", jobs.Workers, jobs.Executed, jobs.Stolen);
+
+	const SInputStats& input = GetViewport()->GetStats();
+	ImGui::LabelText("Input", "%u events, %.2f ms max queue delay, %u dropped", input.Events, input.MaxQueueDelayMs, input.Dropped);
+
+	ImGui::Checkbox("Low latency", &GetRender()->m_LowLatency);
+	ImGui::SameLine();
+	const SLatencyStats& latency = GetRender()->GetLatencyStats();
+	ImGui::Text("~%.1f ms input to GPU done, %.1f ms to submit", latency.EstimatedMs, latency.InputToSubmitMs);
+
+	ImGui::SliderFloat("LOD bias", &GetRender()->m_LodBias, -2.f, 4.f, "%.1f");
+
+	const SLodStats& lods = GetRender()->GetLodStats();
+	char lodInstances[96] = "";
+	for (uint32_t lod = 0, length = 0; lod < lods.LodCount && length < sizeof(lodInstances); lod++)
+	{
+		length += std::snprintf(lodInstances + length, sizeof(lodInstances) - length, lod == 0 ? "%u" : " / %u", lods.Instances[lod]);
+	}
+	ImGui::LabelText("LOD instances", "%s (%llu indices)", lodInstances, static_cast<unsigned long long>(lods.Indices));
+
 	if (ImGui::SmallButton("Reset rotation"))
 	{
 		GetRender()->ResetAngle();
 	}
 
 	ImGui::End();
+
+	RenderPassStatisticsGui();
+	RenderMemoryGui();
+}
+
+void CEngine::RenderPassStatisticsGui() const
+{
+	CRenderProfiler* profiler = GetRender()->GetProfiler();
+
+	ImGui::SetNextWindowPos(ImVec2(10, 240), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(400, 0), ImGuiCond_FirstUseEver);
+
+	ImGui::Begin("GPU passes");
+
+	if (!profiler->HasTimestamps())
+	{
+		ImGui::TextDisabled("GPU timestamps are not supported");
+	}
+
+	ImGui::Text("Scene pass: %ux MSAA", GetRender()->GetSampleCount());
+
+	const CDynamicResolution* dynamicResolution = GetRender()->GetDynamicResolution();
+	if (dynamicResolution != nullptr)
+	{
+		const SDynamicResolutionStats& resolution = dynamicResolution->GetStats();
+		ImGui::SliderFloat("GPU frame target", &GetRender()->m_DynamicResolutionTargetMs, 0.f, 50.f, "%.1f ms");
+		ImGui::Text("Scene resolution: %ux%u (%.0f%%), %.2f ms of %.2f ms budget, %u changes", resolution.Extent.width, resolution.Extent.height,
+			resolution.Scale * 100.f, resolution.SmoothedSceneMs, resolution.BudgetMs, resolution.Changes);
+	}
+
+	ImGui::Checkbox("Pipeline statistics", &profiler->m_PipelineStatisticsEnabled);
+
+	ImGui::Columns(kRenderPassCount + 1, "PassStatistics");
+	ImGui::Separator();
+	ImGui::NextColumn();
+	for (const char* passName : kRenderPassNames)
+	{
+		ImGui::Text("%s", passName);
+		ImGui::NextColumn();
+	}
+	ImGui::Separator();
+
+	const auto row = [&](const char* label, auto getter)
+	{
+		ImGui::Text("%s", label);
+		ImGui::NextColumn();
+		for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+		{
+			getter(profiler->GetPassStatistics(static_cast<ERenderPass>(pass)));
+			ImGui::NextColumn();
+		}
+	};
+
+	row("CPU time", [](const SRenderPassStatistics& s) { ImGui::Text("%.3f ms", s.CpuTimeMs); });
+	row("GPU time", [](const SRenderPassStatistics& s) { ImGui::Text("%.3f ms", s.GpuTimeMs); });
+	row("Samples passed", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.SamplesPassed)); });
+
+	if (profiler->HasPipelineStatistics())
+	{
+		row("IA vertices", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.InputAssemblyVertices)); });
+		row("IA primitives", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.InputAssemblyPrimitives)); });
+		row("VS invocations", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.VertexShaderInvocations)); });
+		row("Clip invocations", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.ClippingInvocations)); });
+		row("Clip primitives", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.ClippingPrimitives)); });
+		row("FS invocations", [](const SRenderPassStatistics& s) { ImGui::Text("%llu", static_cast<unsigned long long>(s.FragmentShaderInvocations)); });
+		// fragment shader invocations per sample that survived; values well above 1 indicate overdraw
+		row("FS / sample", [](const SRenderPassStatistics& s) { ImGui::Text("%.2f", s.SamplesPassed != 0 ? static_cast<double>(s.FragmentShaderInvocations) / static_cast<double>(s.SamplesPassed) : 0.0); });
+	}
+
+	ImGui::Columns(1);
+	ImGui::Separator();
+
+	ImGui::End();
+}
+
+void CEngine::RenderMemoryGui() const
+{
+	const CRenderMemory* memory = GetRender()->GetMemory();
+	const float kMiB = 1024.f * 1024.f;
+	const ImVec4 warningColor(1.f, 0.4f, 0.2f, 1.f);
+
+	ImGui::SetNextWindowPos(ImVec2(420, 10), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(400, 0), ImGuiCond_FirstUseEver);
+
+	ImGui::Begin("GPU memory");
+
+	ImGui::Text("Budget source: %s", memory->HasMemoryBudget() ? "VK_EXT_memory_budget" : "tracked allocations");
+
+	for (uint32_t heap = 0; heap < memory->GetHeapCount(); heap++)
+	{
+		const SMemoryHeapInfo& heapInfo = memory->GetHeapInfo(heap);
+		const float fraction = heapInfo.Budget != 0 ? static_cast<float>(heapInfo.Usage) / static_cast<float>(heapInfo.Budget) : 0.f;
+
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB", static_cast<float>(heapInfo.Usage) / kMiB, static_cast<float>(heapInfo.Budget) / kMiB);
+
+		ImGui::Text("Heap %u (%s, %.0f MiB)", heap, heapInfo.DeviceLocal ? "device local" : "host", static_cast<float>(heapInfo.Size) / kMiB);
+		if (memory->IsHeapLow(heap))
+		{
+			ImGui::PushStyleColor(ImGuiCol_PlotHistogram, warningColor);
+			ImGui::ProgressBar(fraction, ImVec2(-1, 0), overlay);
+			ImGui::PopStyleColor();
+		}
+		else
+		{
+			ImGui::ProgressBar(fraction, ImVec2(-1, 0), overlay);
+		}
+		ImGui::Text("Tracked %.2f MiB, peak usage %.1f MiB", static_cast<float>(heapInfo.TrackedUsage) / kMiB, static_cast<float>(heapInfo.PeakUsage) / kMiB);
+	}
+
+	ImGui::Separator();
+
+	const uint32_t allocationCount = memory->GetAllocationCount();
+	const uint32_t maxAllocationCount = memory->GetMaxAllocationCount();
+	if (allocationCount >= maxAllocationCount / 10 * 9)
+	{
+		ImGui::TextColored(warningColor, "VkDeviceMemory objects: %u / %u", allocationCount, maxAllocationCount);
+	}
+	else
+	{
+		ImGui::Text("VkDeviceMemory objects: %u / %u", allocationCount, maxAllocationCount);
+	}
+
+	for (uint32_t category = 0; category < kMemoryCategoryCount; category++)
+	{
+		ImGui::LabelText(kMemoryCategoryNames[category], "%.2f MiB", static_cast<float>(memory->GetCategoryBytes(static_cast<EMemoryCategory>(category))) / kMiB);
+	}
+
+	ImGui::LabelText("Tracked peak", "%.2f MiB", static_cast<float>(memory->GetPeakTrackedBytes()) / kMiB);
+
+	const SRenderGraphStats& graph = GetRender()->GetRenderGraph()->GetStats();
+
+	ImGui::Separator();
+	ImGui::Text("Render graph: %u passes (%u culled), %u barriers", graph.PassCount, graph.CulledPassCount, graph.BarrierCount);
+	ImGui::Text("%u transient (%u lazy), %.2f MiB aliased into %.2f MiB", graph.TransientCount, graph.LazyCount, static_cast<float>(graph.TransientBytes) / kMiB, static_cast<float>(graph.AllocatedBytes) / kMiB);
+
+	const SDescriptorStats& descriptors = GetRender()->GetDescriptors()->GetStats();
+
+	ImGui::Separator();
+	ImGui::Text("Descriptor sets: %u static in %u pools, %u this frame in %u pools", descriptors.StaticSets, descriptors.StaticPools, descriptors.FrameSets, descriptors.FramePools);
+
+	const SDescriptorCacheStats& descriptorCache = GetRender()->GetDescriptorCache()->GetStats();
+	ImGui::Text("Descriptor cache: %u sets, %u hits, %u misses, %u evictions", descriptorCache.Sets, descriptorCache.Hits, descriptorCache.Misses, descriptorCache.Evictions);
+
+	const SDeletionQueueStats& deletionQueue = GetRender()->GetDeletionQueue()->GetStats();
+	ImGui::Text("Deletion queue: %u pending, %u destroyed this frame, %llu in total", deletionQueue.Pending, deletionQueue.Destroyed, static_cast<unsigned long long>(deletionQueue.TotalDestroyed));
+
+	const STextureStreamingStats& streaming = GetRender()->GetTextureStreamer()->GetStats();
+
+	ImGui::Separator();
+	ImGui::Text("Texture streaming: %u textures, %u decoding, %u uploading", streaming.TextureCount, streaming.DecodesInFlight, streaming.UploadsInFlight);
+	ImGui::Text("Resident %.1f / %.1f MiB, %.2f MiB uploaded, %u evictions", static_cast<float>(streaming.ResidentBytes) / kMiB, static_cast<float>(streaming.Budget) / kMiB, static_cast<float>(streaming.UploadedBytes) / kMiB, streaming.Evictions);
+
+	const SMeshStreamingStats& meshStreaming = GetRender()->GetMeshStreamer()->GetStats();
+	ImGui::Text("Mesh streaming: %u meshes, %u uploading, %.2f MiB uploaded", meshStreaming.MeshCount, meshStreaming.UploadsInFlight, static_cast<float>(meshStreaming.UploadedBytes) / kMiB);
+
+	ImGui::End();
 }
 
 EEngineStatus CEngine::Initialize()
@@ -140,7 +509,18 @@ EEngineStatus CEngine::Initialize()
 	}
 
 	m_Subsystems = new SEngineSubsystems();
-	EEngineStatus status = m_Subsystems->Viewport.Initialize();
+
+	// the frame thread runs jobs too while it waits for them, so one worker fewer than there are hardware
+	// threads; the window thread mostly sleeps in the event pump
+	const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+	EEngineStatus status = m_Subsystems->Jobs.Initialize(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+
+	if (status != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
+
+	status = m_Subsystems->Viewport.Initialize();
 
 	if (status != EEngineStatus::Ok)
 	{
@@ -154,6 +534,11 @@ EEngineStatus CEngine::Initialize()
 		return EEngineStatus::Failed;
 	}
 
+	if (m_Options.Benchmark)
+	{
+		m_Subsystems->Benchmark.Initialize(m_Options);
+	}
+
 	m_LastTime = std::chrono::high_resolution_clock::now();
 
 	return EEngineStatus::Ok;
@@ -163,6 +548,12 @@ EEngineStatus CEngine::Update()
 {
 	using namespace  std::chrono;
 
+	// before the frame time is taken, so that the simulation and the input sampling that follow are as fresh as possible
+	if (m_Subsystems->Render.Throttle() != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
+
 	const high_resolution_clock::time_point now = high_resolution_clock::now();
 	const duration<float> deltaTime = duration_cast<duration<float>>(now - m_LastTime);
 	m_LastTime = now;
@@ -170,14 +561,38 @@ EEngineStatus CEngine::Update()
 	if (m_FPSCount >= kFPSSampleCount)
 	{
 		m_FPS = m_FPSSum / static_cast<float>(m_FPSCount);
-		m_FPSCount = m_FPSSum = 0;
+		m_FrameTime = m_FrameTimeSum / static_cast<float>(m_FPSCount);
+		m_FPSCount = 0;
+		m_FPSSum = m_FrameTimeSum = 0;
 	}
 	else
 	{
 		m_FPSCount++;
 		m_FPSSum += fps;
+		m_FrameTimeSum += deltaTime.count() * 1000.f;
+	}
+
+	m_Subsystems->Jobs.Update();
+
+	if (!m_ShouldUpdate)return EEngineStatus::Ok;
+
+	// benchmark runs feed a fixed frame time so that every run simulates and renders the same frames
+	m_SimulationAccumulator += m_Options.Benchmark ? m_Options.FixedDeltaTime : deltaTime.count();
+
+	m_SimulationSteps = 0;
+	while (m_SimulationAccumulator >= kSimulationTimeStep && m_SimulationSteps < kMaxSimulationStepsPerFrame)
+	{
+		m_Subsystems->Render.Simulate(static_cast<float>(kSimulationTimeStep));
+		m_SimulationAccumulator -= kSimulationTimeStep;
+		m_SimulationSteps++;
+	}
+
+	if (m_SimulationAccumulator >= kSimulationTimeStep)
+	{
+		m_SimulationAccumulator = std::fmod(m_SimulationAccumulator, kSimulationTimeStep);
 	}
 
+	// as late as possible, so that the UI sees the events pumped while the frame was simulating
 	EEngineStatus status = m_Subsystems->Viewport.Update();
 
 	if (status != EEngineStatus::Ok)
@@ -185,15 +600,18 @@ EEngineStatus CEngine::Update()
 		return EEngineStatus::Failed;
 	}
 
-	if (!m_ShouldUpdate)return EEngineStatus::Ok;
-
-	status = m_Subsystems->Render.Update(deltaTime.count());
+	status = m_Subsystems->Render.Update(static_cast<float>(m_SimulationAccumulator / kSimulationTimeStep));
 
 	if (status != EEngineStatus::Ok)
 	{
 		return EEngineStatus::Failed;
 	}
 
+	if (m_Options.Benchmark && m_Subsystems->Benchmark.OnFrame(deltaTime.count() * 1000.f, &m_Subsystems->Render))
+	{
+		Quit();
+	}
+
 	return EEngineStatus::Ok;
 }
 
@@ -219,6 +637,8 @@ EEngineStatus CEngine::Shutdown()
 		return EEngineStatus::Failed;
 	}
 
+	m_Subsystems->Jobs.Shutdown();
+
 	ImGui::DestroyContext();
 
 	return EEngineStatus::Ok;
@@ -0,0 +1,57 @@
+#include "IndexFormat.h"
+
+#include <algorithm>
+#include <cstring>
+
+vk::IndexType SelectIndexType(const uint32_t vertexCount)
+{
+	return vertexCount <= kMaxVertexCountUint16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+uint32_t GetIndexSize(const vk::IndexType indexType)
+{
+	return indexType == vk::IndexType::eUint16 ? 2 : 4;
+}
+
+void EncodeIndices(const uint32_t* indices, const uint32_t count, const vk::IndexType indexType, void* destination)
+{
+	if (indexType == vk::IndexType::eUint32)
+	{
+		memcpy(destination, indices, count * sizeof(uint32_t));
+		return;
+	}
+
+	uint16_t* narrowed = static_cast<uint16_t*>(destination);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		narrowed[i] = static_cast<uint16_t>(indices[i]);
+	}
+}
+
+template <typename TSource, typename TDestination>
+static bool CopyIndicesAs(const TSource* source, const uint32_t count, const uint32_t vertexCount, TDestination* destination)
+{
+	// the largest index is checked once at the end, which keeps the loop free of branches
+	uint32_t maxIndex = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		maxIndex = std::max<uint32_t>(maxIndex, source[i]);
+		destination[i] = static_cast<TDestination>(source[i]);
+	}
+	return count == 0 || maxIndex < vertexCount;
+}
+
+bool CopyIndices(const void* source, const uint32_t sourceIndexSize, const uint32_t count, const uint32_t vertexCount, const vk::IndexType indexType, void* destination)
+{
+	if (sourceIndexSize == 2)
+	{
+		// 16-bit source indices only come with meshes that 16-bit indices can address
+		return CopyIndicesAs(static_cast<const uint16_t*>(source), count, vertexCount, static_cast<uint16_t*>(destination));
+	}
+
+	if (indexType == vk::IndexType::eUint16)
+	{
+		return CopyIndicesAs(static_cast<const uint32_t*>(source), count, vertexCount, static_cast<uint16_t*>(destination));
+	}
+	return CopyIndicesAs(static_cast<const uint32_t*>(source), count, vertexCount, static_cast<uint32_t*>(destination));
+}
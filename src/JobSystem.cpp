@@ -0,0 +1,290 @@
+#include "JobSystem.h"
+
+#include "SDL.h"
+
+const uint32_t kNoJobQueue = UINT32_MAX;
+
+// queue of the thread, kNoJobQueue for threads the job system did not start
+static thread_local uint32_t tJobQueue = kNoJobQueue;
+
+EEngineStatus CJobSystem::Initialize(const uint32_t workerCount)
+{
+	const uint32_t count = std::min(workerCount, kMaxJobWorkers);
+
+	m_MainThreadId = std::this_thread::get_id();
+
+	for (uint32_t queue = 0; queue <= count; queue++)
+	{
+		m_Queues.emplace_back(new SJobQueue());
+	}
+	for (uint32_t worker = 1; worker <= count; worker++)
+	{
+		m_Threads.emplace_back(&CJobSystem::WorkerMain, this, worker);
+	}
+
+	m_Stats.Workers = count;
+	SDL_Log("[CJobSystem] %u worker threads", count);
+
+	return EEngineStatus::Ok;
+}
+
+void CJobSystem::AttachThread()
+{
+	tJobQueue = 0;
+}
+
+void CJobSystem::Shutdown()
+{
+	while (RunOne(tJobQueue) || m_QueuedJobs != 0)
+	{
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Quit = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& thread : m_Threads)
+	{
+		thread.join();
+	}
+	m_Threads.clear();
+
+	if (!m_DeferredJobs.empty())
+	{
+		SDL_Log("[CJobSystem] Dropping %u jobs whose dependencies never completed", static_cast<uint32_t>(m_DeferredJobs.size()));
+		m_DeferredJobs.clear();
+	}
+}
+
+void CJobSystem::RunMainThreadJobs()
+{
+	for (;;)
+	{
+		SJob job;
+		{
+			std::lock_guard<std::mutex> lock(m_MainThreadQueue.Mutex);
+			if (m_MainThreadQueue.Jobs.empty())
+			{
+				break;
+			}
+			job = std::move(m_MainThreadQueue.Jobs.front());
+			m_MainThreadQueue.Jobs.pop_front();
+		}
+		Execute(job);
+	}
+}
+
+void CJobSystem::Update()
+{
+	const uint64_t executed = m_Executed;
+	const uint64_t stolen = m_Stolen;
+	m_Stats.Executed = static_cast<uint32_t>(executed - m_LastExecuted);
+	m_Stats.Stolen = static_cast<uint32_t>(stolen - m_LastStolen);
+	m_LastExecuted = executed;
+	m_LastStolen = stolen;
+}
+
+void CJobSystem::Run(std::function<void()> job, SJobCounter* counter, const EJobAffinity affinity)
+{
+	if (counter != nullptr)
+	{
+		counter->Pending++;
+	}
+	Push({ std::move(job), counter, affinity });
+}
+
+void CJobSystem::RunAfter(const SJobCounter& dependency, std::function<void()> job, SJobCounter* counter, const EJobAffinity affinity)
+{
+	if (counter != nullptr)
+	{
+		counter->Pending++;
+	}
+
+	{
+		// the counter reaching zero releases the deferred jobs under the same lock, so either it is still
+		// pending here and the job is released later, or the job can go straight to a queue
+		std::lock_guard<std::mutex> lock(m_DeferredMutex);
+		if (dependency.Pending != 0)
+		{
+			m_DeferredJobs.push_back({ &dependency, { std::move(job), counter, affinity } });
+			return;
+		}
+	}
+
+	Push({ std::move(job), counter, affinity });
+}
+
+void CJobSystem::Wait(const SJobCounter& counter)
+{
+	while (counter.Pending != 0)
+	{
+		if (!RunOne(tJobQueue))
+		{
+			// the remaining jobs are running on other threads
+			std::this_thread::yield();
+		}
+	}
+}
+
+uint32_t CJobSystem::GetWorkerCount() const
+{
+	return static_cast<uint32_t>(m_Threads.size());
+}
+
+bool CJobSystem::IsMainThread() const
+{
+	return std::this_thread::get_id() == m_MainThreadId;
+}
+
+const SJobStats& CJobSystem::GetStats() const
+{
+	return m_Stats;
+}
+
+void CJobSystem::WorkerMain(const uint32_t queue)
+{
+	tJobQueue = queue;
+
+	for (;;)
+	{
+		if (RunOne(queue))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_WorkAvailable.wait(lock, [&]() { return m_Quit || m_QueuedJobs != 0; });
+
+		if (m_Quit)
+		{
+			return;
+		}
+	}
+}
+
+void CJobSystem::Push(SJob&& job)
+{
+	if (job.Affinity == EJobAffinity::MainThread)
+	{
+		std::lock_guard<std::mutex> lock(m_MainThreadQueue.Mutex);
+		m_MainThreadQueue.Jobs.push_back(std::move(job));
+		return;
+	}
+
+	{
+		// counted before the job becomes visible, so that a thread taking it right away cannot decrement the
+		// count below zero; taking the lock orders the notification after a worker that saw no jobs started
+		// waiting
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_QueuedJobs++;
+	}
+
+	const uint32_t queue = tJobQueue != kNoJobQueue ? tJobQueue : m_NextQueue++ % static_cast<uint32_t>(m_Queues.size());
+	{
+		std::lock_guard<std::mutex> lock(m_Queues[queue]->Mutex);
+		m_Queues[queue]->Jobs.push_back(std::move(job));
+	}
+	m_WorkAvailable.notify_one();
+}
+
+bool CJobSystem::RunOne(const uint32_t queue)
+{
+	SJob job;
+	bool found = false;
+
+	if (queue != kNoJobQueue)
+	{
+		SJobQueue& own = *m_Queues[queue];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Jobs.empty())
+		{
+			job = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+			found = true;
+		}
+	}
+
+	if (!found && std::this_thread::get_id() == m_MainThreadId)
+	{
+		std::lock_guard<std::mutex> lock(m_MainThreadQueue.Mutex);
+		if (!m_MainThreadQueue.Jobs.empty())
+		{
+			job = std::move(m_MainThreadQueue.Jobs.front());
+			m_MainThreadQueue.Jobs.pop_front();
+			Execute(job);
+			return true;
+		}
+	}
+
+	if (!found)
+	{
+		const uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+		const uint32_t first = queue != kNoJobQueue ? queue + 1 : 0;
+		for (uint32_t i = 0; i < queueCount && !found; i++)
+		{
+			const uint32_t victim = (first + i) % queueCount;
+			if (victim == queue)
+			{
+				continue;
+			}
+
+			SJobQueue& other = *m_Queues[victim];
+			std::lock_guard<std::mutex> lock(other.Mutex);
+			if (!other.Jobs.empty())
+			{
+				job = std::move(other.Jobs.front());
+				other.Jobs.pop_front();
+				found = true;
+				m_Stolen++;
+			}
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	m_QueuedJobs--;
+	Execute(job);
+	return true;
+}
+
+void CJobSystem::Execute(SJob& job)
+{
+	job.Function();
+	m_Executed++;
+
+	if (job.Counter != nullptr && --job.Counter->Pending == 0)
+	{
+		ReleaseDeferred(job.Counter);
+	}
+}
+
+void CJobSystem::ReleaseDeferred(const SJobCounter* dependency)
+{
+	std::vector<SJob> released;
+	{
+		std::lock_guard<std::mutex> lock(m_DeferredMutex);
+		for (size_t i = 0; i < m_DeferredJobs.size();)
+		{
+			if (m_DeferredJobs[i].Dependency == dependency)
+			{
+				released.push_back(std::move(m_DeferredJobs[i].Job));
+				m_DeferredJobs[i] = std::move(m_DeferredJobs.back());
+				m_DeferredJobs.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	for (SJob& job : released)
+	{
+		Push(std::move(job));
+	}
+}
@@ -0,0 +1,54 @@
+#include "Lod.h"
+
+#include <algorithm>
+#include <cmath>
+
+static uint32_t CoarsestLod(const SMeshLod* lods, const uint32_t lodCount, const float pixelsPerError, const float threshold)
+{
+	uint32_t lod = 0;
+	while (lod + 1 < lodCount && lods[lod + 1].Error * pixelsPerError <= threshold)
+	{
+		lod++;
+	}
+	return lod;
+}
+
+void SelectLods(const SLodInput& input, uint32_t* ordered, SLodStats& stats)
+{
+	const uint32_t lodCount = std::min(input.LodCount, kMaxMeshLods);
+	const float threshold = kLodErrorPixels * std::exp2(input.Bias);
+	const float strictThreshold = threshold * (1.f - kLodHysteresis);
+	const float lenientThreshold = threshold * (1.f + kLodHysteresis);
+
+	stats = SLodStats();
+	stats.LodCount = lodCount;
+
+	for (uint32_t i = 0; i < input.VisibleCount; i++)
+	{
+		const uint32_t object = input.Visible[i];
+		const float pixelsPerError = input.Scale[object] * input.PixelsPerUnit;
+
+		// a coarser LOD has to pass the strict threshold, the current one is kept until it fails the lenient one
+		const uint32_t lowest = CoarsestLod(input.Lods, lodCount, pixelsPerError, strictThreshold);
+		const uint32_t highest = CoarsestLod(input.Lods, lodCount, pixelsPerError, lenientThreshold);
+		const uint32_t lod = std::max(lowest, std::min<uint32_t>(input.CurrentLods[object], highest));
+
+		input.CurrentLods[object] = static_cast<uint8_t>(lod);
+		stats.Instances[lod]++;
+	}
+
+	uint32_t offsets[kMaxMeshLods];
+	uint32_t offset = 0;
+	for (uint32_t lod = 0; lod < lodCount; lod++)
+	{
+		offsets[lod] = offset;
+		offset += stats.Instances[lod];
+		stats.Indices += static_cast<uint64_t>(stats.Instances[lod]) * input.Lods[lod].IndexCount;
+	}
+
+	for (uint32_t i = 0; i < input.VisibleCount; i++)
+	{
+		const uint32_t object = input.Visible[i];
+		ordered[offsets[input.CurrentLods[object]]++] = object;
+	}
+}
@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+bool CMappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	m_File = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	m_Size = static_cast<size_t>(size.QuadPart);
+
+	m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_Mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_File = open(path.c_str(), O_RDONLY);
+	if (m_File < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(m_File, &status) != 0 || status.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	m_Size = static_cast<size_t>(status.st_size);
+
+	void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	m_Data = data != MAP_FAILED ? static_cast<const uint8_t*>(data) : nullptr;
+#endif
+
+	if (m_Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_Data != nullptr)
+	{
+		UnmapViewOfFile(m_Data);
+	}
+	if (m_Mapping != nullptr)
+	{
+		CloseHandle(m_Mapping);
+	}
+	if (m_File != nullptr)
+	{
+		CloseHandle(m_File);
+	}
+	m_Mapping = nullptr;
+	m_File = nullptr;
+#else
+	if (m_Data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(m_Data), m_Size);
+	}
+	if (m_File >= 0)
+	{
+		close(m_File);
+	}
+	m_File = -1;
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+void CMappedFile::Prefetch(const size_t offset, const size_t size) const
+{
+	if (m_Data == nullptr || offset >= m_Size)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	// PrefetchVirtualMemory needs Windows 8 headers; touching the first byte of the range starts the read-ahead
+	volatile uint8_t touch = m_Data[offset];
+	(void)touch;
+	(void)size;
+#else
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t begin = offset / pageSize * pageSize;
+	const size_t end = offset + size < m_Size ? offset + size : m_Size;
+	madvise(const_cast<uint8_t*>(m_Data) + begin, end - begin, MADV_WILLNEED);
+#endif
+}
+
+bool CMappedFile::IsOpen() const
+{
+	return m_Data != nullptr;
+}
+
+const uint8_t* CMappedFile::GetData() const
+{
+	return m_Data;
+}
+
+size_t CMappedFile::GetSize() const
+{
+	return m_Size;
+}
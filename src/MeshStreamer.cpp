@@ -0,0 +1,418 @@
+#include "MeshStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "IndexFormat.h"
+#include "RenderDeletionQueue.h"
+#include "RenderSync.h"
+#include "SDL.h"
+
+const vk::DeviceSize kMeshStagingAlignment = 16;
+
+EEngineStatus CMeshStreamer::Initialize(const vk::Device device, CRenderMemory* memory, CRenderSync* sync, CRenderDeletionQueue* deletionQueue)
+{
+	vk::Result vkResult;
+
+	m_Device = device;
+	m_Memory = memory;
+	m_Sync = sync;
+	m_DeletionQueue = deletionQueue;
+
+	// one staging region per frame slot, reused once BeginFrame has waited for the slot
+	const vk::BufferCreateInfo stagingCreateInfo = {
+		{},
+		kMeshStagingBytesPerFrame * kMaxFramesInFlight,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		vk::SharingMode::eExclusive
+	};
+
+	std::tie(vkResult, m_StagingBuffer) = m_Device.createBuffer(stagingCreateInfo);
+	VKR(vkResult);
+
+	const vk::MemoryRequirements memoryRequirements = m_Device.getBufferMemoryRequirements(m_StagingBuffer);
+	const vk::MemoryAllocateInfo stagingAllocInfo = {
+		memoryRequirements.size,
+		m_Memory->FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+	};
+
+	vkResult = m_Memory->Allocate(stagingAllocInfo, EMemoryCategory::Staging, m_StagingMemory);
+	VKR(vkResult);
+	vkResult = m_Device.bindBufferMemory(m_StagingBuffer, m_StagingMemory, 0);
+	VKR(vkResult);
+
+	void* stagingMapped;
+	vkResult = m_Device.mapMemory(m_StagingMemory, 0, VK_WHOLE_SIZE, {}, &stagingMapped);
+	VKR(vkResult);
+	m_StagingMapped = static_cast<uint8_t*>(stagingMapped);
+
+	return EEngineStatus::Ok;
+}
+
+void CMeshStreamer::Shutdown()
+{
+	// the caller has waited for the device to go idle and shuts the deletion queue down after this
+	for (uint32_t mesh = 0; mesh < m_Meshes.size(); mesh++)
+	{
+		Unload(mesh);
+	}
+
+	if (m_StagingBuffer)
+	{
+		m_Device.destroyBuffer(m_StagingBuffer);
+		m_Memory->Free(m_StagingMemory);
+	}
+}
+
+uint32_t CMeshStreamer::Load(const std::string& path)
+{
+	std::unique_ptr<CMappedFile> file(new CMappedFile());
+	if (!file->Open(path))
+	{
+		SDL_Log("[CMeshStreamer] Unable to map %s", path.c_str());
+		return kInvalidMesh;
+	}
+
+	SMeshFileHeader header = {};
+	if (file->GetSize() < kMeshFileHeaderSizeV1)
+	{
+		SDL_Log("[CMeshStreamer] %s is not a mesh file", path.c_str());
+		return kInvalidMesh;
+	}
+	memcpy(&header, file->GetData(), kMeshFileHeaderSizeV1);
+	if (header.Version >= 2 && file->GetSize() >= sizeof(header))
+	{
+		memcpy(&header, file->GetData(), sizeof(header));
+	}
+
+	const uint64_t vertexBytes = static_cast<uint64_t>(header.VertexCount) * header.VertexStride;
+	const uint64_t indexBytes = static_cast<uint64_t>(header.IndexCount) * header.IndexSize;
+
+	if (header.Magic != kMeshFileMagic || header.Version == 0 || header.Version > kMeshFileVersion || header.VertexCount == 0 || header.VertexStride == 0 ||
+		header.IndexCount == 0 || (header.IndexSize != 2 && header.IndexSize != 4) || header.IndexOffset % header.IndexSize != 0 ||
+		(header.IndexSize == 2 && header.VertexCount > kMaxVertexCountUint16) ||
+		header.VertexOffset > file->GetSize() || vertexBytes > file->GetSize() - header.VertexOffset ||
+		header.IndexOffset > file->GetSize() || indexBytes > file->GetSize() - header.IndexOffset ||
+		(header.Version >= 2 && (file->GetSize() < sizeof(header) || header.LodCount == 0 || header.LodCount > kMaxMeshLods ||
+		header.LodOffset > file->GetSize() || header.LodCount * sizeof(SMeshFileLod) > file->GetSize() - header.LodOffset)))
+	{
+		SDL_Log("[CMeshStreamer] %s is malformed or truncated", path.c_str());
+		return kInvalidMesh;
+	}
+
+	if (header.Version >= 3)
+	{
+		uint32_t stride = 0;
+		for (uint32_t attribute = 0; attribute < kVertexAttributeCount; attribute++)
+		{
+			if (header.VertexFormats[attribute] >= kVertexFormatCount)
+			{
+				SDL_Log("[CMeshStreamer] %s has an unknown vertex format", path.c_str());
+				return kInvalidMesh;
+			}
+			stride += kVertexFormatSizes[header.VertexFormats[attribute]];
+		}
+
+		if (stride != header.VertexStride)
+		{
+			SDL_Log("[CMeshStreamer] %s has a vertex stride of %u bytes, its formats take %u", path.c_str(), header.VertexStride, stride);
+			return kInvalidMesh;
+		}
+	}
+
+	SMeshLod lods[kMaxMeshLods];
+	uint32_t lodCount = 1;
+	lods[0] = { 0, header.IndexCount, 0.f };
+
+	if (header.Version >= 2)
+	{
+		lodCount = header.LodCount;
+		for (uint32_t lod = 0; lod < lodCount; lod++)
+		{
+			SMeshFileLod fileLod;
+			memcpy(&fileLod, file->GetData() + header.LodOffset + lod * sizeof(SMeshFileLod), sizeof(fileLod));
+
+			if (fileLod.IndexCount == 0 || fileLod.FirstIndex > header.IndexCount || fileLod.IndexCount > header.IndexCount - fileLod.FirstIndex ||
+				(lod > 0 && fileLod.Error < lods[lod - 1].Error))
+			{
+				SDL_Log("[CMeshStreamer] %s has an invalid LOD %u", path.c_str(), lod);
+				return kInvalidMesh;
+			}
+			lods[lod] = { fileLod.FirstIndex, fileLod.IndexCount, fileLod.Error };
+		}
+	}
+
+	uint32_t index;
+	if (!m_FreeMeshes.empty())
+	{
+		index = m_FreeMeshes.back();
+		m_FreeMeshes.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_Meshes.size());
+		m_Meshes.emplace_back();
+	}
+
+	SMesh& mesh = m_Meshes[index];
+	mesh = SMesh();
+	mesh.InUse = true;
+	mesh.Header = header;
+	mesh.Path = path;
+	std::copy(lods, lods + lodCount, mesh.Lods);
+	mesh.LodCount = lodCount;
+	// 32-bit indices in the file are narrowed during the upload when the vertex count allows it
+	mesh.IndexType = SelectIndexType(header.VertexCount);
+	m_Stats.MeshCount++;
+
+	if (!CreateBuffer(vertexBytes, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, EMemoryCategory::Vertex, mesh.VertexBuffer) ||
+		!CreateBuffer(static_cast<vk::DeviceSize>(header.IndexCount) * GetIndexSize(mesh.IndexType), vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst, EMemoryCategory::Index, mesh.IndexBuffer))
+	{
+		SDL_Log("[CMeshStreamer] Unable to allocate buffers for %s", path.c_str());
+		Unload(index);
+		return kInvalidMesh;
+	}
+
+	// start paging in the first chunk while the frame is being built
+	file->Prefetch(static_cast<size_t>(header.VertexOffset), static_cast<size_t>(std::min<uint64_t>(vertexBytes, kMeshStagingBytesPerFrame)));
+	mesh.File = std::move(file);
+
+	m_Uploads.push_back(index);
+
+	return index;
+}
+
+void CMeshStreamer::Unload(const uint32_t mesh)
+{
+	if (mesh >= m_Meshes.size() || !m_Meshes[mesh].InUse)
+	{
+		return;
+	}
+
+	SMesh& entry = m_Meshes[mesh];
+	RetireBuffer(entry.VertexBuffer);
+	RetireBuffer(entry.IndexBuffer);
+	m_Uploads.erase(std::remove(m_Uploads.begin(), m_Uploads.end(), mesh), m_Uploads.end());
+
+	entry = SMesh();
+	m_Stats.MeshCount--;
+	m_FreeMeshes.push_back(mesh);
+}
+
+void CMeshStreamer::Update(const vk::CommandBuffer commandBuffer)
+{
+	m_StagingOffset = 0;
+	m_Stats.UploadedBytes = 0;
+
+	bool copied = false;
+	while (!m_Uploads.empty())
+	{
+		SMesh& mesh = m_Meshes[m_Uploads.front()];
+		const vk::DeviceSize uploadedBefore = mesh.UploadedBytes;
+
+		const bool complete = UploadChunks(commandBuffer, mesh);
+		copied = copied || mesh.UploadedBytes != uploadedBefore;
+
+		if (!complete)
+		{
+			break;
+		}
+
+		// the data lives in device memory now, the mapping is no longer needed
+		mesh.File.reset();
+		if (mesh.State != EMeshState::Failed)
+		{
+			mesh.State = EMeshState::Ready;
+		}
+		m_Uploads.pop_front();
+	}
+
+	if (copied)
+	{
+		// meshes completed this frame are drawn later in the same command buffer
+		const vk::MemoryBarrier barrier = {
+			vk::AccessFlagBits::eTransferWrite,
+			vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead
+		};
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {}, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	m_Stats.UploadsInFlight = static_cast<uint32_t>(m_Uploads.size());
+}
+
+bool CMeshStreamer::UploadChunks(const vk::CommandBuffer commandBuffer, SMesh& mesh)
+{
+	const vk::DeviceSize stagingBase = static_cast<vk::DeviceSize>(m_Sync->GetFrameSlot()) * kMeshStagingBytesPerFrame;
+
+	const vk::DeviceSize vertexBytes = static_cast<vk::DeviceSize>(mesh.Header.VertexCount) * mesh.Header.VertexStride;
+	const uint32_t indexSize = GetIndexSize(mesh.IndexType);
+	const vk::DeviceSize indexBytes = static_cast<vk::DeviceSize>(mesh.Header.IndexCount) * indexSize;
+
+	while (mesh.UploadedBytes < vertexBytes + indexBytes)
+	{
+		m_StagingOffset = (m_StagingOffset + kMeshStagingAlignment - 1) / kMeshStagingAlignment * kMeshStagingAlignment;
+		if (m_StagingOffset >= kMeshStagingBytesPerFrame)
+		{
+			return false;
+		}
+
+		const bool vertexRegion = mesh.UploadedBytes < vertexBytes;
+		const vk::DeviceSize regionOffset = vertexRegion ? mesh.UploadedBytes : mesh.UploadedBytes - vertexBytes;
+		uint8_t* const staging = m_StagingMapped + stagingBase + m_StagingOffset;
+		vk::DeviceSize bytes;
+
+		if (vertexRegion)
+		{
+			bytes = std::min(vertexBytes - regionOffset, kMeshStagingBytesPerFrame - m_StagingOffset);
+			memcpy(staging, mesh.File->GetData() + mesh.Header.VertexOffset + regionOffset, static_cast<size_t>(bytes));
+		}
+		else
+		{
+			// whole indices only, the file and the buffer may use different widths
+			const uint64_t firstIndex = regionOffset / indexSize;
+			const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(mesh.Header.IndexCount - firstIndex, (kMeshStagingBytesPerFrame - m_StagingOffset) / indexSize));
+			const uint8_t* const source = mesh.File->GetData() + mesh.Header.IndexOffset + firstIndex * mesh.Header.IndexSize;
+
+			bytes = static_cast<vk::DeviceSize>(count) * indexSize;
+			// an index past the vertices would make the GPU read out of bounds, and narrowing would hide it
+			if (!CopyIndices(source, mesh.Header.IndexSize, count, mesh.Header.VertexCount, mesh.IndexType, staging))
+			{
+				SDL_Log("[CMeshStreamer] %s has an index past its %u vertices", mesh.Path.c_str(), mesh.Header.VertexCount);
+				// the copies recorded so far still complete, the buffers go once they have
+				RetireBuffer(mesh.VertexBuffer);
+				RetireBuffer(mesh.IndexBuffer);
+				mesh.State = EMeshState::Failed;
+				return true;
+			}
+		}
+
+		const vk::BufferCopy region = {
+			stagingBase + m_StagingOffset,
+			regionOffset,
+			bytes
+		};
+		commandBuffer.copyBuffer(m_StagingBuffer, vertexRegion ? mesh.VertexBuffer.Buffer : mesh.IndexBuffer.Buffer, 1, &region);
+
+		m_StagingOffset += bytes;
+		m_Stats.UploadedBytes += bytes;
+		mesh.UploadedBytes += bytes;
+	}
+
+	return true;
+}
+
+EMeshState CMeshStreamer::GetState(const uint32_t mesh) const
+{
+	return mesh < m_Meshes.size() && m_Meshes[mesh].InUse ? m_Meshes[mesh].State : EMeshState::Failed;
+}
+
+bool CMeshStreamer::IsReady(const uint32_t mesh) const
+{
+	return GetState(mesh) == EMeshState::Ready;
+}
+
+uint32_t CMeshStreamer::GetVertexStride(const uint32_t mesh) const
+{
+	return m_Meshes[mesh].Header.VertexStride;
+}
+
+bool CMeshStreamer::HasVertexLayout(const uint32_t mesh, const SVertexLayout& layout) const
+{
+	const SMeshFileHeader& header = m_Meshes[mesh].Header;
+	if (header.Version < 3)
+	{
+		return false;
+	}
+
+	for (uint32_t attribute = 0; attribute < kVertexAttributeCount; attribute++)
+	{
+		if (header.VertexFormats[attribute] != static_cast<uint8_t>(layout.Formats[attribute]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t CMeshStreamer::GetIndexCount(const uint32_t mesh) const
+{
+	return m_Meshes[mesh].Header.IndexCount;
+}
+
+const SMeshLod* CMeshStreamer::GetLods(const uint32_t mesh) const
+{
+	return m_Meshes[mesh].Lods;
+}
+
+uint32_t CMeshStreamer::GetLodCount(const uint32_t mesh) const
+{
+	return m_Meshes[mesh].LodCount;
+}
+
+void CMeshStreamer::Bind(const vk::CommandBuffer commandBuffer, const uint32_t mesh) const
+{
+	const SMesh& entry = m_Meshes[mesh];
+	const vk::DeviceSize offset = 0;
+
+	commandBuffer.bindVertexBuffers(0, 1, &entry.VertexBuffer.Buffer, &offset);
+	commandBuffer.bindIndexBuffer(entry.IndexBuffer.Buffer, 0, entry.IndexType);
+}
+
+const SMeshStreamingStats& CMeshStreamer::GetStats() const
+{
+	return m_Stats;
+}
+
+bool CMeshStreamer::CreateBuffer(const vk::DeviceSize size, const vk::BufferUsageFlags usage, const EMemoryCategory category, SBuffer& buffer)
+{
+	vk::Result vkResult;
+
+	const vk::BufferCreateInfo bufferCreateInfo = {
+		{},
+		size,
+		usage,
+		vk::SharingMode::eExclusive
+	};
+
+	std::tie(vkResult, buffer.Buffer) = m_Device.createBuffer(bufferCreateInfo);
+	if (vkResult != vk::Result::eSuccess)
+	{
+		buffer = SBuffer();
+		return false;
+	}
+
+	const vk::MemoryRequirements memoryRequirements = m_Device.getBufferMemoryRequirements(buffer.Buffer);
+	const vk::MemoryAllocateInfo allocInfo = {
+		memoryRequirements.size,
+		m_Memory->FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal)
+	};
+
+	if (allocInfo.memoryTypeIndex == UINT32_MAX || m_Memory->Allocate(allocInfo, category, buffer.Memory) != vk::Result::eSuccess ||
+		m_Device.bindBufferMemory(buffer.Buffer, buffer.Memory, 0) != vk::Result::eSuccess)
+	{
+		DestroyBuffer(buffer);
+		return false;
+	}
+
+	return true;
+}
+
+void CMeshStreamer::RetireBuffer(SBuffer& buffer)
+{
+	m_DeletionQueue->Destroy(buffer.Buffer);
+	m_DeletionQueue->Destroy(buffer.Memory);
+	buffer = SBuffer();
+}
+
+void CMeshStreamer::DestroyBuffer(SBuffer& buffer)
+{
+	if (buffer.Buffer)
+	{
+		m_Device.destroyBuffer(buffer.Buffer);
+	}
+	if (buffer.Memory)
+	{
+		m_Memory->Free(buffer.Memory);
+	}
+	buffer = SBuffer();
+}
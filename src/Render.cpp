@@ -3,9 +3,13 @@
 
 
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <gsl/gsl_util>
 
+#include "IndexFormat.h"
+#include "RenderDevice.h"
 #include "Viewport.h"
 #include "SDL_vulkan.h"
 #include <glm/glm.hpp>
@@ -22,37 +26,35 @@ VkBool32 VKAPI_CALL RenderDebugReportCallback(VkDebugReportFlagsEXT flags, VkDeb
 }
 #endif
 
-#define VKR(res) if((res) != vk::Result::eSuccess){return EEngineStatus::Failed;}
-
 template <typename T>
 T ClampValue(const T& n, const T& lower, const T& upper) {
 	return std::max(lower, std::min(n, upper));
 }
 
 
-struct Vertex
-{
-	glm::vec3 Position;
-	glm::vec3 Color;
-};
-
 struct UniBuffer
 {
 	float Angle;
 	float RotationSpeed;
+	// SVertexLayout::PositionScale of the scene's vertex layout
+	float PositionScale;
 };
 
-const Vertex kVertexData[] = {
+// encoded into m_VertexLayout at startup
+const SVertexInput kVertexData[] = {
 	{
 		{-0.5f, 0.5f, 0.f},
+		{0.f, 0.f, 1.f},
 		{0.f, 0.f, 1.f}
 	},
 	{
 		{0.f, -0.5f, 0.f},
+		{0.f, 0.f, 1.f},
 		{0.f, 1.f, 0.f}
 	},
 	{
 		{0.5f, 0.5f, 0.f},
+		{0.f, 0.f, 1.f},
 		{1.f, 0.f, 0.f}
 	},
 };
@@ -61,6 +63,21 @@ const uint32_t kIndexData[] = {
 	2,1,0
 };
 
+const SMeshLod kTriangleLods[] = {
+	{ 0, 3, 0.f }
+};
+
+static bool HasExtension(const std::vector<vk::ExtensionProperties>& extensions, const char* name)
+{
+	for (const vk::ExtensionProperties& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, name) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
 
 EEngineStatus CRender::Initialize()
 {
@@ -82,7 +99,15 @@ EEngineStatus CRender::Initialize()
 	const char** layers = nullptr;
 #endif
 
-	const char** extensions = new const char* [extensionCount + additionalExtensionCount];
+	// optional instance extensions
+	std::vector<vk::ExtensionProperties> instanceExtensions;
+	std::tie(vkResult, instanceExtensions) = vk::enumerateInstanceExtensionProperties();
+	VKR(vkResult);
+
+	m_HasPhysicalDeviceProperties2 = HasExtension(instanceExtensions, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	const size_t optionalExtensionCount = 1;
+
+	const char** extensions = new const char* [extensionCount + additionalExtensionCount + optionalExtensionCount];
 	auto finalExtensions = gsl::finally([&]
 		{
 			delete[] extensions;
@@ -100,9 +125,27 @@ EEngineStatus CRender::Initialize()
 
 	extensionCount += additionalExtensionCount;
 
+	if (m_HasPhysicalDeviceProperties2)
+	{
+		extensions[extensionCount++] = VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME;
+	}
+
+	// Vulkan 1.0 loaders do not export vkEnumerateInstanceVersion and reject any apiVersion above 1.0
+	uint32_t instanceVersion = VK_API_VERSION_1_0;
+	const auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+	if (enumerateInstanceVersion != nullptr && enumerateInstanceVersion(&instanceVersion) != VK_SUCCESS)
+	{
+		instanceVersion = VK_API_VERSION_1_0;
+	}
+
+	vk::ApplicationInfo applicationInfo = kRenderApplicationInfo;
+	applicationInfo.apiVersion = std::min(instanceVersion, kRenderApplicationInfo.apiVersion);
+
+	SDL_Log("[CRender] Instance version %u.%u.%u, requesting %u.%u", VK_VERSION_MAJOR(instanceVersion), VK_VERSION_MINOR(instanceVersion), VK_VERSION_PATCH(instanceVersion), VK_VERSION_MAJOR(applicationInfo.apiVersion), VK_VERSION_MINOR(applicationInfo.apiVersion));
+
 	const vk::InstanceCreateInfo instanceCreateInfo = {
 		{},
-		&kRenderApplicationInfo,
+		&applicationInfo,
 		layerCount,
 		layers,
 		extensionCount,
@@ -139,6 +182,15 @@ EEngineStatus CRender::Initialize()
 	m_Instance.debugReportMessageEXT(vk::DebugReportFlagBitsEXT::eInformation, vk::DebugReportObjectTypeEXT::eUnknown, VK_NULL_HANDLE, 0, 0, "", "Test message", m_DispatchLoader);
 #endif
 
+	VkSurfaceKHR tempSurface;
+	const SDL_bool sdlRes = SDL_Vulkan_CreateSurface(gEngine->GetViewport()->GetWindow(), m_Instance, &tempSurface);
+	if (sdlRes != SDL_TRUE)
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "CRender Error", "Unable to create VkSurfaceKHR!", gEngine->GetViewport()->GetWindow());
+		return EEngineStatus::Failed;
+	}
+	m_Surface = tempSurface;
+
 	// selecting a suitable physical device
 
 	std::vector<vk::PhysicalDevice> physicalDevices;
@@ -155,85 +207,41 @@ EEngineStatus CRender::Initialize()
 		return EEngineStatus::Failed;
 	}
 
-	vk::PhysicalDevice selPhysicalDevice = nullptr;
-	uint32_t selGraphicsFamily = 0;
+	const SEngineOptions& options = gEngine->GetOptions();
+	m_LowLatency = options.LowLatency;
+	m_UseDynamicResolution = options.DynamicResolutionTargetMs > 0.f;
+	m_DynamicResolutionTargetMs = options.DynamicResolutionTargetMs;
 
-	for (vk::PhysicalDevice& physicalDevice : physicalDevices)
+	std::vector<SPhysicalDeviceCandidate> candidates;
+	for (uint32_t index = 0; index < physicalDevices.size(); index++)
 	{
-		const vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
-		const char* vendorName;
-		switch (properties.vendorID)
-		{
-		case kVendorIdNvidia:
-			vendorName = "NVIDIA ";
-			break;
-		case kVendorIdAmd:
-			vendorName = "AMD ";
-			break;
-		default:
-			vendorName = "";
-			break;
-		}
-		SDL_Log("[CRender] Found physical device: #%x (%s%s)", properties.deviceID, vendorName, properties.deviceName);
-		m_GpuName = std::string(vendorName) + std::string(properties.deviceName);
-
-		// checking suitability
-		bool suitable = true;
-
-		suitable = suitable && ((properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu) || (properties.deviceType == vk::PhysicalDeviceType::eIntegratedGpu));
-
-		std::vector<vk::QueueFamilyProperties> queueFamilies = physicalDevice.getQueueFamilyProperties();
+		candidates.push_back(EvaluatePhysicalDevice(physicalDevices[index], index, m_Surface, m_DispatchLoader, options.SoftwareDevice));
 
-		uint32_t nGraphics = 0;
-		uint32_t idxGraphics = 0;
-		uint32_t nCompute = 0;
-		// uint32_t idxCompute;
-		uint32_t nTransfer = 0;
-		// uint32_t idxTransfer;
-		// uint32_t nPresent = 0;
-
-		uint32_t idx = 0;
-		for (auto& queueFamily : queueFamilies)
+		const SPhysicalDeviceCandidate& candidate = candidates.back();
+		if (candidate.Suitable)
 		{
-			if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
-			{
-				nGraphics++;
-				idxGraphics = idx;
-			}
-
-			if (queueFamily.queueFlags & vk::QueueFlagBits::eCompute)
-			{
-				nCompute++;
-				// idxCompute = idx;
-			}
-
-			if (queueFamily.queueFlags & vk::QueueFlagBits::eTransfer)
-			{
-				nTransfer++;
-				// idxTransfer = idx;
-			}
-
-			idx++;
+			SDL_Log("[CRender] Found physical device #%u: %s (%s), score %lld", index, candidate.Name.c_str(), vk::to_string(candidate.Type).c_str(), static_cast<long long>(candidate.Score));
 		}
-
-		suitable = suitable && (nGraphics >= 1);
-
-		if (suitable)
+		else
 		{
-			selPhysicalDevice = physicalDevice;
-			selGraphicsFamily = idxGraphics;
-			break;
+			SDL_Log("[CRender] Found physical device #%u: %s (%s), rejected: %s", index, candidate.Name.c_str(), vk::to_string(candidate.Type).c_str(), candidate.RejectReason.c_str());
 		}
 	}
 
-	if (!selPhysicalDevice)
+	const SPhysicalDeviceCandidate* selCandidate = SelectPhysicalDevice(candidates, options.Device);
+
+	if (selCandidate == nullptr)
 	{
 		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "CRender Error", "No compatible device found!", gEngine->GetViewport()->GetWindow());
 		return EEngineStatus::Failed;
 	}
+
+	const vk::PhysicalDevice selPhysicalDevice = selCandidate->Device;
+	const uint32_t selGraphicsFamily = selCandidate->GraphicsFamily;
 	m_PhysicalDevice = selPhysicalDevice;
+	m_GpuName = selCandidate->Name;
 
-	SDL_Log("[CRender] Selected physical device: #%x", selPhysicalDevice.getProperties().deviceID);
+	SDL_Log("[CRender] Selected physical device #%u: %s", selCandidate->Index, m_GpuName.c_str());
 
 	// creating a logical device
 
@@ -246,19 +254,60 @@ EEngineStatus CRender::Initialize()
 		&queuePriority
 	};
 
-	const char* deviceExtArray[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+	std::vector<vk::ExtensionProperties> deviceExtensions;
+	std::tie(vkResult, deviceExtensions) = selPhysicalDevice.enumerateDeviceExtensionProperties();
+	VKR(vkResult);
+
+	std::vector<const char*> deviceExtArray = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+	const bool hasMemoryBudget = m_HasPhysicalDeviceProperties2 && HasExtension(deviceExtensions, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (hasMemoryBudget)
+	{
+		deviceExtArray.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	// S2: optional features used for GPU instrumentation
+	const vk::PhysicalDeviceFeatures supportedFeatures = selPhysicalDevice.getFeatures();
+	vk::PhysicalDeviceFeatures enabledFeatures;
+	enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+	enabledFeatures.occlusionQueryPrecise = supportedFeatures.occlusionQueryPrecise;
+
+	// S3: timeline semaphores and descriptor indexing are core in Vulkan 1.2 but remain optional features
+	const uint32_t deviceVersion = std::min(selPhysicalDevice.getProperties().apiVersion, applicationInfo.apiVersion);
+
+	vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+	vk::PhysicalDeviceDescriptorIndexingFeatures indexingFeatures;
+	if (deviceVersion >= VK_API_VERSION_1_2)
+	{
+		vk::PhysicalDeviceFeatures2 supportedFeatures2;
+		supportedFeatures2.pNext = &timelineFeatures;
+		timelineFeatures.pNext = &indexingFeatures;
+		selPhysicalDevice.getFeatures2(&supportedFeatures2, m_DispatchLoader);
+	}
+	const bool useTimelineSemaphores = timelineFeatures.timelineSemaphore;
+	m_UseBindless = options.Bindless && CRenderBindless::IsSupported(indexingFeatures);
+
+	vk::PhysicalDeviceTimelineSemaphoreFeatures enabledTimelineFeatures;
+	enabledTimelineFeatures.timelineSemaphore = useTimelineSemaphores;
+	vk::PhysicalDeviceDescriptorIndexingFeatures enabledIndexingFeatures = m_UseBindless ? CRenderBindless::GetRequiredFeatures() : vk::PhysicalDeviceDescriptorIndexingFeatures();
+	enabledTimelineFeatures.pNext = &enabledIndexingFeatures;
 
-	const vk::DeviceCreateInfo deviceCreateInfo = {
+	vk::DeviceCreateInfo deviceCreateInfo = {
 		{},
 		1,
 		&deviceQueueCreateInfo,
 		0,
 		nullptr,
-		1,
-		deviceExtArray,
-		{}
+		static_cast<uint32_t>(deviceExtArray.size()),
+		deviceExtArray.data(),
+		&enabledFeatures
 	};
 
+	if (deviceVersion >= VK_API_VERSION_1_2)
+	{
+		deviceCreateInfo.pNext = &enabledTimelineFeatures;
+	}
+
 	std::tie(vkResult, m_Device) = selPhysicalDevice.createDevice(deviceCreateInfo);
 
 	if (vkResult != vk::Result::eSuccess)
@@ -267,23 +316,24 @@ EEngineStatus CRender::Initialize()
 		return EEngineStatus::Failed;
 	}
 
+	// device-level entry points, including the 1.2 semaphore functions
+	m_DispatchLoader.init(m_Instance, vkGetInstanceProcAddr, m_Device, vkGetDeviceProcAddr);
+
 	m_GraphicsQueue = m_Device.getQueue(selGraphicsFamily, 0);
 
-	VkSurfaceKHR tempSurface;
-	const SDL_bool sdlRes = SDL_Vulkan_CreateSurface(gEngine->GetViewport()->GetWindow(), m_Instance, &tempSurface);
-	if (sdlRes != SDL_TRUE)
+	m_Memory.Initialize(selPhysicalDevice, m_Device, hasMemoryBudget, &m_DispatchLoader);
+
+	if (m_Sync.Initialize(m_Device, useTimelineSemaphores, &m_DispatchLoader) != EEngineStatus::Ok)
 	{
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "CRender Error", "Unable to create VkSurfaceKHR!", gEngine->GetViewport()->GetWindow());
 		return EEngineStatus::Failed;
 	}
-	m_Surface = tempSurface;
+	m_Sync.SetQueue(ERenderQueue::Graphics, m_GraphicsQueue);
 
-	// check presentation support
-	if (!(selPhysicalDevice.getSurfaceSupportKHR(selGraphicsFamily, m_Surface, m_DispatchLoader).value))
+	if (m_UseBindless && m_Bindless.Initialize(selPhysicalDevice, m_Device, &m_Sync, &m_DispatchLoader) != EEngineStatus::Ok)
 	{
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "CRender Error", "VkSurfaceKHR does not support presentation!", gEngine->GetViewport()->GetWindow());
 		return EEngineStatus::Failed;
 	}
+	SDL_Log("[CRender] Bindless resource table %s", m_UseBindless ? "enabled" : "unavailable, using per-frame descriptor sets");
 
 	// query swap chain support data
 	SDL_Log("[CRender] Querying swap chain support data...");
@@ -383,7 +433,6 @@ EEngineStatus CRender::Initialize()
 	m_SwapChainFormat = selSurfaceFormat.format;
 
 	m_SwapChainImageViews.resize(swapChainImages.size());
-	m_SwapChainFrameBuffers.resize(swapChainImages.size());
 
 	uint32_t i = 0;
 	for (auto& swapChainImage : swapChainImages)
@@ -413,158 +462,108 @@ EEngineStatus CRender::Initialize()
 		i++;
 	}
 
+	// the MSAA level is clamped to what both color and depth attachments support
+	const vk::PhysicalDeviceLimits& limits = m_PhysicalDevice.getProperties().limits;
+	const vk::SampleCountFlags supportedSampleCounts = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+	m_SampleCount = vk::SampleCountFlagBits::e1;
+	for (uint32_t samples = 2; samples <= options.Msaa; samples *= 2)
 	{
-		// creating the first render pass
-		vk::AttachmentDescription colorAttachment = {
-			{},
-			m_SwapChainFormat,
-			vk::SampleCountFlagBits::e1,
-			vk::AttachmentLoadOp::eClear,
-			vk::AttachmentStoreOp::eStore,
-			vk::AttachmentLoadOp::eDontCare,
-			vk::AttachmentStoreOp::eDontCare,
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::ePresentSrcKHR
-		};
-
-		vk::AttachmentReference colorAttachmentRef = {
-			0,
-			vk::ImageLayout::eColorAttachmentOptimal
-		};
-
-		vk::SubpassDescription subPassDesc = {
-			{},
-			vk::PipelineBindPoint::eGraphics,
-			0,
-			nullptr,
-			1,
-			&colorAttachmentRef
-		};
-
-		vk::SubpassDependency dependency = {
-			0,
-			VK_SUBPASS_EXTERNAL,
-			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			vk::PipelineStageFlagBits::eBottomOfPipe,
-			vk::AccessFlagBits::eColorAttachmentWrite,
-			{},
-			vk::DependencyFlagBits::eByRegion
-		};
-
-		vk::RenderPassCreateInfo renderPassCreateInfo = {
-			{},
-			1,
-			&colorAttachment,
-			1,
-			&subPassDesc,
-			1,
-			&dependency
-		};
-
-		std::tie(vkResult, m_RenderPass1) = m_Device.createRenderPass(renderPassCreateInfo);
-		VKR(vkResult);
+		if (supportedSampleCounts & static_cast<vk::SampleCountFlagBits>(samples))
+		{
+			m_SampleCount = static_cast<vk::SampleCountFlagBits>(samples);
+		}
 	}
+	const bool multisampled = m_SampleCount != vk::SampleCountFlagBits::e1;
 
+	// D16 is always supported, the others are preferred for their precision
+	const vk::Format depthCandidates[] = { vk::Format::eD32Sfloat, vk::Format::eX8D24UnormPack32, vk::Format::eD24UnormS8Uint, vk::Format::eD16Unorm };
+	for (const vk::Format format : depthCandidates)
 	{
-		// creating the ImGui render pass
-		vk::AttachmentDescription colorAttachment = {
-			{},
-			m_SwapChainFormat,
-			vk::SampleCountFlagBits::e1,
-			vk::AttachmentLoadOp::eDontCare,
-			vk::AttachmentStoreOp::eStore,
-			vk::AttachmentLoadOp::eDontCare,
-			vk::AttachmentStoreOp::eDontCare,
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::ePresentSrcKHR
-		};
+		if (m_PhysicalDevice.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment)
+		{
+			m_DepthFormat = format;
+			break;
+		}
+	}
 
-		vk::AttachmentReference colorAttachmentRef = {
-			0,
-			vk::ImageLayout::eColorAttachmentOptimal
-		};
+	// describing the frame: the scene pass renders into the swap chain image, through a transient
+	// multisampled target with MSAA, and the ImGui pass draws over it. With dynamic resolution the scene
+	// renders into an offscreen image instead, which the upscale pass samples
+	if (m_RenderGraph.Initialize(m_PhysicalDevice, m_Device, &m_Memory) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-		vk::SubpassDescription subPassDesc = {
-			{},
-			vk::PipelineBindPoint::eGraphics,
-			0,
-			nullptr,
-			1,
-			&colorAttachmentRef
-		};
+	// the image acquisition semaphore is waited on at the color attachment output stage
+	const uint32_t swapChainTarget = m_RenderGraph.ImportImage("Swap chain", m_SwapChainFormat, m_SwapChainExtent, m_SwapChainImageViews, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::ImageLayout::ePresentSrcKHR);
+	const uint32_t depthImage = m_RenderGraph.CreateImage("Depth", { m_DepthFormat, m_SwapChainExtent, m_SampleCount });
 
-		vk::SubpassDependency dependency = {
-			0,
-			VK_SUBPASS_EXTERNAL,
-			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			vk::PipelineStageFlagBits::eBottomOfPipe,
-			vk::AccessFlagBits::eColorAttachmentWrite,
-			{},
-			vk::DependencyFlagBits::eByRegion
-		};
+	const vk::ClearColorValue clearColor(std::array<float, 4>{0, 0, 0, 1.f});
 
-		vk::RenderPassCreateInfo renderPassCreateInfo = {
-			{},
-			1,
-			&colorAttachment,
-			1,
-			&subPassDesc,
-			1,
-			&dependency
-		};
+	// the scene attachments keep the full size, only the rendered part of them shrinks
+	m_DynamicResolution.Initialize(m_SwapChainExtent);
+	m_SceneExtent = m_SwapChainExtent;
+	m_SceneOutput = m_UseDynamicResolution ? m_RenderGraph.CreateImage("Scene output", { m_SwapChainFormat, m_SwapChainExtent }) : swapChainTarget;
 
-		std::tie(vkResult, m_RenderPassImGui) = m_Device.createRenderPass(renderPassCreateInfo);
-		VKR(vkResult);
+	m_ScenePass = m_RenderGraph.AddPass("Scene");
+	if (multisampled)
+	{
+		const uint32_t colorImage = m_RenderGraph.CreateImage("Scene color", { m_SwapChainFormat, m_SwapChainExtent, m_SampleCount });
+		m_RenderGraph.AddColorAttachment(m_ScenePass, colorImage, vk::AttachmentLoadOp::eClear, clearColor, m_SceneOutput);
 	}
-
-
-	i = 0;
-
-	// creating the framebuffers
-	for (vk::ImageView& swapChainImageView : m_SwapChainImageViews)
+	else
 	{
-		vk::ImageView attachments[] = {
-			swapChainImageView
-		};
+		m_RenderGraph.AddColorAttachment(m_ScenePass, m_SceneOutput, vk::AttachmentLoadOp::eClear, clearColor);
+	}
+	m_RenderGraph.SetDepthAttachment(m_ScenePass, depthImage, vk::AttachmentLoadOp::eClear, vk::ClearDepthStencilValue(1.f, 0));
 
-		vk::FramebufferCreateInfo frameBufferCreateInfo = {
-			{},
-			m_RenderPass1,
-			1,
-			attachments,
-			m_SwapChainExtent.width,
-			m_SwapChainExtent.height,
-			1
-		};
+	if (m_UseDynamicResolution)
+	{
+		// every pixel of the swap chain image is written, its previous contents are not needed
+		m_UpscalePass = m_RenderGraph.AddPass("Upscale");
+		m_RenderGraph.AddAccess(m_UpscalePass, m_SceneOutput, ERenderGraphAccess::Sampled);
+		m_RenderGraph.AddColorAttachment(m_UpscalePass, swapChainTarget, vk::AttachmentLoadOp::eDontCare);
+	}
 
-		std::tie(vkResult, m_SwapChainFrameBuffers[i]) = m_Device.createFramebuffer(frameBufferCreateInfo);
-		VKR(vkResult);
+	m_ImGuiPass = m_RenderGraph.AddPass("ImGui");
+	m_RenderGraph.AddColorAttachment(m_ImGuiPass, swapChainTarget, vk::AttachmentLoadOp::eLoad);
 
-		i++;
+	if (m_RenderGraph.Compile() != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
 	}
 
-	// creating the uniform buffer
+	// creating the uniform buffers, persistently mapped; the bindless path reads them as storage buffers
 	vk::BufferCreateInfo uniformBufferCreateInfo = {
 		{},
 		sizeof(UniBuffer),
-		vk::BufferUsageFlagBits::eUniformBuffer,
+		m_UseBindless ? vk::BufferUsageFlagBits::eStorageBuffer : vk::BufferUsageFlagBits::eUniformBuffer,
 		vk::SharingMode::eExclusive,
 		1,
 		&selGraphicsFamily
 	};
 
-	std::tie(vkResult, m_UniformBuffer) = m_Device.createBuffer(uniformBufferCreateInfo);
-
 	vk::MemoryRequirements memoryRequirements;
-	memoryRequirements = m_Device.getBufferMemoryRequirements(m_UniformBuffer);
 
-	vk::MemoryAllocateInfo uniformBufferAllocInfo = {
-		memoryRequirements.size,
-		FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
-	};
+	for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+	{
+		std::tie(vkResult, m_UniformBuffers[slot]) = m_Device.createBuffer(uniformBufferCreateInfo);
+		VKR(vkResult);
+
+		memoryRequirements = m_Device.getBufferMemoryRequirements(m_UniformBuffers[slot]);
+
+		vk::MemoryAllocateInfo uniformBufferAllocInfo = {
+			memoryRequirements.size,
+			FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+		};
 
-	std::tie(vkResult, m_UniformBufferMemory) = m_Device.allocateMemory(uniformBufferAllocInfo);
-	vkResult = m_Device.bindBufferMemory(m_UniformBuffer, m_UniformBufferMemory, 0);
+		vkResult = m_Memory.Allocate(uniformBufferAllocInfo, EMemoryCategory::Uniform, m_UniformBufferMemory[slot]);
+		VKR(vkResult);
+		vkResult = m_Device.bindBufferMemory(m_UniformBuffers[slot], m_UniformBufferMemory[slot], 0);
+		VKR(vkResult);
+		vkResult = m_Device.mapMemory(m_UniformBufferMemory[slot], 0, sizeof(UniBuffer), {}, &m_UniformBufferMapped[slot]);
+		VKR(vkResult);
+	}
 
 	// loading the shaders
 	if (LoadShadersTriangle() != EEngineStatus::Ok)
@@ -574,37 +573,38 @@ EEngineStatus CRender::Initialize()
 
 	// creating the pipeline
 
-	// S1: IA
-	vk::VertexInputBindingDescription bindingDesc[] = {
-		{
-		0, // binding number
-		24, // sizeof(vec3) * 2 (see triangle.vert)
-		vk::VertexInputRate::eVertex
-		}
-	};
+	// validated by the option parser
+	m_VertexLayout = *FindVertexLayout(options.VertexLayout);
+	SDL_Log("[CRender] Vertex layout: %s, %u bytes per vertex", m_VertexLayout.Name, m_VertexLayout.GetStride());
 
-	vk::VertexInputAttributeDescription attrDesc[] = {
-		// in vec3 inPosition
-		{
-		0,
-		0,
-		vk::Format::eR32G32B32Sfloat,
-		0
-		},
-		// in vec3 inColor
-		{
-		1,
-		0,
-		vk::Format::eR32G32B32Sfloat,
-		12
-		}
-	};
+	// S1: IA, locations follow EVertexAttribute and then ESceneStream (see triangle.vert)
+	vk::VertexInputBindingDescription bindingDesc[1 + kSceneStreamCount];
+	vk::VertexInputAttributeDescription attrDesc[kVertexAttributeCount + kSceneStreamCount];
+
+	bindingDesc[0] = m_VertexLayout.GetBindingDescription(0);
+	m_VertexLayout.GetAttributeDescriptions(0, attrDesc);
+
+	// every scene stream is its own per-instance binding, read straight from the SoA arrays
+	for (uint32_t stream = 0; stream < kSceneStreamCount; stream++)
+	{
+		bindingDesc[1 + stream] = {
+			1 + stream,
+			sizeof(float),
+			vk::VertexInputRate::eInstance
+		};
+		attrDesc[kVertexAttributeCount + stream] = {
+			kVertexAttributeCount + stream,
+			1 + stream,
+			vk::Format::eR32Sfloat,
+			0
+		};
+	}
 
 	vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
 		{},
-		1,
+		1 + kSceneStreamCount,
 		bindingDesc,
-		2,
+		kVertexAttributeCount + kSceneStreamCount,
 		attrDesc
 	};
 
@@ -637,6 +637,15 @@ EEngineStatus CRender::Initialize()
 		&scissor
 	};
 
+	// set per frame to the scene extent, which dynamic resolution changes without a new pipeline
+	const vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+
+	vk::PipelineDynamicStateCreateInfo dynamicStateCreateInfo = {
+		{},
+		2,
+		dynamicStates
+	};
+
 	vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {
 		{},
 		false,
@@ -653,7 +662,17 @@ EEngineStatus CRender::Initialize()
 
 	vk::PipelineMultisampleStateCreateInfo multisampleStateCreateInfo = {
 		{},
-		vk::SampleCountFlagBits::e1,
+		m_SampleCount,
+		false
+	};
+
+	// the fragment shader does not write depth, so the test runs before shading
+	vk::PipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo = {
+		{},
+		true,
+		true,
+		vk::CompareOp::eLess,
+		false,
 		false
 	};
 
@@ -700,51 +719,45 @@ EEngineStatus CRender::Initialize()
 		&m_DescriptorSetLayout
 	};
 
-	std::tie(vkResult, m_PipelineLayout) = m_Device.createPipelineLayout(pipelineLayoutCreateInfo);
-
-	// creating the descriptor pool
-
-	vk::DescriptorPoolSize descriptorPoolSizes[] = {
-		{vk::DescriptorType::eUniformBuffer, 1000},
-		{vk::DescriptorType::eCombinedImageSampler, 1000}
-	};
-
-	vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo = {
-		{},
-		5,
-		2,
-		descriptorPoolSizes
-	};
-
-	std::tie(vkResult, m_DescriptorPool) = m_Device.createDescriptorPool(descriptorPoolCreateInfo);
+	// the bindless pipeline only sees the resource table and the per-draw indices
+	const vk::DescriptorSetLayout bindlessSetLayout = m_Bindless.GetSetLayout();
+	const vk::PushConstantRange bindlessPushConstantRange = m_Bindless.GetPushConstantRange();
+	if (m_UseBindless)
+	{
+		pipelineLayoutCreateInfo.pSetLayouts = &bindlessSetLayout;
+		pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		pipelineLayoutCreateInfo.pPushConstantRanges = &bindlessPushConstantRange;
+	}
 
-	vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo = {
-		m_DescriptorPool,
-		1,
-		&m_DescriptorSetLayout
-	};
+	std::tie(vkResult, m_PipelineLayout) = m_Device.createPipelineLayout(pipelineLayoutCreateInfo);
 
-	std::vector<vk::DescriptorSet> descriptorSets;
-	std::tie(vkResult, descriptorSets) = m_Device.allocateDescriptorSets(descriptorSetAllocateInfo);
-	m_DescriptorSet = descriptorSets[0];
+	// the descriptor sets come from pool chains that grow on demand, through a cache on the draw path
+	if (m_Descriptors.Initialize(m_Device) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-	vk::DescriptorBufferInfo descriptorBufferInfo = {
-		m_UniformBuffer,
-		0,
-		sizeof(UniBuffer)
-	};
+	if (m_DescriptorCache.Initialize(m_Device, &m_Descriptors, &m_Sync) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-	vk::WriteDescriptorSet descriptorWrite = {
-		m_DescriptorSet,
-		0,
-		0,
-		1,
-		vk::DescriptorType::eUniformBuffer,
-		nullptr,
-		&descriptorBufferInfo
-	};
+	if (m_DeletionQueue.Initialize(m_Device, &m_Memory, &m_Sync, &m_DescriptorCache) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-	m_Device.updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+	if (m_UseBindless)
+	{
+		for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+		{
+			m_UniformBufferIndices[slot] = m_Bindless.RegisterBuffer(m_UniformBuffers[slot], 0, sizeof(UniBuffer));
+			if (m_UniformBufferIndices[slot] == kBindlessInvalidIndex)
+			{
+				return EEngineStatus::Failed;
+			}
+		}
+	}
 
 	// S4: shader stages
 	vk::PipelineShaderStageCreateInfo vertShaderStageInfo = {
@@ -774,11 +787,11 @@ EEngineStatus CRender::Initialize()
 		&viewportStateCreateInfo,
 		&rasterizationStateCreateInfo,
 		&multisampleStateCreateInfo,
-		nullptr,
+		&depthStencilStateCreateInfo,
 		&colorBlendStateCreateInfo,
-		nullptr,
+		&dynamicStateCreateInfo,
 		m_PipelineLayout,
-		m_RenderPass1,
+		m_RenderGraph.GetRenderPass(m_ScenePass),
 		0,
 		nullptr,
 		-1
@@ -792,11 +805,20 @@ EEngineStatus CRender::Initialize()
 		return EEngineStatus::Failed;
 	}
 
+	if (m_UseDynamicResolution && CreateUpscalePipeline() != EEngineStatus::Ok)
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "CRender Error", "Unable to create the upscale pipeline!", gEngine->GetViewport()->GetWindow());
+		return EEngineStatus::Failed;
+	}
+
 	// creating the vertex buffer
 
+	const uint32_t vertexStride = m_VertexLayout.GetStride();
+	const uint32_t vertexCount = static_cast<uint32_t>(sizeof(kVertexData) / sizeof(kVertexData[0]));
+
 	vk::BufferCreateInfo vertexBufferCreateInfo = {
 		{},
-		sizeof(kVertexData),
+		vertexStride * vertexCount,
 		vk::BufferUsageFlagBits::eVertexBuffer,
 		vk::SharingMode::eExclusive
 	};
@@ -813,23 +835,29 @@ EEngineStatus CRender::Initialize()
 		FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
 	};
 
-	std::tie(vkResult, m_VertexBufferMemory) = m_Device.allocateMemory(vertexBufferAllocInfo);
+	vkResult = m_Memory.Allocate(vertexBufferAllocInfo, EMemoryCategory::Vertex, m_VertexBufferMemory);
 	VKR(vkResult);
 	vkResult = m_Device.bindBufferMemory(m_VertexBuffer, m_VertexBufferMemory, 0);
 	VKR(vkResult);
 
-	// copy the vertex data
+	// encode the vertex data
 	void* pVertexDataDest;
-	vkResult = m_Device.mapMemory(m_VertexBufferMemory, 0, sizeof(kVertexData), {}, &pVertexDataDest);
+	vkResult = m_Device.mapMemory(m_VertexBufferMemory, 0, VK_WHOLE_SIZE, {}, &pVertexDataDest);
 	VKR(vkResult);
-	memcpy(pVertexDataDest, kVertexData, sizeof(kVertexData));
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		m_VertexLayout.Encode(kVertexData[vertex], static_cast<uint8_t*>(pVertexDataDest) + vertex * vertexStride);
+	}
 	m_Device.unmapMemory(m_VertexBufferMemory);
 
 	// creating the index buffer
 
+	const uint32_t indexCount = static_cast<uint32_t>(sizeof(kIndexData) / sizeof(kIndexData[0]));
+	m_IndexType = SelectIndexType(vertexCount);
+
 	vk::BufferCreateInfo indexBufferCreateInfo = {
 		{},
-		sizeof(kIndexData),
+		indexCount * GetIndexSize(m_IndexType),
 		vk::BufferUsageFlagBits::eIndexBuffer,
 		vk::SharingMode::eExclusive
 	};
@@ -844,88 +872,130 @@ EEngineStatus CRender::Initialize()
 		FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
 	};
 
-	std::tie(vkResult, m_IndexBufferMemory) = m_Device.allocateMemory(indexBufferAllocInfo);
+	vkResult = m_Memory.Allocate(indexBufferAllocInfo, EMemoryCategory::Index, m_IndexBufferMemory);
 	VKR(vkResult);
 	vkResult = m_Device.bindBufferMemory(m_IndexBuffer, m_IndexBufferMemory, 0);
 	VKR(vkResult);
 
 	// copy the index data
 	void* pIndexDataDest;
-	vkResult = m_Device.mapMemory(m_IndexBufferMemory, 0, sizeof(kIndexData), {}, &pIndexDataDest);
+	vkResult = m_Device.mapMemory(m_IndexBufferMemory, 0, VK_WHOLE_SIZE, {}, &pIndexDataDest);
 	VKR(vkResult);
-	memcpy(pIndexDataDest, kIndexData, sizeof(kIndexData));
+	EncodeIndices(kIndexData, indexCount, m_IndexType, pIndexDataDest);
 	m_Device.unmapMemory(m_IndexBufferMemory);
 
-	// creating the semaphores
-	vk::SemaphoreCreateInfo semaphoreCreateInfo;
-	std::tie(vkResult, m_ImageAvailableSemaphore) = m_Device.createSemaphore(semaphoreCreateInfo);
-	VKR(vkResult);
-	std::tie(vkResult, m_RenderFinished1Semaphore) = m_Device.createSemaphore(semaphoreCreateInfo);
-	VKR(vkResult);
-	std::tie(vkResult, m_RenderFinished2Semaphore) = m_Device.createSemaphore(semaphoreCreateInfo);
-	VKR(vkResult);
+	// populating the scene; without --objects a single object at the origin keeps the classic spinning triangle
+	// .vkmesh files carry no bounds, so a streamed scene mesh is culled with the triangle's sphere
+	float meshRadius = 0.f;
+	for (const SVertexInput& vertex : kVertexData)
+	{
+		meshRadius = std::max(meshRadius, glm::length(vertex.Position));
+	}
 
-	// creating the command pool
-	vk::CommandPoolCreateInfo poolCreateInfo = {
-		vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		selGraphicsFamily
-	};
-	std::tie(vkResult, m_CommandPool) = m_Device.createCommandPool(poolCreateInfo);
-	VKR(vkResult);
+	if (options.SceneObjects == 0)
+	{
+		m_Scene.AddObject({ 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, 0.f, 0.f, 1.f, meshRadius);
+	}
+	else
+	{
+		m_Scene.Spawn(options.SceneObjects, 1, meshRadius);
+	}
 
-	// creating the command buffers
-	vk::CommandBufferAllocateInfo allocateInfo = {
-		m_CommandPool,
-		vk::CommandBufferLevel::ePrimary,
-		static_cast<uint32_t>(m_SwapChainImageViews.size())
-	};
-
-	std::tie(vkResult, m_CommandBuffers) = m_Device.allocateCommandBuffers(allocateInfo);
-	VKR(vkResult);
+	// creating the instance buffers, persistently mapped, with the scene streams stored back to back
+	m_InstanceStreamCapacity = m_Scene.GetPaddedObjectCount();
+	m_VisibleObjects.resize(m_Scene.GetObjectCount());
+	m_LodOrderedObjects.resize(m_Scene.GetObjectCount());
 
-	// recording the command buffers
-	i = 0;
-	for (vk::CommandBuffer& commandBuffer : m_CommandBuffers)
+	if (m_Culler.Initialize(gEngine->GetJobSystem()) != EEngineStatus::Ok)
 	{
-		vk::CommandBufferBeginInfo cbBeginInfo = {};
+		return EEngineStatus::Failed;
+	}
 
-		vkResult = commandBuffer.begin(cbBeginInfo);
+	const vk::BufferCreateInfo instanceBufferCreateInfo = {
+		{},
+		kSceneStreamCount * m_InstanceStreamCapacity * sizeof(float),
+		vk::BufferUsageFlagBits::eVertexBuffer,
+		vk::SharingMode::eExclusive
+	};
+
+	for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+	{
+		std::tie(vkResult, m_InstanceBuffers[slot]) = m_Device.createBuffer(instanceBufferCreateInfo);
 		VKR(vkResult);
 
-		vk::ClearColorValue clearColor(std::array<float, 4>{0, 0, 0, 1.f});
-		vk::ClearValue clearValue(clearColor);
+		memoryRequirements = m_Device.getBufferMemoryRequirements(m_InstanceBuffers[slot]);
 
-		vk::RenderPassBeginInfo beginInfo = {
-			m_RenderPass1,
-			m_SwapChainFrameBuffers[i],
-			{
-				{0, 0},
-				m_SwapChainExtent
-			},
-			1,
-			&clearValue
+		vk::MemoryAllocateInfo instanceBufferAllocInfo = {
+			memoryRequirements.size,
+			FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
 		};
 
-		commandBuffer.beginRenderPass(beginInfo, vk::SubpassContents::eInline);
+		vkResult = m_Memory.Allocate(instanceBufferAllocInfo, EMemoryCategory::Vertex, m_InstanceBufferMemory[slot]);
+		VKR(vkResult);
+		vkResult = m_Device.bindBufferMemory(m_InstanceBuffers[slot], m_InstanceBufferMemory[slot], 0);
+		VKR(vkResult);
 
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_Pipeline);
+		void* instanceBufferMapped;
+		vkResult = m_Device.mapMemory(m_InstanceBufferMemory[slot], 0, VK_WHOLE_SIZE, {}, &instanceBufferMapped);
+		VKR(vkResult);
+		m_InstanceBufferMapped[slot] = static_cast<float*>(instanceBufferMapped);
+	}
 
-		vk::Buffer vertexBuffers[] = { m_VertexBuffer };
-		vk::DeviceSize offsets[] = { 0 };
-		commandBuffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
+	// creating the GPU profiler, queries are indexed by frame slot
+	if (m_Profiler.Initialize(selPhysicalDevice, m_Device, selGraphicsFamily, kMaxFramesInFlight, enabledFeatures) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-		commandBuffer.bindIndexBuffer(m_IndexBuffer, 0, vk::IndexType::eUint32);
+	// creating the command pool
+	vk::CommandPoolCreateInfo poolCreateInfo = {
+		vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		selGraphicsFamily
+	};
+	std::tie(vkResult, m_CommandPool) = m_Device.createCommandPool(poolCreateInfo);
+	VKR(vkResult);
 
-		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+	// creating the command buffers
+	vk::CommandBufferAllocateInfo allocateInfo = {
+		m_CommandPool,
+		vk::CommandBufferLevel::ePrimary,
+		kMaxFramesInFlight
+	};
 
-		commandBuffer.drawIndexed(3, 1, 0, 0, 0);
+	vkResult = m_Device.allocateCommandBuffers(&allocateInfo, m_CommandBuffers);
+	VKR(vkResult);
 
-		commandBuffer.endRenderPass();
+	if (m_TextureStreamer.Initialize(m_Device, &m_Memory, &m_Sync, &m_DeletionQueue, m_UseBindless ? &m_Bindless : nullptr) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-		vkResult = commandBuffer.end();
-		VKR(vkResult);
+	if (m_MeshStreamer.Initialize(m_Device, &m_Memory, &m_Sync, &m_DeletionQueue) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
 
-		i++;
+	if (!gEngine->GetOptions().Texture.empty())
+	{
+		// only the bindless shaders sample it, a missing texture leaves the vertex colors
+		if (m_UseBindless)
+		{
+			m_SceneTexture = m_TextureStreamer.Load(gEngine->GetOptions().Texture);
+		}
+		else
+		{
+			SDL_Log("[CRender] --texture needs the bindless table, %s is not loaded", gEngine->GetOptions().Texture.c_str());
+		}
+	}
+
+	if (!gEngine->GetOptions().Mesh.empty())
+	{
+		// a missing mesh is not fatal, the triangle is drawn instead
+		m_SceneMesh = m_MeshStreamer.Load(gEngine->GetOptions().Mesh);
+		if (m_SceneMesh != kInvalidMesh && !m_MeshStreamer.HasVertexLayout(m_SceneMesh, m_VertexLayout))
+		{
+			SDL_Log("[CRender] %s is not encoded with the %s vertex layout, drawing the triangle instead", gEngine->GetOptions().Mesh.c_str(), m_VertexLayout.Name);
+		}
 	}
 
 	// >>> ImGui
@@ -938,28 +1008,21 @@ EEngineStatus CRender::Initialize()
 	implVulkanInitInfo.QueueFamily = selGraphicsFamily;
 	implVulkanInitInfo.Queue = m_GraphicsQueue;
 	implVulkanInitInfo.PipelineCache = nullptr;
-	implVulkanInitInfo.DescriptorPool = m_DescriptorPool;
+	// the backend allocates and frees its own sets, so it gets a pool of its own
+	implVulkanInitInfo.DescriptorPool = m_Descriptors.CreateDedicatedPool(kImGuiDescriptorSets);
 	implVulkanInitInfo.MinImageCount = 3;
 	implVulkanInitInfo.ImageCount = 3;
 	implVulkanInitInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 	implVulkanInitInfo.Allocator = nullptr;
 
-	ImGui_ImplVulkan_Init(&implVulkanInitInfo, m_RenderPassImGui);
-
-	const vk::CommandBufferAllocateInfo imGuiCbInfo = {
-		m_CommandPool,
-		vk::CommandBufferLevel::ePrimary,
-		static_cast<uint32_t>(m_SwapChainImageViews.size())
-	};
-
-	std::tie(vkResult, m_CommandBuffersImGui) = m_Device.allocateCommandBuffers(imGuiCbInfo);
+	ImGui_ImplVulkan_Init(&implVulkanInitInfo, m_RenderGraph.GetRenderPass(m_ImGuiPass));
 
 	// <<<
 
 	// >>> ImGui Fonts
 
 	{
-		vk::CommandBuffer cb = m_CommandBuffersImGui[0];
+		vk::CommandBuffer cb = m_CommandBuffers[0];
 		vkResult = cb.reset(vk::CommandBufferResetFlagBits::eReleaseResources);
 
 		vk::CommandBufferBeginInfo cbBeginInfo = {
@@ -971,19 +1034,11 @@ EEngineStatus CRender::Initialize()
 
 		vkResult = cb.end();
 
-		vk::SubmitInfo cbSubmitInfo = {
-			0,
-			nullptr,
-			nullptr,
-			1,
-			&cb,
-			0,
-			nullptr
-		};
-
-		vkResult = m_GraphicsQueue.submit(1, &cbSubmitInfo, nullptr);
-
-		vkResult = m_Device.waitIdle();
+		const uint64_t uploadValue = m_Sync.Submit(ERenderQueue::Graphics, &cb, 1);
+		if (uploadValue == 0 || m_Sync.WaitForQueueValue(ERenderQueue::Graphics, uploadValue) != EEngineStatus::Ok)
+		{
+			return EEngineStatus::Failed;
+		}
 	}
 
 	// <<<
@@ -996,22 +1051,122 @@ inline float Lerp(const float a, const float b, const float f)
 	return a + f * (b - a);
 }
 
-EEngineStatus CRender::Update(const float deltaTime)
+void CRender::Simulate(const float timeStep)
 {
+	// exponential approach of the actual speed towards the requested one, independent of the tick rate
+	const float speedResponse = 1.f - std::exp(-timeStep / kRotationSpeedTimeConstant);
+
 	m_RotationSpeed = ClampValue(m_RotationSpeed, 0.f, 100000.f);
-	m_ActualRotationSpeed = Lerp(m_ActualRotationSpeed, m_RotationSpeed, 0.0005f);
+	m_ActualRotationSpeed = Lerp(m_ActualRotationSpeed, m_RotationSpeed, speedResponse);
 	m_ActualRotationSpeed = ClampValue(m_ActualRotationSpeed, 0.f, 100000.f);
+
+	m_PreviousAngle = m_Angle;
+	m_Angle += m_ActualRotationSpeed * timeStep;
+
+	m_Scene.Simulate(timeStep, gEngine->GetJobSystem());
+
 	if (m_Angle >= 360.f)
 	{
-		m_Angle = 0.f;
+		// both ends of the interpolation are wrapped so that the rendered angle does not sweep back
+		const float turns = std::floor(m_Angle / 360.f) * 360.f;
+		m_Angle -= turns;
+		m_PreviousAngle -= turns;
+	}
+}
+
+EEngineStatus CRender::Throttle()
+{
+	if (!m_LowLatency || m_Sync.GetFrame() == 0)
+	{
+		return EEngineStatus::Ok;
 	}
 
-	m_Angle += m_ActualRotationSpeed * deltaTime;
+	// the newest frame, which has been submitted by the last Update
+	return m_Sync.WaitForFrame(m_Sync.GetFrame());
+}
+
+EEngineStatus CRender::Update(const float interpolation)
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const auto elapsedMs = [](const Clock::time_point since)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - since).count();
+	};
+
+	const Clock::time_point frameStart = Clock::now();
+	const float renderAngle = Lerp(m_PreviousAngle, m_Angle, interpolation);
 
 	vk::Result vkResult;
 	uint32_t imageIndex;
 
-	std::tie(vkResult, imageIndex) = m_Device.acquireNextImageKHR(m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphore, nullptr, m_DispatchLoader);
+	// waits until the GPU is done with the frame slot's command buffer, uniform buffer and queries
+	if (m_Sync.BeginFrame() != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
+
+	const uint32_t frameSlot = m_Sync.GetFrameSlot();
+
+	m_Descriptors.BeginFrame(frameSlot);
+	m_DescriptorCache.Update();
+	m_DeletionQueue.Update();
+
+	if (m_Sync.GetFrame() > kMaxFramesInFlight)
+	{
+		m_Profiler.CollectResults(frameSlot);
+	}
+
+	if (m_UseDynamicResolution)
+	{
+		// the upscale and UI passes run at the output resolution whatever the scale, which makes them a fixed cost
+		const float fixedGpuMs = m_Profiler.GetPassStatistics(ERenderPass::Upscale).GpuTimeMs + m_Profiler.GetPassStatistics(ERenderPass::ImGui).GpuTimeMs;
+		m_DynamicResolution.Update(m_DynamicResolutionTargetMs, m_Profiler.GetPassStatistics(ERenderPass::Scene).GpuTimeMs, fixedGpuMs);
+		m_SceneExtent = m_DynamicResolution.GetExtent();
+	}
+
+	const Clock::time_point sceneStart = Clock::now();
+
+	// culling the scene; there is no camera, so the view volume is clip space itself. The rendered state
+	// trails the simulated one by less than a tick, which the margin covers
+	const SCullingInput cullingInput = {
+		m_Scene.GetPositionX(),
+		m_Scene.GetPositionY(),
+		m_Scene.GetPositionZ(),
+		m_Scene.GetBoundsRadius(),
+		m_Scene.GetObjectCount(),
+		m_Scene.GetMaxSpeed() * static_cast<float>(kSimulationTimeStep)
+	};
+	m_VisibleObjectCount = m_Culler.Cull(ExtractFrustum(glm::mat4(1.f)), cullingInput, m_VisibleObjects.data());
+
+	// the scene mesh must be encoded with the pipeline's vertex layout; half and snorm16 share a stride
+	m_DrawSceneMesh = m_MeshStreamer.IsReady(m_SceneMesh) && m_MeshStreamer.HasVertexLayout(m_SceneMesh, m_VertexLayout);
+
+	// picking an LOD per visible object from its projected error; clip space spans two units over the smaller extent
+	const SLodInput lodInput = {
+		m_DrawSceneMesh ? m_MeshStreamer.GetLods(m_SceneMesh) : kTriangleLods,
+		m_DrawSceneMesh ? m_MeshStreamer.GetLodCount(m_SceneMesh) : 1,
+		m_Scene.GetScale(),
+		m_Scene.GetLods(),
+		m_VisibleObjects.data(),
+		m_VisibleObjectCount,
+		0.5f * static_cast<float>(std::min(m_SceneExtent.width, m_SceneExtent.height)),
+		m_LodBias
+	};
+	SelectLods(lodInput, m_LodOrderedObjects.data(), m_LodStats);
+
+	// only the visible objects go into the slot's instance buffer, grouped by LOD, one compact array per stream
+	float* instanceStreams[kSceneStreamCount];
+	for (uint32_t stream = 0; stream < kSceneStreamCount; stream++)
+	{
+		instanceStreams[stream] = m_InstanceBufferMapped[frameSlot] + stream * m_InstanceStreamCapacity;
+	}
+	m_Scene.WriteInstances(interpolation, m_LodOrderedObjects.data(), m_VisibleObjectCount, instanceStreams);
+
+	// acquired only now that the work independent of the image is done, so that the image is held for as
+	// short as possible and a blocking acquire delays as little of the frame as possible
+	const Clock::time_point acquireStart = Clock::now();
+	std::tie(vkResult, imageIndex) = m_Device.acquireNextImageKHR(m_SwapChain, UINT64_MAX, m_Sync.GetImageAvailableSemaphore(), nullptr, m_DispatchLoader);
+	const float acquireMs = elapsedMs(acquireStart);
 
 	if (vkResult == vk::Result::eErrorOutOfDateKHR)
 	{
@@ -1019,83 +1174,98 @@ EEngineStatus CRender::Update(const float deltaTime)
 		return EEngineStatus::Failed;
 	}
 
-	// updating the uniform buffer
-	UniBuffer bufObj;
-	bufObj.Angle = m_Angle; // TODO change to actual time
-	bufObj.RotationSpeed = m_ActualRotationSpeed;
+	// recording the frame
+	const vk::CommandBuffer commandBuffer = m_CommandBuffers[frameSlot];
 
-	void* uniformBufferMemory;
-	m_Device.mapMemory(m_UniformBufferMemory, 0, sizeof(UniBuffer), {}, &uniformBufferMemory);
-	memcpy(uniformBufferMemory, &bufObj, sizeof(UniBuffer));
-	m_Device.unmapMemory(m_UniformBufferMemory);
+	const vk::CommandBufferBeginInfo cbBeginInfo = {
+		vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+	};
+	vkResult = commandBuffer.reset({});
+	VKR(vkResult);
+	vkResult = commandBuffer.begin(cbBeginInfo);
+	VKR(vkResult);
 
-	// submitting the command buffer
-	vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+	m_Profiler.ResetQueries(commandBuffer, frameSlot);
 
-	vk::SubmitInfo submitInfo = {
-		1,
-		&m_ImageAvailableSemaphore,
-		waitStages,
-		1,
-		&m_CommandBuffers[imageIndex],
-		1,
-		&m_RenderFinished1Semaphore
-	};
+	// texture uploads and residency changes land before any pass samples them
+	m_TextureStreamer.Touch(m_SceneTexture);
+	m_TextureStreamer.Update(commandBuffer);
+	m_MeshStreamer.Update(commandBuffer);
 
-	vkResult = m_GraphicsQueue.submit(1, &submitInfo, nullptr);
-	VKR(vkResult);
+	RecordScenePass(commandBuffer, frameSlot, imageIndex);
+
+	// waiting for the image is not work of the pass
+	m_Profiler.SetCpuTime(ERenderPass::Scene, elapsedMs(sceneStart) - acquireMs);
+
+	const Clock::time_point upscaleStart = Clock::now();
+	RecordUpscalePass(commandBuffer, frameSlot, imageIndex);
+	m_Profiler.SetCpuTime(ERenderPass::Upscale, elapsedMs(upscaleStart));
 
 	// >>> ImGui
+	const Clock::time_point imGuiStart = Clock::now();
+
 	ImGui_ImplVulkan_NewFrame();
-	ImGui_ImplSDL2_NewFrame(gEngine->GetViewport()->GetWindow());
+	// fed from the window thread's snapshot, SDL's window and mouse state belong to that thread
+	gEngine->GetViewport()->NewFrame();
 	ImGui::NewFrame();
 
 	gEngine->OnRenderGui();
 	ImGui::Render();
 	ImDrawData* drawData = ImGui::GetDrawData();
 
-	const vk::CommandBufferBeginInfo cbBeginInfo = {};
-	vkResult = m_CommandBuffersImGui[imageIndex].reset(vk::CommandBufferResetFlagBits::eReleaseResources);
-	vkResult = m_CommandBuffersImGui[imageIndex].begin(cbBeginInfo);
+	m_Profiler.BeginPass(commandBuffer, frameSlot, ERenderPass::ImGui);
+	if (m_RenderGraph.BeginPass(commandBuffer, m_ImGuiPass, imageIndex))
+	{
+		ImGui_ImplVulkan_RenderDrawData(drawData, commandBuffer);
+		m_RenderGraph.EndPass(commandBuffer, m_ImGuiPass);
+	}
+	m_Profiler.EndPass(commandBuffer, frameSlot, ERenderPass::ImGui);
 
-	vk::RenderPassBeginInfo rpBeginInfo = {
-		m_RenderPassImGui,
-		m_SwapChainFrameBuffers[imageIndex],
-		{
-			{0, 0},
-			m_SwapChainExtent
-		},
-		0,
-		nullptr
-	};
+	vkResult = commandBuffer.end();
+	VKR(vkResult);
+
+	// <<<
+
+	// the uniform buffer holds the latency-critical constants, written last. In low-latency mode the rotation
+	// is advanced to the moment of submission; benchmark runs keep the interpolated angle to stay repeatable
+	UniBuffer bufObj;
+	bufObj.Angle = renderAngle;
+	bufObj.RotationSpeed = m_ActualRotationSpeed;
+	bufObj.PositionScale = m_VertexLayout.PositionScale;
 
-	m_CommandBuffersImGui[imageIndex].beginRenderPass(rpBeginInfo, vk::SubpassContents::eInline);
-	ImGui_ImplVulkan_RenderDrawData(drawData, m_CommandBuffersImGui[imageIndex]);
-	m_CommandBuffersImGui[imageIndex].endRenderPass();
+	if (m_LowLatency && !gEngine->GetOptions().Benchmark)
+	{
+		bufObj.Angle += m_ActualRotationSpeed * std::chrono::duration<float>(Clock::now() - frameStart).count();
+	}
 
-	vkResult = m_CommandBuffersImGui[imageIndex].end();
+	memcpy(m_UniformBufferMapped[frameSlot], &bufObj, sizeof(UniBuffer));
 
-	vk::SubmitInfo submitInfo2 = {
-		1,
-		&m_RenderFinished1Semaphore,
-		waitStages,
-		1,
-		&m_CommandBuffersImGui[imageIndex],
-		1,
-		&m_RenderFinished2Semaphore
-	};
+	// submitting the frame, the sync signals the present semaphore and the frame's completion
+	vkResult = m_Sync.SubmitFrame(&commandBuffer, 1);
+	VKR(vkResult);
+
+	// after submission the frame waits for the one still ahead of it on the GPU, if any, and then takes
+	// about as long as the last measured frame
+	float gpuFrameMs = 0.f;
+	for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+	{
+		gpuFrameMs += m_Profiler.GetPassStatistics(static_cast<ERenderPass>(pass)).GpuTimeMs;
+	}
+	const uint64_t frame = m_Sync.GetFrame();
+	const float queuedMs = frame > 1 && !m_Sync.IsFrameComplete(frame - 1) ? gpuFrameMs : 0.f;
 
-	vkResult = m_GraphicsQueue.submit(1, &submitInfo2, nullptr);
+	m_LatencyStats.InputToSubmitMs = elapsedMs(gEngine->GetViewport()->GetLastInputTime());
+	m_LatencyStats.EstimatedMs = Lerp(m_LatencyStats.EstimatedMs, m_LatencyStats.InputToSubmitMs + queuedMs + gpuFrameMs, kLatencySmoothing);
 
-	// <<<
+	m_Profiler.SetCpuTime(ERenderPass::ImGui, elapsedMs(imGuiStart));
 
 	// presenting the image
 
-	const vk::Semaphore presentWaitSemaphores[] = { m_RenderFinished1Semaphore, m_RenderFinished2Semaphore };
+	const vk::Semaphore presentWaitSemaphore = m_Sync.GetRenderFinishedSemaphore();
 
 	const vk::PresentInfoKHR presentInfo = {
-		2,
-		presentWaitSemaphores,
+		1,
+		&presentWaitSemaphore,
 		1,
 		&m_SwapChain,
 		&imageIndex
@@ -1111,8 +1281,7 @@ EEngineStatus CRender::Update(const float deltaTime)
 
 	VKR(vkResult);
 
-	vkResult = m_Device.waitIdle();
-	VKR(vkResult);
+	m_Memory.Update();
 	
 	return EEngineStatus::Ok;
 }
@@ -1120,34 +1289,50 @@ EEngineStatus CRender::Update(const float deltaTime)
 EEngineStatus CRender::Shutdown()
 {
 	SDL_Log("[CRender] Shutting down...");
+	m_Device.waitIdle();
+	m_TextureStreamer.Shutdown();
+	m_MeshStreamer.Shutdown();
+	m_DeletionQueue.Shutdown();
 	ImGui_ImplVulkan_Shutdown();
+	m_Profiler.Shutdown();
 	m_Device.destroyDescriptorSetLayout(m_DescriptorSetLayout);
-	m_Device.destroyDescriptorPool(m_DescriptorPool);
-	m_Device.freeMemory(m_UniformBufferMemory);
-	m_Device.destroyBuffer(m_UniformBuffer);
-	m_Device.freeMemory(m_IndexBufferMemory);
+	m_DescriptorCache.Shutdown();
+	m_Descriptors.Shutdown();
+	for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+	{
+		m_Bindless.ReleaseBuffer(m_UniformBufferIndices[slot]);
+		m_Device.destroyBuffer(m_UniformBuffers[slot]);
+		m_Memory.Free(m_UniformBufferMemory[slot]);
+	}
+	for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+	{
+		m_Device.destroyBuffer(m_InstanceBuffers[slot]);
+		m_Memory.Free(m_InstanceBufferMemory[slot]);
+	}
 	m_Device.destroyBuffer(m_IndexBuffer);
-	m_Device.freeMemory(m_VertexBufferMemory);
+	m_Memory.Free(m_IndexBufferMemory);
 	m_Device.destroyBuffer(m_VertexBuffer);
+	m_Memory.Free(m_VertexBufferMemory);
 	m_Device.destroyPipeline(m_Pipeline);
 	m_Device.destroyPipelineLayout(m_PipelineLayout);
-	m_Device.freeCommandBuffers(m_CommandPool, m_CommandBuffers.size(), m_CommandBuffers.data());
+	m_Device.destroyPipeline(m_UpscalePipeline);
+	m_Device.destroyPipelineLayout(m_UpscalePipelineLayout);
+	m_Device.destroyDescriptorSetLayout(m_UpscaleSetLayout);
+	m_Device.destroySampler(m_UpscaleSampler);
+	m_Device.freeCommandBuffers(m_CommandPool, kMaxFramesInFlight, m_CommandBuffers);
 	m_Device.destroyCommandPool(m_CommandPool);
-	m_Device.destroySemaphore(m_ImageAvailableSemaphore);
-	m_Device.destroySemaphore(m_RenderFinished1Semaphore);
-	m_Device.destroySemaphore(m_RenderFinished2Semaphore);
+	m_Bindless.Shutdown();
+	m_Sync.Shutdown();
 	m_Device.destroyShaderModule(m_TriangleVS);
 	m_Device.destroyShaderModule(m_TriangleFS);
-	for (vk::Framebuffer& frameBuffer : m_SwapChainFrameBuffers)
-	{
-		m_Device.destroyFramebuffer(frameBuffer);
-	}
-	m_Device.destroyRenderPass(m_RenderPass1);
-	m_Device.destroyRenderPass(m_RenderPassImGui);
+	m_Device.destroyShaderModule(m_UpscaleVS);
+	m_Device.destroyShaderModule(m_UpscaleFS);
+	m_RenderGraph.Shutdown();
 	for (vk::ImageView& view : m_SwapChainImageViews)
 	{
 		m_Device.destroyImageView(view);
 	}
+	m_Memory.Shutdown();
 	m_Device.destroySwapchainKHR(m_SwapChain, nullptr, m_DispatchLoader);
 	m_Instance.destroySurfaceKHR(m_Surface, nullptr, m_DispatchLoader);
 	m_Device.destroy();
@@ -1172,65 +1357,475 @@ void CRender::ResetAngle()
 {
 	m_ActualRotationSpeed = 0;
 	m_Angle = 0;
+	m_PreviousAngle = 0;
+}
+
+CRenderProfiler* CRender::GetProfiler()
+{
+	return &m_Profiler;
+}
+
+const CRenderProfiler* CRender::GetProfiler() const
+{
+	return &m_Profiler;
+}
+
+const CRenderMemory* CRender::GetMemory() const
+{
+	return &m_Memory;
+}
+
+CRenderSync* CRender::GetSync()
+{
+	return &m_Sync;
+}
+
+CRenderBindless* CRender::GetBindless()
+{
+	return m_UseBindless ? &m_Bindless : nullptr;
+}
+
+CTextureStreamer* CRender::GetTextureStreamer()
+{
+	return &m_TextureStreamer;
+}
+
+const CTextureStreamer* CRender::GetTextureStreamer() const
+{
+	return &m_TextureStreamer;
+}
+
+CScene* CRender::GetScene()
+{
+	return &m_Scene;
+}
+
+const CScene* CRender::GetScene() const
+{
+	return &m_Scene;
+}
+
+const SLodStats& CRender::GetLodStats() const
+{
+	return m_LodStats;
+}
+
+uint32_t CRender::GetSampleCount() const
+{
+	return static_cast<uint32_t>(m_SampleCount);
+}
+
+const CRenderGraph* CRender::GetRenderGraph() const
+{
+	return &m_RenderGraph;
+}
+
+CRenderDescriptors* CRender::GetDescriptors()
+{
+	return &m_Descriptors;
+}
+
+const CRenderDescriptors* CRender::GetDescriptors() const
+{
+	return &m_Descriptors;
+}
+
+const CRenderDescriptorCache* CRender::GetDescriptorCache() const
+{
+	return &m_DescriptorCache;
+}
+
+const CRenderDeletionQueue* CRender::GetDeletionQueue() const
+{
+	return &m_DeletionQueue;
+}
+
+const SLatencyStats& CRender::GetLatencyStats() const
+{
+	return m_LatencyStats;
+}
+
+const CDynamicResolution* CRender::GetDynamicResolution() const
+{
+	return m_UseDynamicResolution ? &m_DynamicResolution : nullptr;
+}
+
+const CFrustumCuller* CRender::GetCuller() const
+{
+	return &m_Culler;
+}
+
+CMeshStreamer* CRender::GetMeshStreamer()
+{
+	return &m_MeshStreamer;
+}
+
+const CMeshStreamer* CRender::GetMeshStreamer() const
+{
+	return &m_MeshStreamer;
+}
+
+static EEngineStatus LoadShaderModule(const vk::Device device, const char* const path, vk::ShaderModule& module)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+	{
+		return EEngineStatus::Failed;
+	}
+
+	const size_t size = file.tellg();
+	std::vector<char> buffer(size);
+	file.seekg(0);
+	file.read(buffer.data(), size);
+	file.close();
+
+	const vk::ShaderModuleCreateInfo shaderModuleCreateInfo = {
+		{},
+		buffer.size(),
+		reinterpret_cast<const uint32_t*>(buffer.data())
+	};
+
+	vk::Result vkResult;
+	std::tie(vkResult, module) = device.createShaderModule(shaderModuleCreateInfo);
+	return vkResult == vk::Result::eSuccess ? EEngineStatus::Ok : EEngineStatus::Failed;
 }
 
 EEngineStatus CRender::LoadShadersTriangle()
+{
+#ifndef _DEBUG
+	const char* const pathVS = m_UseBindless ? "triangle_bindless.vert.spv" : "triangle.vert.spv";
+	const char* const pathFS = m_UseBindless ? "triangle_bindless.frag.spv" : "triangle.frag.spv";
+#else
+	const char* const pathVS = m_UseBindless ? "../../shaders/triangle_bindless.vert.spv" : "../../shaders/triangle.vert.spv";
+	const char* const pathFS = m_UseBindless ? "../../shaders/triangle_bindless.frag.spv" : "../../shaders/triangle.frag.spv";
+#endif
+
+	if (LoadShaderModule(m_Device, pathVS, m_TriangleVS) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
+
+	return LoadShaderModule(m_Device, pathFS, m_TriangleFS);
+}
+
+EEngineStatus CRender::CreateUpscalePipeline()
 {
 	vk::Result vkResult;
+
 #ifndef _DEBUG
-	const char* const pathVS = "triangle.vert.spv";
-	const char* const pathFS = "triangle.frag.spv";
+	const char* const pathVS = "upscale.vert.spv";
+	const char* const pathFS = "upscale.frag.spv";
 #else
-	const char* const pathVS = "../../shaders/triangle.vert.spv";
-	const char* const pathFS = "../../shaders/triangle.frag.spv";
+	const char* const pathVS = "../../shaders/upscale.vert.spv";
+	const char* const pathFS = "../../shaders/upscale.frag.spv";
 #endif
 
-	std::ifstream fVS(pathVS, std::ios::ate | std::ios::binary);
-	if (!fVS.is_open())
+	if (LoadShaderModule(m_Device, pathVS, m_UpscaleVS) != EEngineStatus::Ok || LoadShaderModule(m_Device, pathFS, m_UpscaleFS) != EEngineStatus::Ok)
 	{
 		return EEngineStatus::Failed;
 	}
 
-	const size_t fVSSize = fVS.tellg();
-	std::vector<char> vsBuffer(fVSSize);
-	fVS.seekg(0);
-	fVS.read(vsBuffer.data(), fVSSize);
-	fVS.close();
+	// bilinear, and clamped so that the edge texels of the full image are not blended with the opposite side
+	const vk::SamplerCreateInfo samplerCreateInfo = {
+		{},
+		vk::Filter::eLinear,
+		vk::Filter::eLinear,
+		vk::SamplerMipmapMode::eNearest,
+		vk::SamplerAddressMode::eClampToEdge,
+		vk::SamplerAddressMode::eClampToEdge,
+		vk::SamplerAddressMode::eClampToEdge,
+		0.f,
+		false,
+		1.f,
+		false,
+		vk::CompareOp::eNever,
+		0.f,
+		0.f
+	};
+
+	std::tie(vkResult, m_UpscaleSampler) = m_Device.createSampler(samplerCreateInfo);
+	VKR(vkResult);
+
+	const vk::DescriptorSetLayoutBinding layoutBinding = {
+		0,
+		vk::DescriptorType::eCombinedImageSampler,
+		1,
+		vk::ShaderStageFlagBits::eFragment,
+		nullptr
+	};
+
+	const vk::DescriptorSetLayoutCreateInfo layoutCreateInfo = {
+		{},
+		1,
+		&layoutBinding
+	};
+
+	std::tie(vkResult, m_UpscaleSetLayout) = m_Device.createDescriptorSetLayout(layoutCreateInfo);
+	VKR(vkResult);
 
-	vk::ShaderModuleCreateInfo shaderModuleCreateInfo = {
+	// the UV scale and clamp of the rendered part of the scene image (see upscale.vert)
+	const vk::PushConstantRange pushConstantRange = {
+		vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+		0,
+		4 * sizeof(float)
+	};
+
+	const vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
 		{},
-		vsBuffer.size(),
-		reinterpret_cast<const uint32_t*>(vsBuffer.data())
+		1,
+		&m_UpscaleSetLayout,
+		1,
+		&pushConstantRange
 	};
 
-	std::tie(vkResult, m_TriangleVS) = m_Device.createShaderModule(shaderModuleCreateInfo);
-	if (vkResult != vk::Result::eSuccess)
+	std::tie(vkResult, m_UpscalePipelineLayout) = m_Device.createPipelineLayout(pipelineLayoutCreateInfo);
+	VKR(vkResult);
+
+	const vk::PipelineShaderStageCreateInfo shaderStages[] = {
+		{ {}, vk::ShaderStageFlagBits::eVertex, m_UpscaleVS, "main" },
+		{ {}, vk::ShaderStageFlagBits::eFragment, m_UpscaleFS, "main" }
+	};
+
+	// a single triangle generated from the vertex index covers the target
+	const vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo;
+
+	const vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo = {
+		{},
+		vk::PrimitiveTopology::eTriangleList,
+		false
+	};
+
+	const vk::Viewport viewport = {
+		0,
+		0,
+		static_cast<float>(m_SwapChainExtent.width),
+		static_cast<float>(m_SwapChainExtent.height),
+		0.f,
+		1.f
+	};
+
+	const vk::Rect2D scissor = {
+		{0, 0},
+		m_SwapChainExtent
+	};
+
+	const vk::PipelineViewportStateCreateInfo viewportStateCreateInfo = {
+		{},
+		1,
+		&viewport,
+		1,
+		&scissor
+	};
+
+	const vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {
+		{},
+		false,
+		false,
+		vk::PolygonMode::eFill,
+		vk::CullModeFlagBits::eNone,
+		vk::FrontFace::eCounterClockwise,
+		false,
+		0,
+		0,
+		0,
+		1.f
+	};
+
+	const vk::PipelineMultisampleStateCreateInfo multisampleStateCreateInfo = {
+		{},
+		vk::SampleCountFlagBits::e1,
+		false
+	};
+
+	const vk::PipelineColorBlendAttachmentState colorBlendAttachmentState = {
+		false,
+		vk::BlendFactor::eOne,
+		vk::BlendFactor::eZero,
+		vk::BlendOp::eAdd,
+		vk::BlendFactor::eOne,
+		vk::BlendFactor::eZero,
+		vk::BlendOp::eAdd,
+		vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+	};
+
+	const vk::PipelineColorBlendStateCreateInfo colorBlendStateCreateInfo = {
+		{},
+		false,
+		vk::LogicOp::eCopy,
+		1,
+		&colorBlendAttachmentState
+	};
+
+	const vk::GraphicsPipelineCreateInfo pipelineCreateInfo = {
+		{},
+		2,
+		shaderStages,
+		&vertexInputStateCreateInfo,
+		&inputAssemblyStateCreateInfo,
+		nullptr,
+		&viewportStateCreateInfo,
+		&rasterizationStateCreateInfo,
+		&multisampleStateCreateInfo,
+		nullptr,
+		&colorBlendStateCreateInfo,
+		nullptr,
+		m_UpscalePipelineLayout,
+		m_RenderGraph.GetRenderPass(m_UpscalePass),
+		0,
+		nullptr,
+		-1
+	};
+
+	std::tie(vkResult, m_UpscalePipeline) = m_Device.createGraphicsPipeline(nullptr, pipelineCreateInfo);
+	VKR(vkResult);
+
+	return EEngineStatus::Ok;
+}
+
+void CRender::RecordScenePass(const vk::CommandBuffer commandBuffer, const uint32_t frameSlot, const uint32_t imageIndex)
+{
+	m_Profiler.BeginPass(commandBuffer, frameSlot, ERenderPass::Scene);
+
+	if (!m_RenderGraph.BeginPass(commandBuffer, m_ScenePass, imageIndex, m_SceneExtent))
 	{
-		return EEngineStatus::Failed;
+		m_Profiler.EndPass(commandBuffer, frameSlot, ERenderPass::Scene);
+		return;
+	}
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_Pipeline);
+
+	const vk::Viewport viewport = {
+		0,
+		0,
+		static_cast<float>(m_SceneExtent.width),
+		static_cast<float>(m_SceneExtent.height),
+		0.f,
+		1.f
+	};
+	const vk::Rect2D scissor = {
+		{0, 0},
+		m_SceneExtent
+	};
+	commandBuffer.setViewport(0, 1, &viewport);
+	commandBuffer.setScissor(0, 1, &scissor);
+
+	if (m_DrawSceneMesh)
+	{
+		m_MeshStreamer.Bind(commandBuffer, m_SceneMesh);
+	}
+	else
+	{
+		vk::Buffer vertexBuffers[] = { m_VertexBuffer };
+		vk::DeviceSize offsets[] = { 0 };
+		commandBuffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
+
+		commandBuffer.bindIndexBuffer(m_IndexBuffer, 0, m_IndexType);
 	}
 
-	std::ifstream fFS(pathFS, std::ios::ate | std::ios::binary);
-	if (!fFS.is_open())
+	vk::Buffer instanceBuffers[kSceneStreamCount];
+	vk::DeviceSize instanceOffsets[kSceneStreamCount];
+	for (uint32_t stream = 0; stream < kSceneStreamCount; stream++)
 	{
-		return EEngineStatus::Failed;
+		instanceBuffers[stream] = m_InstanceBuffers[frameSlot];
+		instanceOffsets[stream] = stream * m_InstanceStreamCapacity * sizeof(float);
 	}
+	commandBuffer.bindVertexBuffers(1, kSceneStreamCount, instanceBuffers, instanceOffsets);
+
+	if (m_UseBindless)
+	{
+		SBindlessDrawConstants drawConstants;
+		drawConstants.UniformBuffer = m_UniformBufferIndices[frameSlot];
+		// kBindlessInvalidIndex until the mip tail is resident
+		drawConstants.BaseColorTexture = m_TextureStreamer.GetBindlessIndex(m_SceneTexture);
 
-	const size_t fFSSize = fFS.tellg();
-	std::vector<char> fsBuffer(fFSSize);
-	fFS.seekg(0);
-	fFS.read(fsBuffer.data(), fFSSize);
-	fFS.close();
+		m_Bindless.Bind(commandBuffer, vk::PipelineBindPoint::eGraphics, m_PipelineLayout, 0);
+		m_Bindless.PushDrawConstants(commandBuffer, m_PipelineLayout, drawConstants);
+	}
+	else
+	{
+		// found in the cache from the slot's second frame on
+		SDescriptorBinding uniformBinding;
+		uniformBinding.Buffer = m_UniformBuffers[frameSlot];
+		uniformBinding.Range = sizeof(UniBuffer);
 
-	shaderModuleCreateInfo.codeSize = fsBuffer.size();
-	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(fsBuffer.data());
+		const vk::DescriptorSet descriptorSet = m_DescriptorCache.Get(m_DescriptorSetLayout, &uniformBinding, 1);
+		if (!descriptorSet)
+		{
+			m_RenderGraph.EndPass(commandBuffer, m_ScenePass);
+			m_Profiler.EndPass(commandBuffer, frameSlot, ERenderPass::Scene);
+			return;
+		}
 
-	std::tie(vkResult, m_TriangleFS) = m_Device.createShaderModule(shaderModuleCreateInfo);
-	if (vkResult != vk::Result::eSuccess)
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+	}
+
+	// one instanced draw per LOD, the instance streams are grouped by LOD in the same order
+	const SMeshLod* lods = m_DrawSceneMesh ? m_MeshStreamer.GetLods(m_SceneMesh) : kTriangleLods;
+	uint32_t firstInstance = 0;
+	for (uint32_t lod = 0; lod < m_LodStats.LodCount; lod++)
 	{
-		return EEngineStatus::Failed;
+		if (m_LodStats.Instances[lod] != 0)
+		{
+			commandBuffer.drawIndexed(lods[lod].IndexCount, m_LodStats.Instances[lod], lods[lod].FirstIndex, 0, firstInstance);
+		}
+		firstInstance += m_LodStats.Instances[lod];
 	}
 
-	return EEngineStatus::Ok;
+	m_RenderGraph.EndPass(commandBuffer, m_ScenePass);
+
+	m_Profiler.EndPass(commandBuffer, frameSlot, ERenderPass::Scene);
+}
+
+void CRender::RecordUpscalePass(const vk::CommandBuffer commandBuffer, const uint32_t frameSlot, const uint32_t imageIndex)
+{
+	// bracketed without dynamic resolution too, every pass's queries are read back together
+	m_Profiler.BeginPass(commandBuffer, frameSlot, ERenderPass::Upscale);
+
+	if (!m_UseDynamicResolution || !m_RenderGraph.BeginPass(commandBuffer, m_UpscalePass, imageIndex))
+	{
+		m_Profiler.EndPass(commandBuffer, frameSlot, ERenderPass::Upscale);
+		return;
+	}
+
+	// written every frame from the frame slot's pools: the scene image is recreated with the swap chain, a
+	// cached set would only collect entries for views that no longer exist
+	const vk::DescriptorSet descriptorSet = m_Descriptors.AllocateFrame(m_UpscaleSetLayout);
+	if (descriptorSet)
+	{
+		const vk::DescriptorImageInfo sceneImageInfo = {
+			m_UpscaleSampler,
+			m_RenderGraph.GetImageView(m_SceneOutput),
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		};
+		const vk::WriteDescriptorSet write = {
+			descriptorSet,
+			0,
+			0,
+			1,
+			vk::DescriptorType::eCombinedImageSampler,
+			&sceneImageInfo
+		};
+		m_Device.updateDescriptorSets(1, &write, 0, nullptr);
+
+		// the UVs cover the rendered part of the scene image and stop half a texel inside its far edges
+		const float outputWidth = static_cast<float>(m_SwapChainExtent.width);
+		const float outputHeight = static_cast<float>(m_SwapChainExtent.height);
+		const float constants[4] = {
+			static_cast<float>(m_SceneExtent.width) / outputWidth,
+			static_cast<float>(m_SceneExtent.height) / outputHeight,
+			(static_cast<float>(m_SceneExtent.width) - 0.5f) / outputWidth,
+			(static_cast<float>(m_SceneExtent.height) - 0.5f) / outputHeight
+		};
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_UpscalePipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_UpscalePipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+		commandBuffer.pushConstants(m_UpscalePipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(constants), constants);
+		commandBuffer.draw(3, 1, 0, 0);
+	}
+
+	m_RenderGraph.EndPass(commandBuffer, m_UpscalePass);
+
+	m_Profiler.EndPass(commandBuffer, frameSlot, ERenderPass::Upscale);
 }
 
 uint32_t CRender::FindMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
@@ -0,0 +1,272 @@
+#include "RenderBindless.h"
+
+#include <algorithm>
+
+#include "RenderSync.h"
+#include "SDL.h"
+
+vk::PhysicalDeviceDescriptorIndexingFeatures CRenderBindless::GetRequiredFeatures()
+{
+	vk::PhysicalDeviceDescriptorIndexingFeatures features;
+	features.shaderSampledImageArrayNonUniformIndexing = true;
+	features.shaderStorageBufferArrayNonUniformIndexing = true;
+	features.descriptorBindingSampledImageUpdateAfterBind = true;
+	features.descriptorBindingStorageBufferUpdateAfterBind = true;
+	features.descriptorBindingUpdateUnusedWhilePending = true;
+	features.descriptorBindingPartiallyBound = true;
+	features.runtimeDescriptorArray = true;
+	return features;
+}
+
+bool CRenderBindless::IsSupported(const vk::PhysicalDeviceDescriptorIndexingFeatures& supportedFeatures)
+{
+	return supportedFeatures.shaderSampledImageArrayNonUniformIndexing &&
+		supportedFeatures.shaderStorageBufferArrayNonUniformIndexing &&
+		supportedFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+		supportedFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+		supportedFeatures.descriptorBindingUpdateUnusedWhilePending &&
+		supportedFeatures.descriptorBindingPartiallyBound &&
+		supportedFeatures.runtimeDescriptorArray;
+}
+
+EEngineStatus CRenderBindless::Initialize(const vk::PhysicalDevice physicalDevice, const vk::Device device, CRenderSync* sync, const vk::DispatchLoaderDynamic* dispatchLoader)
+{
+	vk::Result vkResult;
+
+	m_Device = device;
+	m_Sync = sync;
+
+	vk::PhysicalDeviceDescriptorIndexingProperties indexingProperties;
+	vk::PhysicalDeviceProperties2 properties2;
+	properties2.pNext = &indexingProperties;
+	physicalDevice.getProperties2(&properties2, *dispatchLoader);
+
+	m_Textures.Capacity = std::min({ kBindlessMaxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+	m_Buffers.Capacity = std::min({ kBindlessMaxBuffers, indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers, indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+	// creating the set layout
+	const vk::DescriptorSetLayoutBinding layoutBindings[] = {
+		{
+			kBindlessTextureBinding,
+			vk::DescriptorType::eCombinedImageSampler,
+			m_Textures.Capacity,
+			vk::ShaderStageFlagBits::eAll,
+			nullptr
+		},
+		{
+			kBindlessBufferBinding,
+			vk::DescriptorType::eStorageBuffer,
+			m_Buffers.Capacity,
+			vk::ShaderStageFlagBits::eAll,
+			nullptr
+		}
+	};
+
+	const vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending | vk::DescriptorBindingFlagBits::ePartiallyBound;
+	const vk::DescriptorBindingFlags layoutBindingFlags[] = { bindingFlags, bindingFlags };
+
+	const vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {
+		2,
+		layoutBindingFlags
+	};
+
+	vk::DescriptorSetLayoutCreateInfo layoutCreateInfo = {
+		vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+		2,
+		layoutBindings
+	};
+	layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+
+	std::tie(vkResult, m_SetLayout) = m_Device.createDescriptorSetLayout(layoutCreateInfo);
+	VKR(vkResult);
+
+	// creating the pool and the set
+	const vk::DescriptorPoolSize poolSizes[] = {
+		{vk::DescriptorType::eCombinedImageSampler, m_Textures.Capacity},
+		{vk::DescriptorType::eStorageBuffer, m_Buffers.Capacity}
+	};
+
+	const vk::DescriptorPoolCreateInfo poolCreateInfo = {
+		vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+		1,
+		2,
+		poolSizes
+	};
+
+	std::tie(vkResult, m_Pool) = m_Device.createDescriptorPool(poolCreateInfo);
+	VKR(vkResult);
+
+	const vk::DescriptorSetAllocateInfo setAllocateInfo = {
+		m_Pool,
+		1,
+		&m_SetLayout
+	};
+
+	vkResult = m_Device.allocateDescriptorSets(&setAllocateInfo, &m_Set);
+	VKR(vkResult);
+
+	SDL_Log("[CRenderBindless] Resource table with %u textures and %u storage buffers", m_Textures.Capacity, m_Buffers.Capacity);
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderBindless::Shutdown()
+{
+	if (m_Pool)
+	{
+		m_Device.destroyDescriptorPool(m_Pool);
+	}
+	if (m_SetLayout)
+	{
+		m_Device.destroyDescriptorSetLayout(m_SetLayout);
+	}
+}
+
+uint32_t CRenderBindless::RegisterTexture(const vk::ImageView imageView, const vk::Sampler sampler, const vk::ImageLayout imageLayout)
+{
+	RecycleRetired(m_Textures);
+
+	const uint32_t index = m_Textures.Allocate();
+	if (index == kBindlessInvalidIndex)
+	{
+		SDL_Log("[CRenderBindless] Texture table is full (%u entries)", m_Textures.Capacity);
+		return index;
+	}
+
+	const vk::DescriptorImageInfo imageInfo = {
+		sampler,
+		imageView,
+		imageLayout
+	};
+
+	const vk::WriteDescriptorSet descriptorWrite = {
+		m_Set,
+		kBindlessTextureBinding,
+		index,
+		1,
+		vk::DescriptorType::eCombinedImageSampler,
+		&imageInfo
+	};
+
+	m_Device.updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+
+	return index;
+}
+
+uint32_t CRenderBindless::RegisterBuffer(const vk::Buffer buffer, const vk::DeviceSize offset, const vk::DeviceSize range)
+{
+	RecycleRetired(m_Buffers);
+
+	const uint32_t index = m_Buffers.Allocate();
+	if (index == kBindlessInvalidIndex)
+	{
+		SDL_Log("[CRenderBindless] Buffer table is full (%u entries)", m_Buffers.Capacity);
+		return index;
+	}
+
+	const vk::DescriptorBufferInfo bufferInfo = {
+		buffer,
+		offset,
+		range
+	};
+
+	const vk::WriteDescriptorSet descriptorWrite = {
+		m_Set,
+		kBindlessBufferBinding,
+		index,
+		1,
+		vk::DescriptorType::eStorageBuffer,
+		nullptr,
+		&bufferInfo
+	};
+
+	m_Device.updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+
+	return index;
+}
+
+void CRenderBindless::ReleaseTexture(const uint32_t index)
+{
+	if (index != kBindlessInvalidIndex)
+	{
+		m_Textures.Retired.push_back({ index, m_Sync->GetFrame() });
+	}
+}
+
+void CRenderBindless::ReleaseBuffer(const uint32_t index)
+{
+	if (index != kBindlessInvalidIndex)
+	{
+		m_Buffers.Retired.push_back({ index, m_Sync->GetFrame() });
+	}
+}
+
+void CRenderBindless::Bind(const vk::CommandBuffer commandBuffer, const vk::PipelineBindPoint bindPoint, const vk::PipelineLayout pipelineLayout, const uint32_t firstSet) const
+{
+	commandBuffer.bindDescriptorSets(bindPoint, pipelineLayout, firstSet, 1, &m_Set, 0, nullptr);
+}
+
+void CRenderBindless::PushDrawConstants(const vk::CommandBuffer commandBuffer, const vk::PipelineLayout pipelineLayout, const SBindlessDrawConstants& constants) const
+{
+	const vk::PushConstantRange range = GetPushConstantRange();
+	commandBuffer.pushConstants(pipelineLayout, range.stageFlags, range.offset, range.size, &constants);
+}
+
+vk::DescriptorSetLayout CRenderBindless::GetSetLayout() const
+{
+	return m_SetLayout;
+}
+
+vk::PushConstantRange CRenderBindless::GetPushConstantRange() const
+{
+	return { vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(SBindlessDrawConstants) };
+}
+
+uint32_t CRenderBindless::GetTextureCapacity() const
+{
+	return m_Textures.Capacity;
+}
+
+uint32_t CRenderBindless::GetBufferCapacity() const
+{
+	return m_Buffers.Capacity;
+}
+
+uint32_t CRenderBindless::GetTextureCount() const
+{
+	return m_Textures.GetCount();
+}
+
+uint32_t CRenderBindless::GetBufferCount() const
+{
+	return m_Buffers.GetCount();
+}
+
+void CRenderBindless::RecycleRetired(SIndexAllocator& allocator)
+{
+	// an index released during frame N may still be read by frame N, so it waits for that frame to finish
+	const auto firstPending = std::partition(allocator.Retired.begin(), allocator.Retired.end(), [&](const SRetiredIndex& retired) { return m_Sync->IsFrameComplete(retired.Frame); });
+
+	for (auto it = allocator.Retired.begin(); it != firstPending; ++it)
+	{
+		allocator.Free.push_back(it->Index);
+	}
+	allocator.Retired.erase(allocator.Retired.begin(), firstPending);
+}
+
+uint32_t CRenderBindless::SIndexAllocator::Allocate()
+{
+	if (!Free.empty())
+	{
+		const uint32_t index = Free.back();
+		Free.pop_back();
+		return index;
+	}
+
+	return Next < Capacity ? Next++ : kBindlessInvalidIndex;
+}
+
+uint32_t CRenderBindless::SIndexAllocator::GetCount() const
+{
+	return Next - static_cast<uint32_t>(Free.size() + Retired.size());
+}
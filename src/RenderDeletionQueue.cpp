@@ -0,0 +1,150 @@
+#include "RenderDeletionQueue.h"
+
+#include "RenderDescriptors.h"
+#include "RenderMemory.h"
+
+template <typename THandle>
+static THandle FromValue(const uint64_t value)
+{
+	THandle handle;
+	std::memcpy(&handle, &value, sizeof(handle));
+	return handle;
+}
+
+EEngineStatus CRenderDeletionQueue::Initialize(const vk::Device device, CRenderMemory* memory, CRenderSync* sync, CRenderDescriptorCache* descriptorCache)
+{
+	m_Device = device;
+	m_Memory = memory;
+	m_Sync = sync;
+	m_DescriptorCache = descriptorCache;
+	return EEngineStatus::Ok;
+}
+
+void CRenderDeletionQueue::Shutdown()
+{
+	for (const SEntry& entry : m_FrameEntries)
+	{
+		Execute(entry);
+	}
+	m_FrameEntries.clear();
+
+	for (std::deque<SEntry>& entries : m_QueueEntries)
+	{
+		for (const SEntry& entry : entries)
+		{
+			Execute(entry);
+		}
+		entries.clear();
+	}
+
+	m_Stats.Pending = 0;
+}
+
+void CRenderDeletionQueue::Update()
+{
+	m_Stats.Destroyed = 0;
+
+	while (!m_FrameEntries.empty() && m_Sync->IsFrameComplete(m_FrameEntries.front().Value))
+	{
+		Execute(m_FrameEntries.front());
+		m_FrameEntries.pop_front();
+	}
+
+	for (uint32_t queue = 0; queue < kRenderQueueCount; queue++)
+	{
+		std::deque<SEntry>& entries = m_QueueEntries[queue];
+		while (!entries.empty() && m_Sync->IsQueueValueComplete(static_cast<ERenderQueue>(queue), entries.front().Value))
+		{
+			Execute(entries.front());
+			entries.pop_front();
+		}
+	}
+}
+
+const SDeletionQueueStats& CRenderDeletionQueue::GetStats() const
+{
+	return m_Stats;
+}
+
+void CRenderDeletionQueue::Invalidate(const vk::Buffer buffer)
+{
+	if (m_DescriptorCache != nullptr)
+	{
+		m_DescriptorCache->Invalidate(buffer);
+	}
+}
+
+void CRenderDeletionQueue::Invalidate(const vk::ImageView imageView)
+{
+	if (m_DescriptorCache != nullptr)
+	{
+		m_DescriptorCache->Invalidate(imageView);
+	}
+}
+
+void CRenderDeletionQueue::Invalidate(const vk::Sampler sampler)
+{
+	if (m_DescriptorCache != nullptr)
+	{
+		m_DescriptorCache->Invalidate(sampler);
+	}
+}
+
+void CRenderDeletionQueue::Push(std::deque<SEntry>& entries, const uint64_t value, const EDeletionType type, const uint64_t handle)
+{
+	entries.push_back({ type, handle, value });
+	m_Stats.Pending++;
+}
+
+void CRenderDeletionQueue::Execute(const SEntry& entry)
+{
+	switch (entry.Type)
+	{
+	case EDeletionType::Buffer:
+		m_Device.destroyBuffer(FromValue<vk::Buffer>(entry.Handle));
+		break;
+	case EDeletionType::BufferView:
+		m_Device.destroyBufferView(FromValue<vk::BufferView>(entry.Handle));
+		break;
+	case EDeletionType::Image:
+		m_Device.destroyImage(FromValue<vk::Image>(entry.Handle));
+		break;
+	case EDeletionType::ImageView:
+		m_Device.destroyImageView(FromValue<vk::ImageView>(entry.Handle));
+		break;
+	case EDeletionType::Sampler:
+		m_Device.destroySampler(FromValue<vk::Sampler>(entry.Handle));
+		break;
+	case EDeletionType::Memory:
+		// through the allocator, which keeps the per-category totals
+		m_Memory->Free(FromValue<vk::DeviceMemory>(entry.Handle));
+		break;
+	case EDeletionType::Framebuffer:
+		m_Device.destroyFramebuffer(FromValue<vk::Framebuffer>(entry.Handle));
+		break;
+	case EDeletionType::RenderPass:
+		m_Device.destroyRenderPass(FromValue<vk::RenderPass>(entry.Handle));
+		break;
+	case EDeletionType::Pipeline:
+		m_Device.destroyPipeline(FromValue<vk::Pipeline>(entry.Handle));
+		break;
+	case EDeletionType::PipelineLayout:
+		m_Device.destroyPipelineLayout(FromValue<vk::PipelineLayout>(entry.Handle));
+		break;
+	case EDeletionType::DescriptorSetLayout:
+		m_Device.destroyDescriptorSetLayout(FromValue<vk::DescriptorSetLayout>(entry.Handle));
+		break;
+	case EDeletionType::DescriptorPool:
+		m_Device.destroyDescriptorPool(FromValue<vk::DescriptorPool>(entry.Handle));
+		break;
+	case EDeletionType::ShaderModule:
+		m_Device.destroyShaderModule(FromValue<vk::ShaderModule>(entry.Handle));
+		break;
+	default:
+		break;
+	}
+
+	m_Stats.Pending--;
+	m_Stats.Destroyed++;
+	m_Stats.TotalDestroyed++;
+}
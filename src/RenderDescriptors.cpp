@@ -0,0 +1,417 @@
+#include "RenderDescriptors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SDL.h"
+
+const uint32_t kDescriptorPoolRatioCount = sizeof(kDescriptorPoolRatios) / sizeof(kDescriptorPoolRatios[0]);
+
+EEngineStatus CRenderDescriptors::Initialize(const vk::Device device)
+{
+	m_Device = device;
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderDescriptors::Shutdown()
+{
+	const auto destroyPools = [&](std::vector<vk::DescriptorPool>& pools)
+	{
+		for (vk::DescriptorPool pool : pools)
+		{
+			m_Device.destroyDescriptorPool(pool);
+		}
+		pools.clear();
+	};
+
+	destroyPools(m_StaticChain.Pools);
+	for (SPoolChain& chain : m_FrameChains)
+	{
+		destroyPools(chain.Pools);
+		chain.Current = 0;
+	}
+	destroyPools(m_DedicatedPools);
+
+	m_StaticChain.Current = 0;
+	m_Stats = SDescriptorStats();
+}
+
+void CRenderDescriptors::BeginFrame(const uint32_t frameSlot)
+{
+	m_FrameSlot = frameSlot;
+
+	// resetting a pool frees all of its sets at once, the pools themselves are kept for the next frames
+	SPoolChain& chain = m_FrameChains[frameSlot];
+	for (uint32_t pool = 0; pool < chain.Pools.size() && pool <= chain.Current; pool++)
+	{
+		m_Device.resetDescriptorPool(chain.Pools[pool], {});
+	}
+	chain.Current = 0;
+
+	m_Stats.FrameSets = 0;
+}
+
+vk::DescriptorSet CRenderDescriptors::AllocateStatic(const vk::DescriptorSetLayout layout)
+{
+	const vk::DescriptorSet set = Allocate(m_StaticChain, layout);
+	if (set)
+	{
+		m_Stats.StaticSets++;
+	}
+	return set;
+}
+
+vk::DescriptorSet CRenderDescriptors::AllocateFrame(const vk::DescriptorSetLayout layout)
+{
+	const vk::DescriptorSet set = Allocate(m_FrameChains[m_FrameSlot], layout);
+	if (set)
+	{
+		m_Stats.FrameSets++;
+	}
+	return set;
+}
+
+vk::DescriptorPool CRenderDescriptors::CreateDedicatedPool(const uint32_t maxSets)
+{
+	// its owner may free sets individually
+	const vk::DescriptorPool pool = CreatePool(maxSets, vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
+	if (pool)
+	{
+		m_DedicatedPools.push_back(pool);
+	}
+	return pool;
+}
+
+const SDescriptorStats& CRenderDescriptors::GetStats() const
+{
+	return m_Stats;
+}
+
+vk::DescriptorSet CRenderDescriptors::Allocate(SPoolChain& chain, const vk::DescriptorSetLayout layout)
+{
+	for (;;)
+	{
+		const bool freshPool = chain.Current == chain.Pools.size();
+		if (freshPool)
+		{
+			const vk::DescriptorPool pool = CreatePool(m_NextPoolSets, {});
+			if (!pool)
+			{
+				return nullptr;
+			}
+
+			chain.Pools.push_back(pool);
+			m_NextPoolSets = std::min(m_NextPoolSets * 2, kDescriptorPoolMaxSets);
+
+			if (&chain == &m_StaticChain)
+			{
+				m_Stats.StaticPools++;
+			}
+			else
+			{
+				m_Stats.FramePools++;
+			}
+		}
+
+		const vk::DescriptorSetAllocateInfo allocateInfo = {
+			chain.Pools[chain.Current],
+			1,
+			&layout
+		};
+
+		vk::DescriptorSet set;
+		const vk::Result vkResult = m_Device.allocateDescriptorSets(&allocateInfo, &set);
+		if (vkResult == vk::Result::eSuccess)
+		{
+			return set;
+		}
+
+		if (vkResult != vk::Result::eErrorOutOfPoolMemory && vkResult != vk::Result::eErrorFragmentedPool)
+		{
+			SDL_Log("[CRenderDescriptors] Descriptor set allocation failed: %s", vk::to_string(vkResult).c_str());
+			return nullptr;
+		}
+
+		// the layout needs a type the pools do not reserve or more descriptors than a pool holds, moving on
+		// would only create pools that cannot hold it either; the empty pool is kept for the next sets
+		if (freshPool)
+		{
+			SDL_Log("[CRenderDescriptors] Descriptor set layout does not fit an empty pool");
+			return nullptr;
+		}
+
+		// a full pool stays full until it is reset, so the chain moves on for good
+		chain.Current++;
+	}
+}
+
+vk::DescriptorPool CRenderDescriptors::CreatePool(const uint32_t maxSets, const vk::DescriptorPoolCreateFlags flags)
+{
+	vk::DescriptorPoolSize poolSizes[kDescriptorPoolRatioCount];
+	for (uint32_t type = 0; type < kDescriptorPoolRatioCount; type++)
+	{
+		poolSizes[type] = { kDescriptorPoolRatios[type].Type, static_cast<uint32_t>(std::ceil(kDescriptorPoolRatios[type].PerSet * maxSets)) };
+	}
+
+	const vk::DescriptorPoolCreateInfo poolCreateInfo = {
+		flags,
+		maxSets,
+		kDescriptorPoolRatioCount,
+		poolSizes
+	};
+
+	vk::Result vkResult;
+	vk::DescriptorPool pool;
+	std::tie(vkResult, pool) = m_Device.createDescriptorPool(poolCreateInfo);
+	if (vkResult != vk::Result::eSuccess)
+	{
+		SDL_Log("[CRenderDescriptors] Descriptor pool creation failed: %s", vk::to_string(vkResult).c_str());
+		return nullptr;
+	}
+
+	return pool;
+}
+
+// the raw value of a non-dispatchable handle, which is a pointer or a 64-bit integer depending on the platform
+template <typename THandle>
+static uint64_t GetHandleValue(const THandle handle)
+{
+	static_assert(sizeof(THandle) <= sizeof(uint64_t), "handles must fit into 64 bits");
+	uint64_t value = 0;
+	memcpy(&value, &handle, sizeof(handle));
+	return value;
+}
+
+static uint64_t HashCombine(const uint64_t seed, uint64_t value)
+{
+	value *= 0x9E3779B97F4A7C15ull;
+	value ^= value >> 32;
+	return (seed ^ value) * 0x100000001B3ull;
+}
+
+static bool IsBufferDescriptor(const vk::DescriptorType type)
+{
+	return type == vk::DescriptorType::eUniformBuffer || type == vk::DescriptorType::eUniformBufferDynamic ||
+		type == vk::DescriptorType::eStorageBuffer || type == vk::DescriptorType::eStorageBufferDynamic;
+}
+
+static bool IsSameBinding(const SDescriptorBinding& a, const SDescriptorBinding& b)
+{
+	return a.Binding == b.Binding && a.Type == b.Type && a.Buffer == b.Buffer && a.Offset == b.Offset && a.Range == b.Range &&
+		a.ImageView == b.ImageView && a.Sampler == b.Sampler && a.ImageLayout == b.ImageLayout;
+}
+
+EEngineStatus CRenderDescriptorCache::Initialize(const vk::Device device, CRenderDescriptors* descriptors, CRenderSync* sync)
+{
+	m_Device = device;
+	m_Descriptors = descriptors;
+	m_Sync = sync;
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderDescriptorCache::Shutdown()
+{
+	// the sets go away with the allocator's pools
+	m_Entries.clear();
+	m_FreeEntries.clear();
+	m_Lookup.clear();
+	m_ResourceEntries.clear();
+	m_RetiredSets.clear();
+	m_FreeSets.clear();
+	m_Stats = SDescriptorCacheStats();
+}
+
+void CRenderDescriptorCache::Update()
+{
+	const auto firstPending = std::partition(m_RetiredSets.begin(), m_RetiredSets.end(), [&](const SRetiredSet& retired) { return m_Sync->IsFrameComplete(retired.Frame); });
+	for (auto it = m_RetiredSets.begin(); it != firstPending; ++it)
+	{
+		m_FreeSets.emplace(GetHandleValue(it->Layout), it->Set);
+	}
+	m_RetiredSets.erase(m_RetiredSets.begin(), firstPending);
+}
+
+vk::DescriptorSet CRenderDescriptorCache::Get(const vk::DescriptorSetLayout layout, const SDescriptorBinding* bindings, const uint32_t bindingCount)
+{
+	uint64_t hash = HashCombine(0, GetHandleValue(layout));
+	for (uint32_t binding = 0; binding < bindingCount; binding++)
+	{
+		const SDescriptorBinding& descriptor = bindings[binding];
+		hash = HashCombine(hash, (static_cast<uint64_t>(descriptor.Binding) << 32) | static_cast<uint64_t>(descriptor.Type));
+		hash = HashCombine(hash, GetHandleValue(descriptor.Buffer));
+		hash = HashCombine(hash, descriptor.Offset);
+		hash = HashCombine(hash, descriptor.Range);
+		hash = HashCombine(hash, GetHandleValue(descriptor.ImageView));
+		hash = HashCombine(hash, GetHandleValue(descriptor.Sampler));
+		hash = HashCombine(hash, static_cast<uint64_t>(descriptor.ImageLayout));
+	}
+
+	const auto range = m_Lookup.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		SEntry& entry = m_Entries[it->second];
+		if (entry.Layout == layout && entry.Bindings.size() == bindingCount && std::equal(entry.Bindings.begin(), entry.Bindings.end(), bindings, IsSameBinding))
+		{
+			entry.LastFrame = m_Sync->GetFrame();
+			m_Stats.Hits++;
+			return entry.Set;
+		}
+	}
+
+	// a miss reuses an evicted set of the same layout before allocating
+	vk::DescriptorSet set;
+	const auto freeSet = m_FreeSets.find(GetHandleValue(layout));
+	if (freeSet != m_FreeSets.end())
+	{
+		set = freeSet->second;
+		m_FreeSets.erase(freeSet);
+	}
+	else
+	{
+		set = m_Descriptors->AllocateStatic(layout);
+		if (!set)
+		{
+			return nullptr;
+		}
+	}
+
+	std::vector<vk::DescriptorBufferInfo> bufferInfos(bindingCount);
+	std::vector<vk::DescriptorImageInfo> imageInfos(bindingCount);
+	std::vector<vk::WriteDescriptorSet> writes(bindingCount);
+	for (uint32_t binding = 0; binding < bindingCount; binding++)
+	{
+		const SDescriptorBinding& descriptor = bindings[binding];
+		const bool isBuffer = IsBufferDescriptor(descriptor.Type);
+
+		bufferInfos[binding] = { descriptor.Buffer, descriptor.Offset, descriptor.Range };
+		imageInfos[binding] = { descriptor.Sampler, descriptor.ImageView, descriptor.ImageLayout };
+		writes[binding] = {
+			set,
+			descriptor.Binding,
+			0,
+			1,
+			descriptor.Type,
+			isBuffer ? nullptr : &imageInfos[binding],
+			isBuffer ? &bufferInfos[binding] : nullptr
+		};
+	}
+
+	m_Device.updateDescriptorSets(bindingCount, writes.data(), 0, nullptr);
+
+	uint32_t index;
+	if (!m_FreeEntries.empty())
+	{
+		index = m_FreeEntries.back();
+		m_FreeEntries.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_Entries.size());
+		m_Entries.emplace_back();
+	}
+
+	SEntry& entry = m_Entries[index];
+	entry.Layout = layout;
+	entry.Bindings.assign(bindings, bindings + bindingCount);
+	entry.Set = set;
+	entry.Hash = hash;
+	entry.LastFrame = m_Sync->GetFrame();
+	entry.Alive = true;
+
+	m_Lookup.emplace(hash, index);
+
+	for (const SDescriptorBinding& binding : entry.Bindings)
+	{
+		for (const uint64_t handle : { GetHandleValue(binding.Buffer), GetHandleValue(binding.ImageView), GetHandleValue(binding.Sampler) })
+		{
+			if (handle == 0)
+			{
+				continue;
+			}
+
+			std::vector<SEntryReference>& references = m_ResourceEntries[handle];
+			// long-lived resources collect references to evicted entries, dropped whenever the list would grow
+			if (references.size() == references.capacity())
+			{
+				references.erase(std::remove_if(references.begin(), references.end(), [&](const SEntryReference& reference)
+				{
+					return !m_Entries[reference.Entry].Alive || m_Entries[reference.Entry].Generation != reference.Generation;
+				}), references.end());
+			}
+			references.push_back({ index, entry.Generation });
+		}
+	}
+
+	m_Stats.Misses++;
+	m_Stats.Sets++;
+
+	return set;
+}
+
+void CRenderDescriptorCache::Invalidate(const vk::Buffer buffer)
+{
+	InvalidateHandle(GetHandleValue(buffer));
+}
+
+void CRenderDescriptorCache::Invalidate(const vk::ImageView imageView)
+{
+	InvalidateHandle(GetHandleValue(imageView));
+}
+
+void CRenderDescriptorCache::Invalidate(const vk::Sampler sampler)
+{
+	InvalidateHandle(GetHandleValue(sampler));
+}
+
+const SDescriptorCacheStats& CRenderDescriptorCache::GetStats() const
+{
+	return m_Stats;
+}
+
+void CRenderDescriptorCache::InvalidateHandle(const uint64_t handle)
+{
+	const auto references = m_ResourceEntries.find(handle);
+	if (references == m_ResourceEntries.end())
+	{
+		return;
+	}
+
+	for (const SEntryReference& reference : references->second)
+	{
+		if (m_Entries[reference.Entry].Alive && m_Entries[reference.Entry].Generation == reference.Generation)
+		{
+			Evict(reference.Entry);
+		}
+	}
+	m_ResourceEntries.erase(references);
+}
+
+void CRenderDescriptorCache::Evict(const uint32_t index)
+{
+	SEntry& entry = m_Entries[index];
+
+	const auto range = m_Lookup.equal_range(entry.Hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == index)
+		{
+			m_Lookup.erase(it);
+			break;
+		}
+	}
+
+	// frames still in flight may bind the set, it is rewritten only once they have finished
+	m_RetiredSets.push_back({ entry.Layout, entry.Set, entry.LastFrame });
+
+	entry.Bindings.clear();
+	entry.Set = nullptr;
+	entry.Alive = false;
+	entry.Generation++;
+	m_FreeEntries.push_back(index);
+
+	m_Stats.Sets--;
+	m_Stats.Evictions++;
+}
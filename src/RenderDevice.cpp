@@ -0,0 +1,197 @@
+#include "RenderDevice.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "SDL.h"
+
+static const char* GetVendorName(const uint32_t vendorId)
+{
+	switch (vendorId)
+	{
+	case kVendorIdNvidia:
+		return "NVIDIA ";
+	case kVendorIdAmd:
+		return "AMD ";
+	case kVendorIdIntel:
+		return "Intel ";
+	default:
+		return "";
+	}
+}
+
+static int64_t GetDeviceTypeScore(const vk::PhysicalDeviceType type, const bool preferSoftware)
+{
+	switch (type)
+	{
+	case vk::PhysicalDeviceType::eDiscreteGpu:
+		return 100000;
+	case vk::PhysicalDeviceType::eIntegratedGpu:
+		return 50000;
+	case vk::PhysicalDeviceType::eVirtualGpu:
+		return 20000;
+	case vk::PhysicalDeviceType::eCpu:
+		return preferSoftware ? 1000000 : 0;
+	default:
+		return 0;
+	}
+}
+
+static std::string ToLower(std::string value)
+{
+	std::transform(value.begin(), value.end(), value.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return value;
+}
+
+SPhysicalDeviceCandidate EvaluatePhysicalDevice(const vk::PhysicalDevice physicalDevice, const uint32_t index, const vk::SurfaceKHR surface, const vk::DispatchLoaderDynamic& dispatchLoader, const bool preferSoftware)
+{
+	SPhysicalDeviceCandidate candidate;
+	candidate.Device = physicalDevice;
+	candidate.Index = index;
+
+	const vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+	candidate.Name = std::string(GetVendorName(properties.vendorID)) + std::string(properties.deviceName);
+	candidate.Type = properties.deviceType;
+
+	if (properties.deviceType == vk::PhysicalDeviceType::eCpu && !preferSoftware)
+	{
+		candidate.RejectReason = "software device (pass --software-device to allow)";
+		return candidate;
+	}
+
+	// queue topology: a graphics family that can present is required, dedicated compute/transfer families are a bonus
+	const std::vector<vk::QueueFamilyProperties> queueFamilies = physicalDevice.getQueueFamilyProperties();
+
+	bool graphicsFound = false;
+	bool dedicatedCompute = false;
+	bool dedicatedTransfer = false;
+
+	for (uint32_t family = 0; family < queueFamilies.size(); family++)
+	{
+		const vk::QueueFlags flags = queueFamilies[family].queueFlags;
+
+		if ((flags & vk::QueueFlagBits::eGraphics) && !graphicsFound)
+		{
+			if (physicalDevice.getSurfaceSupportKHR(family, surface, dispatchLoader).value)
+			{
+				graphicsFound = true;
+				candidate.GraphicsFamily = family;
+			}
+		}
+		else if ((flags & vk::QueueFlagBits::eCompute) && !(flags & vk::QueueFlagBits::eGraphics))
+		{
+			dedicatedCompute = true;
+		}
+		else if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+		{
+			dedicatedTransfer = true;
+		}
+	}
+
+	if (!graphicsFound)
+	{
+		candidate.RejectReason = "no graphics queue family with presentation support";
+		return candidate;
+	}
+
+	// required extensions
+	vk::Result vkResult;
+	std::vector<vk::ExtensionProperties> extensions;
+	std::tie(vkResult, extensions) = physicalDevice.enumerateDeviceExtensionProperties();
+
+	const auto hasExtension = [&](const char* name)
+	{
+		return std::any_of(extensions.begin(), extensions.end(), [&](const vk::ExtensionProperties& extension) { return strcmp(extension.extensionName, name) == 0; });
+	};
+
+	if (vkResult != vk::Result::eSuccess || !hasExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+	{
+		candidate.RejectReason = "VK_KHR_swapchain is not supported";
+		return candidate;
+	}
+
+	candidate.Suitable = true;
+
+	int64_t score = GetDeviceTypeScore(properties.deviceType, preferSoftware);
+
+	// device-local memory, 100 points per GiB
+	const vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+	vk::DeviceSize deviceLocalBytes = 0;
+	for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++)
+	{
+		if (memoryProperties.memoryHeaps[heap].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+		{
+			deviceLocalBytes += memoryProperties.memoryHeaps[heap].size;
+		}
+	}
+	score += static_cast<int64_t>(deviceLocalBytes >> 30) * 100;
+
+	score += dedicatedCompute ? 500 : 0;
+	score += dedicatedTransfer ? 500 : 0;
+
+	// limits
+	score += properties.limits.maxImageDimension2D / 1024;
+	score += std::min<uint32_t>(properties.limits.maxPerStageDescriptorSampledImages, 1000000) / 10000;
+	score += properties.limits.timestampComputeAndGraphics ? 100 : 0;
+
+	// optional extensions and features used by the renderer
+	score += hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) ? 100 : 0;
+	score += physicalDevice.getFeatures().pipelineStatisticsQuery ? 50 : 0;
+
+	candidate.Score = score;
+
+	return candidate;
+}
+
+const SPhysicalDeviceCandidate* SelectPhysicalDevice(const std::vector<SPhysicalDeviceCandidate>& candidates, const std::string& request)
+{
+	if (!request.empty())
+	{
+		const bool isIndex = std::all_of(request.begin(), request.end(), [](const unsigned char c) { return std::isdigit(c) != 0; });
+		const std::string requestLower = ToLower(request);
+
+		// an index too large for a device matches none of them
+		uint64_t index = UINT64_MAX;
+		if (isIndex)
+		{
+			errno = 0;
+			const unsigned long long value = std::strtoull(request.c_str(), nullptr, 10);
+			if (errno == 0 && value <= UINT32_MAX)
+			{
+				index = value;
+			}
+		}
+
+		for (const SPhysicalDeviceCandidate& candidate : candidates)
+		{
+			const bool matches = isIndex ? candidate.Index == index : ToLower(candidate.Name).find(requestLower) != std::string::npos;
+			if (!matches)
+			{
+				continue;
+			}
+
+			if (!candidate.Suitable)
+			{
+				SDL_Log("[CRender] Requested device #%u (%s) is not suitable: %s", candidate.Index, candidate.Name.c_str(), candidate.RejectReason.c_str());
+				return nullptr;
+			}
+			return &candidate;
+		}
+
+		SDL_Log("[CRender] No device matches the requested device '%s'", request.c_str());
+		return nullptr;
+	}
+
+	const SPhysicalDeviceCandidate* best = nullptr;
+	for (const SPhysicalDeviceCandidate& candidate : candidates)
+	{
+		if (candidate.Suitable && (best == nullptr || candidate.Score > best->Score))
+		{
+			best = &candidate;
+		}
+	}
+	return best;
+}
@@ -0,0 +1,903 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+
+#include "SDL.h"
+
+struct SRenderGraphAccessInfo
+{
+	vk::AccessFlags Access;
+	vk::ImageLayout Layout;
+	vk::ImageUsageFlags ImageUsage;
+	vk::BufferUsageFlags BufferUsage;
+	bool Write;
+	bool Attachment;
+};
+
+static const SRenderGraphAccessInfo kRenderGraphAccessInfos[static_cast<uint32_t>(ERenderGraphAccess::Count)] = {
+	// ColorAttachment
+	{ vk::AccessFlagBits::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageUsageFlagBits::eColorAttachment, {}, true, true },
+	// DepthAttachment
+	{ vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, {}, true, true },
+	// ResolveAttachment
+	{ vk::AccessFlagBits::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageUsageFlagBits::eColorAttachment, {}, true, true },
+	// Sampled
+	{ vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageUsageFlagBits::eSampled, vk::BufferUsageFlagBits::eUniformBuffer, false, false },
+	// StorageRead
+	{ vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eGeneral, vk::ImageUsageFlagBits::eStorage, vk::BufferUsageFlagBits::eStorageBuffer, false, false },
+	// StorageWrite
+	{ vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, vk::ImageLayout::eGeneral, vk::ImageUsageFlagBits::eStorage, vk::BufferUsageFlagBits::eStorageBuffer, true, false },
+	// TransferRead
+	{ vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eTransferSrcOptimal, vk::ImageUsageFlagBits::eTransferSrc, vk::BufferUsageFlagBits::eTransferSrc, false, false },
+	// TransferWrite
+	{ vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eTransferDstOptimal, vk::ImageUsageFlagBits::eTransferDst, vk::BufferUsageFlagBits::eTransferDst, true, false }
+};
+
+// only writes have to be made available, reads just need the execution dependency
+const vk::AccessFlags kRenderGraphWriteAccess = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite;
+
+const vk::ImageUsageFlags kRenderGraphAttachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+
+static const SRenderGraphAccessInfo& GetAccessInfo(const ERenderGraphAccess access)
+{
+	return kRenderGraphAccessInfos[static_cast<uint32_t>(access)];
+}
+
+static vk::AccessFlags GetAccessMask(const ERenderGraphAccess access, const vk::AttachmentLoadOp loadOp)
+{
+	vk::AccessFlags mask = GetAccessInfo(access).Access;
+	if (access == ERenderGraphAccess::ColorAttachment && loadOp == vk::AttachmentLoadOp::eLoad)
+	{
+		mask |= vk::AccessFlagBits::eColorAttachmentRead;
+	}
+	return mask;
+}
+
+// whether the access depends on what earlier passes left in the resource
+static bool ReadsContents(const ERenderGraphAccess access, const vk::AttachmentLoadOp loadOp)
+{
+	const SRenderGraphAccessInfo& info = GetAccessInfo(access);
+	if (info.Attachment)
+	{
+		return loadOp == vk::AttachmentLoadOp::eLoad;
+	}
+	// storage writes may be partial, so they keep the previous contents alive
+	return !info.Write || access == ERenderGraphAccess::StorageWrite;
+}
+
+static vk::ImageAspectFlags GetFormatAspect(const vk::Format format)
+{
+	switch (format)
+	{
+	case vk::Format::eD16Unorm:
+	case vk::Format::eX8D24UnormPack32:
+	case vk::Format::eD32Sfloat:
+		return vk::ImageAspectFlagBits::eDepth;
+	case vk::Format::eD16UnormS8Uint:
+	case vk::Format::eD24UnormS8Uint:
+	case vk::Format::eD32SfloatS8Uint:
+		return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+	case vk::Format::eS8Uint:
+		return vk::ImageAspectFlagBits::eStencil;
+	default:
+		return vk::ImageAspectFlagBits::eColor;
+	}
+}
+
+EEngineStatus CRenderGraph::Initialize(const vk::PhysicalDevice physicalDevice, const vk::Device device, CRenderMemory* memory)
+{
+	m_Device = device;
+	m_Memory = memory;
+	// buffers and optimal images share the heaps, so every placement keeps them on separate pages
+	m_BufferImageGranularity = physicalDevice.getProperties().limits.bufferImageGranularity;
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderGraph::Shutdown()
+{
+	for (SPass& pass : m_Passes)
+	{
+		for (vk::Framebuffer frameBuffer : pass.FrameBuffers)
+		{
+			m_Device.destroyFramebuffer(frameBuffer);
+		}
+		m_Device.destroyRenderPass(pass.RenderPass);
+	}
+
+	for (SResource& resource : m_Resources)
+	{
+		m_Device.destroyImageView(resource.View);
+		m_Device.destroyImage(resource.Image);
+		m_Device.destroyBuffer(resource.Buffer);
+		if (resource.DedicatedMemory)
+		{
+			m_Memory->Free(resource.DedicatedMemory);
+		}
+	}
+
+	for (SHeap& heap : m_Heaps)
+	{
+		m_Memory->Free(heap.Memory);
+	}
+
+	m_Passes.clear();
+	m_Resources.clear();
+	m_Heaps.clear();
+	m_Stats = SRenderGraphStats();
+}
+
+uint32_t CRenderGraph::ImportImage(const char* name, const vk::Format format, const vk::Extent2D extent, const std::vector<vk::ImageView>& views, const vk::PipelineStageFlags initialStages, const vk::ImageLayout finalLayout)
+{
+	SResource resource;
+	resource.Name = name;
+	resource.Imported = true;
+	resource.Desc = { format, extent };
+	resource.ImportedViews = views;
+	resource.InitialStages = initialStages;
+	resource.FinalLayout = finalLayout;
+
+	m_Resources.push_back(resource);
+	return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+uint32_t CRenderGraph::CreateImage(const char* name, const SRenderGraphImageDesc& desc)
+{
+	SResource resource;
+	resource.Name = name;
+	resource.Desc = desc;
+
+	m_Resources.push_back(resource);
+	return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+uint32_t CRenderGraph::CreateBuffer(const char* name, const vk::DeviceSize size)
+{
+	SResource resource;
+	resource.Name = name;
+	resource.IsImage = false;
+	resource.Size = size;
+
+	m_Resources.push_back(resource);
+	return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+uint32_t CRenderGraph::AddPass(const char* name)
+{
+	SPass pass;
+	pass.Name = name;
+
+	m_Passes.push_back(pass);
+	m_Stats.PassCount = static_cast<uint32_t>(m_Passes.size());
+	return static_cast<uint32_t>(m_Passes.size() - 1);
+}
+
+void CRenderGraph::AddColorAttachment(const uint32_t pass, const uint32_t image, const vk::AttachmentLoadOp loadOp, const vk::ClearColorValue& clearColor, const uint32_t resolveImage)
+{
+	SAccess access;
+	access.Resource = image;
+	access.Access = ERenderGraphAccess::ColorAttachment;
+	access.Stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+	access.LoadOp = loadOp;
+	access.ClearValue = clearColor;
+
+	std::vector<SAccess>& accesses = m_Passes[pass].Accesses;
+	if (resolveImage != kInvalidRenderGraphResource)
+	{
+		SAccess resolve;
+		resolve.Resource = resolveImage;
+		resolve.Access = ERenderGraphAccess::ResolveAttachment;
+		resolve.Stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+
+		access.Resolve = static_cast<uint32_t>(accesses.size() + 1);
+		accesses.push_back(access);
+		accesses.push_back(resolve);
+	}
+	else
+	{
+		accesses.push_back(access);
+	}
+}
+
+void CRenderGraph::SetDepthAttachment(const uint32_t pass, const uint32_t image, const vk::AttachmentLoadOp loadOp, const vk::ClearDepthStencilValue& clearValue)
+{
+	SAccess access;
+	access.Resource = image;
+	access.Access = ERenderGraphAccess::DepthAttachment;
+	access.Stages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+	access.LoadOp = loadOp;
+	access.ClearValue = clearValue;
+
+	m_Passes[pass].Accesses.push_back(access);
+}
+
+void CRenderGraph::AddAccess(const uint32_t pass, const uint32_t resource, const ERenderGraphAccess access, const vk::PipelineStageFlags shaderStages)
+{
+	SAccess entry;
+	entry.Resource = resource;
+	entry.Access = access;
+	entry.Stages = access == ERenderGraphAccess::TransferRead || access == ERenderGraphAccess::TransferWrite ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer) : shaderStages;
+
+	m_Passes[pass].Accesses.push_back(entry);
+}
+
+void CRenderGraph::SetSideEffects(const uint32_t pass)
+{
+	m_Passes[pass].SideEffects = true;
+}
+
+EEngineStatus CRenderGraph::Compile()
+{
+	for (const SPass& pass : m_Passes)
+	{
+		for (const SAccess& access : pass.Accesses)
+		{
+			const SResource& resource = m_Resources[access.Resource];
+			const bool attachment = GetAccessInfo(access.Access).Attachment;
+			if ((resource.Imported && !attachment) || (!resource.IsImage && (attachment || access.Access == ERenderGraphAccess::Sampled)))
+			{
+				SDL_Log("[CRenderGraph] Pass %s cannot use %s as %u", pass.Name.c_str(), resource.Name.c_str(), static_cast<uint32_t>(access.Access));
+				return EEngineStatus::Failed;
+			}
+		}
+	}
+
+	CullPasses();
+
+	// the uses of every resource by the surviving passes, in execution order
+	std::vector<std::vector<SUse>> uses(m_Resources.size());
+	for (uint32_t pass = 0; pass < m_Passes.size(); pass++)
+	{
+		if (m_Passes[pass].Culled)
+		{
+			continue;
+		}
+
+		const std::vector<SAccess>& accesses = m_Passes[pass].Accesses;
+		for (uint32_t access = 0; access < accesses.size(); access++)
+		{
+			SResource& resource = m_Resources[accesses[access].Resource];
+			const SRenderGraphAccessInfo& info = GetAccessInfo(accesses[access].Access);
+
+			uses[accesses[access].Resource].push_back({ pass, access });
+			resource.FirstPass = std::min(resource.FirstPass, pass);
+			resource.LastPass = std::max(resource.LastPass, pass);
+			resource.LastStages = accesses[access].Stages;
+			resource.LastAccess = GetAccessMask(accesses[access].Access, accesses[access].LoadOp);
+			resource.ImageUsage |= info.ImageUsage;
+			resource.BufferUsage |= info.BufferUsage;
+		}
+	}
+
+	// the layout every attachment is left in is the one its next use needs, so that no pass has to transition it again
+	for (uint32_t resource = 0; resource < m_Resources.size(); resource++)
+	{
+		const std::vector<SUse>& resourceUses = uses[resource];
+		for (uint32_t use = 0; use < resourceUses.size(); use++)
+		{
+			SAccess& access = m_Passes[resourceUses[use].Pass].Accesses[resourceUses[use].Access];
+			const SRenderGraphAccessInfo& info = GetAccessInfo(access.Access);
+			if (!info.Attachment)
+			{
+				continue;
+			}
+
+			if (use + 1 < resourceUses.size())
+			{
+				const SAccess& next = m_Passes[resourceUses[use + 1].Pass].Accesses[resourceUses[use + 1].Access];
+				access.FinalLayout = GetAccessInfo(next.Access).Attachment ? info.Layout : GetAccessInfo(next.Access).Layout;
+			}
+			else
+			{
+				access.FinalLayout = m_Resources[resource].Imported ? m_Resources[resource].FinalLayout : info.Layout;
+			}
+		}
+	}
+
+	if (CreateResources() != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
+
+	for (uint32_t pass = 0; pass < m_Passes.size(); pass++)
+	{
+		if (m_Passes[pass].Culled)
+		{
+			continue;
+		}
+
+		if (CreateRenderPass(pass, uses) != EEngineStatus::Ok)
+		{
+			return EEngineStatus::Failed;
+		}
+		CreateBarriers(pass, uses);
+	}
+
+	SDL_Log("[CRenderGraph] %u passes (%u culled), %u transient resources (%u lazily allocated), %.2f MiB aliased into %.2f MiB, %u barriers",
+		m_Stats.PassCount, m_Stats.CulledPassCount, m_Stats.TransientCount, m_Stats.LazyCount,
+		static_cast<float>(m_Stats.TransientBytes) / (1 << 20), static_cast<float>(m_Stats.AllocatedBytes) / (1 << 20), m_Stats.BarrierCount);
+
+	return EEngineStatus::Ok;
+}
+
+bool CRenderGraph::BeginPass(const vk::CommandBuffer commandBuffer, const uint32_t pass, const uint32_t imageIndex, const vk::Extent2D renderExtent) const
+{
+	const SPass& entry = m_Passes[pass];
+	if (entry.Culled)
+	{
+		return false;
+	}
+
+	if (entry.BarrierDstStages)
+	{
+		const bool hasMemoryBarrier = entry.MemoryBarrier.srcAccessMask || entry.MemoryBarrier.dstAccessMask;
+		commandBuffer.pipelineBarrier(entry.BarrierSrcStages, entry.BarrierDstStages, {}, hasMemoryBarrier ? 1 : 0, &entry.MemoryBarrier, 0, nullptr,
+			static_cast<uint32_t>(entry.ImageBarriers.size()), entry.ImageBarriers.data());
+	}
+
+	if (entry.RenderPass)
+	{
+		const vk::RenderPassBeginInfo beginInfo = {
+			entry.RenderPass,
+			entry.FrameBuffers[imageIndex % entry.FrameBuffers.size()],
+			{
+				{0, 0},
+				renderExtent.width != 0 ? vk::Extent2D(std::min(renderExtent.width, entry.Extent.width), std::min(renderExtent.height, entry.Extent.height)) : entry.Extent
+			},
+			static_cast<uint32_t>(entry.ClearValues.size()),
+			entry.ClearValues.data()
+		};
+
+		commandBuffer.beginRenderPass(beginInfo, vk::SubpassContents::eInline);
+	}
+
+	return true;
+}
+
+void CRenderGraph::EndPass(const vk::CommandBuffer commandBuffer, const uint32_t pass) const
+{
+	if (m_Passes[pass].RenderPass)
+	{
+		commandBuffer.endRenderPass();
+	}
+}
+
+vk::RenderPass CRenderGraph::GetRenderPass(const uint32_t pass) const
+{
+	return m_Passes[pass].RenderPass;
+}
+
+vk::Image CRenderGraph::GetImage(const uint32_t resource) const
+{
+	return m_Resources[resource].Image;
+}
+
+vk::ImageView CRenderGraph::GetImageView(const uint32_t resource) const
+{
+	return m_Resources[resource].View;
+}
+
+vk::Buffer CRenderGraph::GetBuffer(const uint32_t resource) const
+{
+	return m_Resources[resource].Buffer;
+}
+
+const SRenderGraphStats& CRenderGraph::GetStats() const
+{
+	return m_Stats;
+}
+
+void CRenderGraph::CullPasses()
+{
+	// walking the passes backwards, a resource is needed while a later surviving pass reads what is in it;
+	// imported resources are the frame's output
+	std::vector<bool> needed(m_Resources.size());
+	for (uint32_t resource = 0; resource < m_Resources.size(); resource++)
+	{
+		needed[resource] = m_Resources[resource].Imported;
+	}
+
+	m_Stats.CulledPassCount = 0;
+	for (uint32_t pass = static_cast<uint32_t>(m_Passes.size()); pass-- > 0;)
+	{
+		SPass& entry = m_Passes[pass];
+
+		bool used = entry.SideEffects;
+		for (const SAccess& access : entry.Accesses)
+		{
+			used = used || (GetAccessInfo(access.Access).Write && needed[access.Resource]);
+		}
+
+		entry.Culled = !used;
+		if (entry.Culled)
+		{
+			SDL_Log("[CRenderGraph] Culling pass %s, nothing uses its results", entry.Name.c_str());
+			m_Stats.CulledPassCount++;
+			continue;
+		}
+
+		// a pass that overwrites a resource satisfies the later readers, one that reads it passes the need on
+		for (const SAccess& access : entry.Accesses)
+		{
+			if (GetAccessInfo(access.Access).Write && !ReadsContents(access.Access, access.LoadOp))
+			{
+				needed[access.Resource] = false;
+			}
+		}
+		for (const SAccess& access : entry.Accesses)
+		{
+			if (ReadsContents(access.Access, access.LoadOp))
+			{
+				needed[access.Resource] = true;
+			}
+		}
+	}
+}
+
+EEngineStatus CRenderGraph::CreateResources()
+{
+	vk::Result vkResult;
+
+	for (SResource& resource : m_Resources)
+	{
+		if (resource.Imported || resource.FirstPass == UINT32_MAX)
+		{
+			continue;
+		}
+
+		m_Stats.TransientCount++;
+
+		if (!resource.IsImage)
+		{
+			const vk::BufferCreateInfo bufferCreateInfo = {
+				{},
+				resource.Size,
+				resource.BufferUsage,
+				vk::SharingMode::eExclusive
+			};
+
+			std::tie(vkResult, resource.Buffer) = m_Device.createBuffer(bufferCreateInfo);
+			VKR(vkResult);
+
+			resource.Requirements = m_Device.getBufferMemoryRequirements(resource.Buffer);
+			continue;
+		}
+
+		// an image that lives inside a single render pass never needs its contents in memory
+		const bool transientAttachment = resource.FirstPass == resource.LastPass && !(resource.ImageUsage & ~kRenderGraphAttachmentUsage);
+
+		const vk::ImageCreateInfo imageCreateInfo = {
+			{},
+			vk::ImageType::e2D,
+			resource.Desc.Format,
+			{ resource.Desc.Extent.width, resource.Desc.Extent.height, 1 },
+			1,
+			1,
+			resource.Desc.Samples,
+			vk::ImageTiling::eOptimal,
+			transientAttachment ? resource.ImageUsage | vk::ImageUsageFlagBits::eTransientAttachment : resource.ImageUsage,
+			vk::SharingMode::eExclusive
+		};
+
+		std::tie(vkResult, resource.Image) = m_Device.createImage(imageCreateInfo);
+		VKR(vkResult);
+
+		resource.Requirements = m_Device.getImageMemoryRequirements(resource.Image);
+
+		// lazily allocated memory is only backed on demand, which on tilers means never; it gains nothing from aliasing
+		const uint32_t lazyMemoryType = transientAttachment ? m_Memory->FindMemoryType(resource.Requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eLazilyAllocated) : UINT32_MAX;
+		if (lazyMemoryType != UINT32_MAX)
+		{
+			const vk::MemoryAllocateInfo allocInfo = {
+				resource.Requirements.size,
+				lazyMemoryType
+			};
+
+			vkResult = m_Memory->Allocate(allocInfo, EMemoryCategory::RenderTarget, resource.DedicatedMemory);
+			VKR(vkResult);
+			vkResult = m_Device.bindImageMemory(resource.Image, resource.DedicatedMemory, 0);
+			VKR(vkResult);
+
+			m_Stats.LazyCount++;
+		}
+	}
+
+	PlaceResources();
+
+	for (SHeap& heap : m_Heaps)
+	{
+		const vk::MemoryAllocateInfo allocInfo = {
+			heap.Size,
+			heap.MemoryType
+		};
+
+		vkResult = m_Memory->Allocate(allocInfo, EMemoryCategory::RenderTarget, heap.Memory);
+		VKR(vkResult);
+	}
+
+	for (SResource& resource : m_Resources)
+	{
+		if (resource.Heap != UINT32_MAX)
+		{
+			if (resource.IsImage)
+			{
+				vkResult = m_Device.bindImageMemory(resource.Image, m_Heaps[resource.Heap].Memory, resource.Offset);
+			}
+			else
+			{
+				vkResult = m_Device.bindBufferMemory(resource.Buffer, m_Heaps[resource.Heap].Memory, resource.Offset);
+			}
+			VKR(vkResult);
+		}
+
+		if (resource.Image)
+		{
+			const vk::ImageViewCreateInfo viewCreateInfo = {
+				{},
+				resource.Image,
+				vk::ImageViewType::e2D,
+				resource.Desc.Format,
+				{},
+				{
+					GetFormatAspect(resource.Desc.Format),
+					0,
+					1,
+					0,
+					1
+				}
+			};
+
+			std::tie(vkResult, resource.View) = m_Device.createImageView(viewCreateInfo);
+			VKR(vkResult);
+		}
+	}
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderGraph::PlaceResources()
+{
+	std::vector<uint32_t> order;
+	for (uint32_t resource = 0; resource < m_Resources.size(); resource++)
+	{
+		const SResource& entry = m_Resources[resource];
+		if ((entry.Image || entry.Buffer) && !entry.DedicatedMemory)
+		{
+			order.push_back(resource);
+		}
+	}
+
+	// largest first, every resource then takes the lowest offset that no resource alive at the same time occupies
+	std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) { return m_Resources[a].Requirements.size > m_Resources[b].Requirements.size; });
+
+	for (uint32_t index = 0; index < order.size(); index++)
+	{
+		SResource& resource = m_Resources[order[index]];
+		const uint32_t memoryType = m_Memory->FindMemoryType(resource.Requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+		resource.Heap = 0;
+		while (resource.Heap < m_Heaps.size() && m_Heaps[resource.Heap].MemoryType != memoryType)
+		{
+			resource.Heap++;
+		}
+		if (resource.Heap == m_Heaps.size())
+		{
+			m_Heaps.push_back({ memoryType, 0, nullptr });
+		}
+
+		const vk::DeviceSize alignment = std::max(resource.Requirements.alignment, m_BufferImageGranularity);
+		const auto alignUp = [&](const vk::DeviceSize offset) { return (offset + alignment - 1) / alignment * alignment; };
+
+		// the candidates are the start of the heap and the end of every conflicting resource
+		std::vector<const SResource*> conflicts;
+		for (uint32_t placed = 0; placed < index; placed++)
+		{
+			const SResource& other = m_Resources[order[placed]];
+			if (other.Heap == resource.Heap && other.FirstPass <= resource.LastPass && resource.FirstPass <= other.LastPass)
+			{
+				conflicts.push_back(&other);
+			}
+		}
+
+		vk::DeviceSize best = UINT64_MAX;
+		for (uint32_t candidate = 0; candidate <= conflicts.size(); candidate++)
+		{
+			const vk::DeviceSize offset = candidate == 0 ? 0 : alignUp(conflicts[candidate - 1]->Offset + conflicts[candidate - 1]->Requirements.size);
+			const bool free = std::none_of(conflicts.begin(), conflicts.end(), [&](const SResource* other)
+			{
+				return offset < other->Offset + other->Requirements.size && other->Offset < offset + resource.Requirements.size;
+			});
+
+			if (free)
+			{
+				best = std::min(best, offset);
+			}
+		}
+
+		resource.Offset = best;
+		m_Heaps[resource.Heap].Size = std::max(m_Heaps[resource.Heap].Size, best + resource.Requirements.size);
+		m_Stats.TransientBytes += resource.Requirements.size;
+	}
+
+	for (const SHeap& heap : m_Heaps)
+	{
+		m_Stats.AllocatedBytes += heap.Size;
+	}
+}
+
+EEngineStatus CRenderGraph::CreateRenderPass(const uint32_t pass, const std::vector<std::vector<SUse>>& uses)
+{
+	vk::Result vkResult;
+	SPass& entry = m_Passes[pass];
+
+	std::vector<vk::AttachmentDescription> attachments;
+	std::vector<vk::AttachmentReference> colorRefs;
+	std::vector<vk::AttachmentReference> resolveRefs;
+	vk::AttachmentReference depthRef = { VK_ATTACHMENT_UNUSED, vk::ImageLayout::eUndefined };
+	bool hasResolve = false;
+	std::vector<uint32_t> attachmentResources;
+
+	vk::SubpassDependency incoming = { VK_SUBPASS_EXTERNAL, 0 };
+	vk::SubpassDependency outgoing = { 0, VK_SUBPASS_EXTERNAL };
+
+	std::vector<uint32_t> attachmentIndices(entry.Accesses.size(), VK_ATTACHMENT_UNUSED);
+	for (uint32_t access = 0; access < entry.Accesses.size(); access++)
+	{
+		const SAccess& current = entry.Accesses[access];
+		const SRenderGraphAccessInfo& info = GetAccessInfo(current.Access);
+		if (!info.Attachment)
+		{
+			continue;
+		}
+
+		const SResource& resource = m_Resources[current.Resource];
+		const std::vector<SUse>& resourceUses = uses[current.Resource];
+		const uint32_t use = static_cast<uint32_t>(std::find_if(resourceUses.begin(), resourceUses.end(), [&](const SUse& u) { return u.Pass == pass; }) - resourceUses.begin());
+		const SAccess* previous = use > 0 ? &m_Passes[resourceUses[use - 1].Pass].Accesses[resourceUses[use - 1].Access] : nullptr;
+		const SAccess* next = use + 1 < resourceUses.size() ? &m_Passes[resourceUses[use + 1].Pass].Accesses[resourceUses[use + 1].Access] : nullptr;
+
+		if (attachments.empty())
+		{
+			entry.Extent = resource.Desc.Extent;
+		}
+		else if (resource.Desc.Extent != entry.Extent)
+		{
+			SDL_Log("[CRenderGraph] Pass %s has attachments of different sizes", entry.Name.c_str());
+			return EEngineStatus::Failed;
+		}
+
+		// the contents only have to reach memory when a later use, or the frame's consumer, reads them
+		const bool store = next != nullptr ? ReadsContents(next->Access, next->LoadOp) : resource.Imported;
+		const vk::AttachmentLoadOp loadOp = current.Access == ERenderGraphAccess::ResolveAttachment ? vk::AttachmentLoadOp::eDontCare : current.LoadOp;
+		const bool load = loadOp == vk::AttachmentLoadOp::eLoad;
+
+		attachmentIndices[access] = static_cast<uint32_t>(attachments.size());
+		attachmentResources.push_back(current.Resource);
+		attachments.push_back({
+			{},
+			resource.Desc.Format,
+			resource.Desc.Samples,
+			loadOp,
+			store ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eDontCare,
+			load && previous != nullptr ? (GetAccessInfo(previous->Access).Attachment ? previous->FinalLayout : GetAccessInfo(previous->Access).Layout) : vk::ImageLayout::eUndefined,
+			current.FinalLayout
+		});
+		entry.ClearValues.push_back(current.ClearValue);
+
+		// waiting for the previous use; the first use of the frame waits for the import, or for whatever last
+		// used the resource's memory in the previous frame
+		if (previous != nullptr)
+		{
+			incoming.srcStageMask |= previous->Stages;
+			incoming.srcAccessMask |= GetAccessMask(previous->Access, previous->LoadOp) & kRenderGraphWriteAccess;
+		}
+		else if (resource.Imported)
+		{
+			incoming.srcStageMask |= resource.InitialStages;
+		}
+		else
+		{
+			for (const SResource& other : m_Resources)
+			{
+				if (SharesMemory(resource, other))
+				{
+					incoming.srcStageMask |= other.LastStages;
+					incoming.srcAccessMask |= other.LastAccess & kRenderGraphWriteAccess;
+				}
+			}
+		}
+		incoming.dstStageMask |= current.Stages;
+		incoming.dstAccessMask |= GetAccessMask(current.Access, loadOp);
+
+		// a following shader or transfer access has no render pass of its own to wait in
+		if (next != nullptr ? !GetAccessInfo(next->Access).Attachment : resource.Imported)
+		{
+			outgoing.srcStageMask |= current.Stages;
+			outgoing.srcAccessMask |= GetAccessMask(current.Access, loadOp) & kRenderGraphWriteAccess;
+			outgoing.dstStageMask |= next != nullptr ? next->Stages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eBottomOfPipe);
+			outgoing.dstAccessMask |= next != nullptr ? GetAccessMask(next->Access, next->LoadOp) : vk::AccessFlags();
+		}
+	}
+
+	if (attachments.empty())
+	{
+		return EEngineStatus::Ok;
+	}
+
+	for (uint32_t access = 0; access < entry.Accesses.size(); access++)
+	{
+		const SAccess& current = entry.Accesses[access];
+		const vk::AttachmentReference reference = { attachmentIndices[access], GetAccessInfo(current.Access).Layout };
+
+		if (current.Access == ERenderGraphAccess::ColorAttachment)
+		{
+			colorRefs.push_back(reference);
+			resolveRefs.push_back({ current.Resolve != UINT32_MAX ? attachmentIndices[current.Resolve] : VK_ATTACHMENT_UNUSED, vk::ImageLayout::eColorAttachmentOptimal });
+			hasResolve = hasResolve || current.Resolve != UINT32_MAX;
+		}
+		else if (current.Access == ERenderGraphAccess::DepthAttachment)
+		{
+			depthRef = reference;
+		}
+	}
+
+	const vk::SubpassDescription subPassDesc = {
+		{},
+		vk::PipelineBindPoint::eGraphics,
+		0,
+		nullptr,
+		static_cast<uint32_t>(colorRefs.size()),
+		colorRefs.data(),
+		hasResolve ? resolveRefs.data() : nullptr,
+		depthRef.attachment != VK_ATTACHMENT_UNUSED ? &depthRef : nullptr
+	};
+
+	if (!incoming.srcStageMask)
+	{
+		incoming.srcStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
+	}
+
+	const vk::SubpassDependency dependencies[] = { incoming, outgoing };
+
+	const vk::RenderPassCreateInfo renderPassCreateInfo = {
+		{},
+		static_cast<uint32_t>(attachments.size()),
+		attachments.data(),
+		1,
+		&subPassDesc,
+		outgoing.dstStageMask ? 2u : 1u,
+		dependencies
+	};
+
+	std::tie(vkResult, entry.RenderPass) = m_Device.createRenderPass(renderPassCreateInfo);
+	VKR(vkResult);
+
+	m_Stats.BarrierCount += outgoing.dstStageMask ? 2 : 1;
+
+	// one framebuffer per view of the imported attachments
+	size_t frameBufferCount = 1;
+	for (const uint32_t resource : attachmentResources)
+	{
+		frameBufferCount = std::max(frameBufferCount, m_Resources[resource].ImportedViews.size());
+	}
+
+	entry.FrameBuffers.resize(frameBufferCount);
+	for (size_t i = 0; i < frameBufferCount; i++)
+	{
+		std::vector<vk::ImageView> views;
+		for (const uint32_t resource : attachmentResources)
+		{
+			const SResource& entryResource = m_Resources[resource];
+			views.push_back(entryResource.Imported ? entryResource.ImportedViews[i % entryResource.ImportedViews.size()] : entryResource.View);
+		}
+
+		const vk::FramebufferCreateInfo frameBufferCreateInfo = {
+			{},
+			entry.RenderPass,
+			static_cast<uint32_t>(views.size()),
+			views.data(),
+			entry.Extent.width,
+			entry.Extent.height,
+			1
+		};
+
+		std::tie(vkResult, entry.FrameBuffers[i]) = m_Device.createFramebuffer(frameBufferCreateInfo);
+		VKR(vkResult);
+	}
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderGraph::CreateBarriers(const uint32_t pass, const std::vector<std::vector<SUse>>& uses)
+{
+	SPass& entry = m_Passes[pass];
+
+	for (const SAccess& current : entry.Accesses)
+	{
+		const SRenderGraphAccessInfo& info = GetAccessInfo(current.Access);
+		if (info.Attachment)
+		{
+			continue;
+		}
+
+		const SResource& resource = m_Resources[current.Resource];
+		const std::vector<SUse>& resourceUses = uses[current.Resource];
+		const uint32_t use = static_cast<uint32_t>(std::find_if(resourceUses.begin(), resourceUses.end(), [&](const SUse& u) { return u.Pass == pass; }) - resourceUses.begin());
+		const SAccess* previous = use > 0 ? &m_Passes[resourceUses[use - 1].Pass].Accesses[resourceUses[use - 1].Access] : nullptr;
+
+		vk::PipelineStageFlags srcStages;
+		vk::AccessFlags srcAccess;
+		vk::ImageLayout oldLayout = vk::ImageLayout::eUndefined;
+		if (previous != nullptr)
+		{
+			const SRenderGraphAccessInfo& previousInfo = GetAccessInfo(previous->Access);
+			// the render pass that wrote it already made it visible here, in the right layout
+			if (previousInfo.Attachment)
+			{
+				continue;
+			}
+			// reads after reads in the same layout do not conflict
+			if (!previousInfo.Write && !info.Write && previousInfo.Layout == info.Layout)
+			{
+				continue;
+			}
+
+			srcStages = previous->Stages;
+			srcAccess = previousInfo.Access & kRenderGraphWriteAccess;
+			oldLayout = previousInfo.Layout;
+		}
+		else
+		{
+			for (const SResource& other : m_Resources)
+			{
+				if (SharesMemory(resource, other))
+				{
+					srcStages |= other.LastStages;
+					srcAccess |= other.LastAccess & kRenderGraphWriteAccess;
+				}
+			}
+		}
+
+		entry.BarrierSrcStages |= srcStages ? srcStages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe);
+		entry.BarrierDstStages |= current.Stages;
+
+		if (resource.IsImage && oldLayout != info.Layout)
+		{
+			entry.ImageBarriers.push_back({
+				srcAccess,
+				info.Access,
+				oldLayout,
+				info.Layout,
+				VK_QUEUE_FAMILY_IGNORED,
+				VK_QUEUE_FAMILY_IGNORED,
+				resource.Image,
+				{
+					GetFormatAspect(resource.Desc.Format),
+					0,
+					1,
+					0,
+					1
+				}
+			});
+		}
+		else
+		{
+			entry.MemoryBarrier.srcAccessMask |= srcAccess;
+			entry.MemoryBarrier.dstAccessMask |= info.Access;
+		}
+
+		m_Stats.BarrierCount++;
+	}
+}
+
+bool CRenderGraph::SharesMemory(const SResource& a, const SResource& b) const
+{
+	if (&a == &b)
+	{
+		return true;
+	}
+
+	return a.Heap != UINT32_MAX && a.Heap == b.Heap && a.Offset < b.Offset + b.Requirements.size && b.Offset < a.Offset + a.Requirements.size;
+}
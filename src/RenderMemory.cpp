@@ -0,0 +1,179 @@
+#include "RenderMemory.h"
+
+#include <algorithm>
+
+#include "SDL.h"
+
+void CRenderMemory::Initialize(const vk::PhysicalDevice physicalDevice, const vk::Device device, const bool hasMemoryBudget, const vk::DispatchLoaderDynamic* dispatchLoader)
+{
+	m_PhysicalDevice = physicalDevice;
+	m_Device = device;
+	m_HasMemoryBudget = hasMemoryBudget;
+	m_DispatchLoader = dispatchLoader;
+
+	m_MemoryProperties = physicalDevice.getMemoryProperties();
+	m_MaxAllocationCount = physicalDevice.getProperties().limits.maxMemoryAllocationCount;
+
+	for (uint32_t heap = 0; heap < m_MemoryProperties.memoryHeapCount; heap++)
+	{
+		m_Heaps[heap].Size = m_MemoryProperties.memoryHeaps[heap].size;
+		m_Heaps[heap].DeviceLocal = static_cast<bool>(m_MemoryProperties.memoryHeaps[heap].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+	}
+
+	SDL_Log("[CRenderMemory] %u memory heaps, %u max allocations, VK_EXT_memory_budget %s", m_MemoryProperties.memoryHeapCount, m_MaxAllocationCount, hasMemoryBudget ? "available" : "unavailable");
+
+	Update();
+}
+
+void CRenderMemory::Shutdown()
+{
+	if (!m_Allocations.empty())
+	{
+		SDL_Log("[CRenderMemory] %u allocations were not freed before shutdown", static_cast<uint32_t>(m_Allocations.size()));
+	}
+	m_Allocations.clear();
+}
+
+vk::Result CRenderMemory::Allocate(const vk::MemoryAllocateInfo& allocateInfo, const EMemoryCategory category, vk::DeviceMemory& memory)
+{
+	vk::Result vkResult;
+	std::tie(vkResult, memory) = m_Device.allocateMemory(allocateInfo);
+
+	if (vkResult != vk::Result::eSuccess)
+	{
+		SDL_Log("[CRenderMemory] Failed to allocate %llu bytes (%s): %s", static_cast<unsigned long long>(allocateInfo.allocationSize), kMemoryCategoryNames[static_cast<uint32_t>(category)], vk::to_string(vkResult).c_str());
+		return vkResult;
+	}
+
+	const uint32_t heap = m_MemoryProperties.memoryTypes[allocateInfo.memoryTypeIndex].heapIndex;
+	m_Allocations[static_cast<VkDeviceMemory>(memory)] = { allocateInfo.allocationSize, heap, category };
+
+	m_Heaps[heap].TrackedUsage += allocateInfo.allocationSize;
+	m_CategoryBytes[static_cast<uint32_t>(category)] += allocateInfo.allocationSize;
+	m_TrackedBytes += allocateInfo.allocationSize;
+	m_PeakTrackedBytes = std::max(m_PeakTrackedBytes, m_TrackedBytes);
+
+	return vkResult;
+}
+
+void CRenderMemory::Free(const vk::DeviceMemory memory)
+{
+	if (!memory)
+	{
+		return;
+	}
+
+	const auto it = m_Allocations.find(static_cast<VkDeviceMemory>(memory));
+	if (it != m_Allocations.end())
+	{
+		const SAllocation& allocation = it->second;
+		m_Heaps[allocation.Heap].TrackedUsage -= allocation.Size;
+		m_CategoryBytes[static_cast<uint32_t>(allocation.Category)] -= allocation.Size;
+		m_TrackedBytes -= allocation.Size;
+		m_Allocations.erase(it);
+	}
+
+	m_Device.freeMemory(memory);
+}
+
+uint32_t CRenderMemory::FindMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+{
+	for (uint32_t type = 0; type < m_MemoryProperties.memoryTypeCount; type++)
+	{
+		if ((typeFilter & (1 << type)) && (m_MemoryProperties.memoryTypes[type].propertyFlags & properties) == properties)
+		{
+			return type;
+		}
+	}
+	return UINT32_MAX;
+}
+
+uint32_t CRenderMemory::GetMemoryTypeHeap(const uint32_t memoryType) const
+{
+	return m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+}
+
+void CRenderMemory::Update()
+{
+	vk::PhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+
+	if (m_HasMemoryBudget)
+	{
+		vk::PhysicalDeviceMemoryProperties2 memoryProperties2;
+		memoryProperties2.pNext = &budgetProperties;
+		m_PhysicalDevice.getMemoryProperties2KHR(&memoryProperties2, *m_DispatchLoader);
+	}
+
+	for (uint32_t heap = 0; heap < m_MemoryProperties.memoryHeapCount; heap++)
+	{
+		SMemoryHeapInfo& heapInfo = m_Heaps[heap];
+
+		if (m_HasMemoryBudget)
+		{
+			// the budget extension accounts for other processes and allocations we do not see (e.g. ImGui's)
+			heapInfo.Budget = budgetProperties.heapBudget[heap];
+			heapInfo.Usage = budgetProperties.heapUsage[heap];
+		}
+		else
+		{
+			// without the extension 80% of the heap is the commonly recommended upper bound
+			heapInfo.Budget = heapInfo.Size / 5 * 4;
+			heapInfo.Usage = heapInfo.TrackedUsage;
+		}
+
+		heapInfo.PeakUsage = std::max(heapInfo.PeakUsage, heapInfo.Usage);
+
+		const bool low = IsHeapLow(heap);
+		if (low && !m_HeapLowReported[heap])
+		{
+			SDL_Log("[CRenderMemory] Heap %u is running low: %llu of %llu MiB budget used", heap, static_cast<unsigned long long>(heapInfo.Usage >> 20), static_cast<unsigned long long>(heapInfo.Budget >> 20));
+		}
+		m_HeapLowReported[heap] = low;
+	}
+}
+
+bool CRenderMemory::HasMemoryBudget() const
+{
+	return m_HasMemoryBudget;
+}
+
+uint32_t CRenderMemory::GetHeapCount() const
+{
+	return m_MemoryProperties.memoryHeapCount;
+}
+
+const SMemoryHeapInfo& CRenderMemory::GetHeapInfo(const uint32_t heap) const
+{
+	return m_Heaps[heap];
+}
+
+bool CRenderMemory::IsHeapLow(const uint32_t heap) const
+{
+	const SMemoryHeapInfo& heapInfo = m_Heaps[heap];
+	return heapInfo.Budget != 0 && static_cast<float>(heapInfo.Usage) >= static_cast<float>(heapInfo.Budget) * kMemoryBudgetWarningThreshold;
+}
+
+uint32_t CRenderMemory::GetAllocationCount() const
+{
+	return static_cast<uint32_t>(m_Allocations.size());
+}
+
+uint32_t CRenderMemory::GetMaxAllocationCount() const
+{
+	return m_MaxAllocationCount;
+}
+
+vk::DeviceSize CRenderMemory::GetCategoryBytes(const EMemoryCategory category) const
+{
+	return m_CategoryBytes[static_cast<uint32_t>(category)];
+}
+
+vk::DeviceSize CRenderMemory::GetTrackedBytes() const
+{
+	return m_TrackedBytes;
+}
+
+vk::DeviceSize CRenderMemory::GetPeakTrackedBytes() const
+{
+	return m_PeakTrackedBytes;
+}
@@ -0,0 +1,202 @@
+#include "RenderProfiler.h"
+
+#include "SDL.h"
+
+EEngineStatus CRenderProfiler::Initialize(const vk::PhysicalDevice physicalDevice, const vk::Device device, const uint32_t queueFamily, const uint32_t frameCount, const vk::PhysicalDeviceFeatures& enabledFeatures)
+{
+	vk::Result vkResult;
+
+	m_Device = device;
+	m_FrameCount = frameCount;
+
+	const vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+	const std::vector<vk::QueueFamilyProperties> queueFamilies = physicalDevice.getQueueFamilyProperties();
+	const uint32_t timestampValidBits = queueFamilies[queueFamily].timestampValidBits;
+
+	m_TimestampPeriod = properties.limits.timestampPeriod;
+	m_TimestampMask = timestampValidBits >= 64 ? UINT64_MAX : ((uint64_t(1) << timestampValidBits) - 1);
+	m_PreciseOcclusion = enabledFeatures.occlusionQueryPrecise;
+
+	if (timestampValidBits != 0)
+	{
+		const vk::QueryPoolCreateInfo timestampPoolCreateInfo = {
+			{},
+			vk::QueryType::eTimestamp,
+			frameCount * kRenderPassCount * 2
+		};
+
+		std::tie(vkResult, m_TimestampPool) = m_Device.createQueryPool(timestampPoolCreateInfo);
+		VKR(vkResult);
+	}
+	else
+	{
+		SDL_Log("[CRenderProfiler] Timestamps are not supported by the graphics queue");
+	}
+
+	if (enabledFeatures.pipelineStatisticsQuery)
+	{
+		const vk::QueryPoolCreateInfo statisticsPoolCreateInfo = {
+			{},
+			vk::QueryType::ePipelineStatistics,
+			frameCount * kRenderPassCount,
+			vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+			vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+			vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+			vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+			vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+			vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations
+		};
+
+		std::tie(vkResult, m_PipelineStatisticsPool) = m_Device.createQueryPool(statisticsPoolCreateInfo);
+		VKR(vkResult);
+	}
+	else
+	{
+		SDL_Log("[CRenderProfiler] Pipeline statistics queries are not supported by the device");
+	}
+
+	const vk::QueryPoolCreateInfo occlusionPoolCreateInfo = {
+		{},
+		vk::QueryType::eOcclusion,
+		frameCount * kRenderPassCount
+	};
+
+	std::tie(vkResult, m_OcclusionPool) = m_Device.createQueryPool(occlusionPoolCreateInfo);
+	VKR(vkResult);
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderProfiler::Shutdown()
+{
+	if (m_TimestampPool)
+	{
+		m_Device.destroyQueryPool(m_TimestampPool);
+	}
+	if (m_PipelineStatisticsPool)
+	{
+		m_Device.destroyQueryPool(m_PipelineStatisticsPool);
+	}
+	if (m_OcclusionPool)
+	{
+		m_Device.destroyQueryPool(m_OcclusionPool);
+	}
+}
+
+void CRenderProfiler::ResetQueries(const vk::CommandBuffer commandBuffer, const uint32_t frame) const
+{
+	if (m_TimestampPool)
+	{
+		commandBuffer.resetQueryPool(m_TimestampPool, frame * kRenderPassCount * 2, kRenderPassCount * 2);
+	}
+	if (m_PipelineStatisticsPool)
+	{
+		commandBuffer.resetQueryPool(m_PipelineStatisticsPool, frame * kRenderPassCount, kRenderPassCount);
+	}
+	commandBuffer.resetQueryPool(m_OcclusionPool, frame * kRenderPassCount, kRenderPassCount);
+}
+
+void CRenderProfiler::BeginPass(const vk::CommandBuffer commandBuffer, const uint32_t frame, const ERenderPass pass) const
+{
+	const uint32_t query = frame * kRenderPassCount + static_cast<uint32_t>(pass);
+
+	if (m_TimestampPool)
+	{
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_TimestampPool, query * 2);
+	}
+	if (HasPipelineStatistics())
+	{
+		commandBuffer.beginQuery(m_PipelineStatisticsPool, query, {});
+	}
+	commandBuffer.beginQuery(m_OcclusionPool, query, m_PreciseOcclusion ? vk::QueryControlFlagBits::ePrecise : vk::QueryControlFlags());
+}
+
+void CRenderProfiler::EndPass(const vk::CommandBuffer commandBuffer, const uint32_t frame, const ERenderPass pass) const
+{
+	const uint32_t query = frame * kRenderPassCount + static_cast<uint32_t>(pass);
+
+	commandBuffer.endQuery(m_OcclusionPool, query);
+	if (HasPipelineStatistics())
+	{
+		commandBuffer.endQuery(m_PipelineStatisticsPool, query);
+	}
+	if (m_TimestampPool)
+	{
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_TimestampPool, query * 2 + 1);
+	}
+}
+
+void CRenderProfiler::CollectResults(const uint32_t frame)
+{
+	vk::Result vkResult;
+
+	// results that are not ready yet keep the previous values instead of stalling
+	if (m_TimestampPool)
+	{
+		uint64_t timestamps[kRenderPassCount * 2];
+		vkResult = m_Device.getQueryPoolResults(m_TimestampPool, frame * kRenderPassCount * 2, kRenderPassCount * 2, sizeof(timestamps), timestamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+		if (vkResult == vk::Result::eSuccess)
+		{
+			for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+			{
+				const uint64_t ticks = ((timestamps[pass * 2 + 1] & m_TimestampMask) - (timestamps[pass * 2] & m_TimestampMask)) & m_TimestampMask;
+				m_PassStatistics[pass].GpuTimeMs = static_cast<float>(static_cast<double>(ticks) * m_TimestampPeriod * 1e-6);
+			}
+		}
+	}
+
+	if (HasPipelineStatistics())
+	{
+		uint64_t statistics[kRenderPassCount][kPipelineStatisticCount];
+		vkResult = m_Device.getQueryPoolResults(m_PipelineStatisticsPool, frame * kRenderPassCount, kRenderPassCount, sizeof(statistics), statistics, sizeof(statistics[0]), vk::QueryResultFlagBits::e64);
+		if (vkResult == vk::Result::eSuccess)
+		{
+			for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+			{
+				// results are written in the order of the statistic bits
+				SRenderPassStatistics& passStatistics = m_PassStatistics[pass];
+				passStatistics.InputAssemblyVertices = statistics[pass][0];
+				passStatistics.InputAssemblyPrimitives = statistics[pass][1];
+				passStatistics.VertexShaderInvocations = statistics[pass][2];
+				passStatistics.ClippingInvocations = statistics[pass][3];
+				passStatistics.ClippingPrimitives = statistics[pass][4];
+				passStatistics.FragmentShaderInvocations = statistics[pass][5];
+			}
+		}
+	}
+
+	uint64_t samplesPassed[kRenderPassCount];
+	vkResult = m_Device.getQueryPoolResults(m_OcclusionPool, frame * kRenderPassCount, kRenderPassCount, sizeof(samplesPassed), samplesPassed, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (vkResult == vk::Result::eSuccess)
+	{
+		for (uint32_t pass = 0; pass < kRenderPassCount; pass++)
+		{
+			m_PassStatistics[pass].SamplesPassed = samplesPassed[pass];
+		}
+	}
+}
+
+void CRenderProfiler::SetCpuTime(const ERenderPass pass, const float cpuTimeMs)
+{
+	m_PassStatistics[static_cast<uint32_t>(pass)].CpuTimeMs = cpuTimeMs;
+}
+
+bool CRenderProfiler::HasTimestamps() const
+{
+	return static_cast<bool>(m_TimestampPool);
+}
+
+bool CRenderProfiler::HasPipelineStatistics() const
+{
+	return m_PipelineStatisticsEnabled && static_cast<bool>(m_PipelineStatisticsPool);
+}
+
+bool CRenderProfiler::HasOcclusionQueries() const
+{
+	return static_cast<bool>(m_OcclusionPool);
+}
+
+const SRenderPassStatistics& CRenderProfiler::GetPassStatistics(const ERenderPass pass) const
+{
+	return m_PassStatistics[static_cast<uint32_t>(pass)];
+}
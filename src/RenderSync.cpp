@@ -0,0 +1,384 @@
+#include "RenderSync.h"
+
+#include <algorithm>
+
+#include "SDL.h"
+
+EEngineStatus CRenderSync::Initialize(const vk::Device device, const bool useTimelineSemaphores, const vk::DispatchLoaderDynamic* dispatchLoader)
+{
+	m_Device = device;
+	m_DispatchLoader = dispatchLoader;
+	m_UseTimelineSemaphores = useTimelineSemaphores;
+
+	vk::Result vkResult;
+
+	const vk::SemaphoreCreateInfo semaphoreCreateInfo = {};
+	for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+	{
+		std::tie(vkResult, m_ImageAvailableSemaphores[slot]) = m_Device.createSemaphore(semaphoreCreateInfo);
+		VKR(vkResult);
+		std::tie(vkResult, m_RenderFinishedSemaphores[slot]) = m_Device.createSemaphore(semaphoreCreateInfo);
+		VKR(vkResult);
+	}
+
+	if (m_UseTimelineSemaphores)
+	{
+		const vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo = { vk::SemaphoreType::eTimeline, 0 };
+		vk::SemaphoreCreateInfo timelineCreateInfo = {};
+		timelineCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+		for (uint32_t queue = 0; queue < kRenderQueueCount; queue++)
+		{
+			std::tie(vkResult, m_Timelines[queue]) = m_Device.createSemaphore(timelineCreateInfo);
+			VKR(vkResult);
+		}
+	}
+
+	SDL_Log("[CRenderSync] %u frames in flight, %s", kMaxFramesInFlight, m_UseTimelineSemaphores ? "timeline semaphores" : "binary semaphores and fences");
+
+	return EEngineStatus::Ok;
+}
+
+void CRenderSync::Shutdown()
+{
+	for (uint32_t slot = 0; slot < kMaxFramesInFlight; slot++)
+	{
+		m_Device.destroySemaphore(m_ImageAvailableSemaphores[slot]);
+		m_Device.destroySemaphore(m_RenderFinishedSemaphores[slot]);
+	}
+
+	for (uint32_t queue = 0; queue < kRenderQueueCount; queue++)
+	{
+		m_Device.destroySemaphore(m_Timelines[queue]);
+
+		for (const auto& pending : m_PendingFences[queue])
+		{
+			m_Device.destroyFence(pending.second);
+		}
+		m_PendingFences[queue].clear();
+	}
+
+	for (const vk::Fence fence : m_FreeFences)
+	{
+		m_Device.destroyFence(fence);
+	}
+	m_FreeFences.clear();
+}
+
+void CRenderSync::SetQueue(const ERenderQueue queue, const vk::Queue vkQueue)
+{
+	m_Queues[static_cast<uint32_t>(queue)] = vkQueue;
+}
+
+EEngineStatus CRenderSync::BeginFrame()
+{
+	m_Frame++;
+
+	// the slot is free once the frame submitted kMaxFramesInFlight frames ago has finished
+	if (m_Frame > kMaxFramesInFlight)
+	{
+		if (WaitForFrame(m_Frame - kMaxFramesInFlight) != EEngineStatus::Ok)
+		{
+			return EEngineStatus::Failed;
+		}
+	}
+
+	const uint32_t slot = GetFrameSlot();
+	m_FrameNumbers[slot] = m_Frame;
+	m_FrameValues[slot] = 0;
+
+	return EEngineStatus::Ok;
+}
+
+vk::Result CRenderSync::SubmitFrame(const vk::CommandBuffer* commandBuffers, const uint32_t commandBufferCount, const SQueueDependency* dependencies, const uint32_t dependencyCount)
+{
+	const vk::Result vkResult = SubmitInternal(ERenderQueue::Graphics, commandBuffers, commandBufferCount, dependencies, dependencyCount, true);
+	if (vkResult == vk::Result::eSuccess)
+	{
+		m_FrameValues[GetFrameSlot()] = m_SubmittedValues[static_cast<uint32_t>(ERenderQueue::Graphics)];
+	}
+	return vkResult;
+}
+
+uint64_t CRenderSync::Submit(const ERenderQueue queue, const vk::CommandBuffer* commandBuffers, const uint32_t commandBufferCount, const SQueueDependency* dependencies, const uint32_t dependencyCount)
+{
+	if (SubmitInternal(queue, commandBuffers, commandBufferCount, dependencies, dependencyCount, false) != vk::Result::eSuccess)
+	{
+		return 0;
+	}
+	return m_SubmittedValues[static_cast<uint32_t>(queue)];
+}
+
+vk::Result CRenderSync::SubmitInternal(const ERenderQueue queue, const vk::CommandBuffer* commandBuffers, const uint32_t commandBufferCount, const SQueueDependency* dependencies, const uint32_t dependencyCount, const bool frameSubmit)
+{
+	const uint32_t queueIndex = static_cast<uint32_t>(queue);
+	const uint32_t slot = GetFrameSlot();
+
+	vk::Semaphore waitSemaphores[kMaxQueueDependencies + 1];
+	uint64_t waitValues[kMaxQueueDependencies + 1] = {};
+	vk::PipelineStageFlags waitStages[kMaxQueueDependencies + 1];
+	uint32_t waitCount = 0;
+
+	vk::Semaphore signalSemaphores[2];
+	uint64_t signalValues[2] = {};
+	uint32_t signalCount = 0;
+
+	if (frameSubmit)
+	{
+		waitSemaphores[waitCount] = m_ImageAvailableSemaphores[slot];
+		waitStages[waitCount] = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		waitCount++;
+
+		signalSemaphores[signalCount++] = m_RenderFinishedSemaphores[slot];
+	}
+
+	for (uint32_t dependency = 0; dependency < std::min(dependencyCount, kMaxQueueDependencies); dependency++)
+	{
+		const SQueueDependency& queueDependency = dependencies[dependency];
+		if (queueDependency.Queue == queue || IsQueueValueComplete(queueDependency.Queue, queueDependency.Value))
+		{
+			// same-queue ordering is covered by submission order and barriers
+			continue;
+		}
+
+		if (m_UseTimelineSemaphores)
+		{
+			waitSemaphores[waitCount] = m_Timelines[static_cast<uint32_t>(queueDependency.Queue)];
+			waitValues[waitCount] = queueDependency.Value;
+			waitStages[waitCount] = queueDependency.Stage;
+			waitCount++;
+		}
+		else if (WaitForQueueValue(queueDependency.Queue, queueDependency.Value) != EEngineStatus::Ok)
+		{
+			// binary semaphores cannot express a wait on an arbitrary value, fall back to waiting on the CPU
+			return vk::Result::eErrorDeviceLost;
+		}
+	}
+
+	const uint64_t value = m_SubmittedValues[queueIndex] + 1;
+
+	vk::Fence fence;
+	vk::Result vkResult;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo;
+	vk::SubmitInfo submitInfo = { waitCount, waitSemaphores, waitStages, commandBufferCount, commandBuffers, 0, signalSemaphores };
+
+	if (m_UseTimelineSemaphores)
+	{
+		signalSemaphores[signalCount] = m_Timelines[queueIndex];
+		signalValues[signalCount] = value;
+		signalCount++;
+
+		// binary semaphores in the same submission ignore their values
+		timelineSubmitInfo = { waitCount, waitValues, signalCount, signalValues };
+		submitInfo.pNext = &timelineSubmitInfo;
+	}
+	else if (m_FreeFences.empty())
+	{
+		std::tie(vkResult, fence) = m_Device.createFence(vk::FenceCreateInfo());
+		if (vkResult != vk::Result::eSuccess)
+		{
+			return vkResult;
+		}
+	}
+	else
+	{
+		fence = m_FreeFences.back();
+		m_FreeFences.pop_back();
+	}
+
+	submitInfo.signalSemaphoreCount = signalCount;
+
+	vkResult = m_Queues[queueIndex].submit(1, &submitInfo, fence);
+	if (vkResult != vk::Result::eSuccess)
+	{
+		if (fence)
+		{
+			m_FreeFences.push_back(fence);
+		}
+		return vkResult;
+	}
+
+	if (fence)
+	{
+		m_PendingFences[queueIndex].emplace_back(value, fence);
+	}
+
+	m_SubmittedValues[queueIndex] = value;
+
+	return vk::Result::eSuccess;
+}
+
+void CRenderSync::RefreshCompletedValue(const ERenderQueue queue)
+{
+	const uint32_t queueIndex = static_cast<uint32_t>(queue);
+
+	if (m_UseTimelineSemaphores)
+	{
+		vk::Result vkResult;
+		uint64_t value;
+		std::tie(vkResult, value) = m_Device.getSemaphoreCounterValue(m_Timelines[queueIndex], *m_DispatchLoader);
+		if (vkResult == vk::Result::eSuccess)
+		{
+			m_CompletedValues[queueIndex] = std::max(m_CompletedValues[queueIndex], value);
+		}
+		return;
+	}
+
+	std::deque<std::pair<uint64_t, vk::Fence>>& pending = m_PendingFences[queueIndex];
+	while (!pending.empty() && m_Device.getFenceStatus(pending.front().second) == vk::Result::eSuccess)
+	{
+		m_CompletedValues[queueIndex] = pending.front().first;
+
+		m_Device.resetFences(1, &pending.front().second);
+		m_FreeFences.push_back(pending.front().second);
+		pending.pop_front();
+	}
+}
+
+uint64_t CRenderSync::GetFrame() const
+{
+	return m_Frame;
+}
+
+uint32_t CRenderSync::GetFrameSlot() const
+{
+	return static_cast<uint32_t>(m_Frame % kMaxFramesInFlight);
+}
+
+vk::Semaphore CRenderSync::GetImageAvailableSemaphore() const
+{
+	return m_ImageAvailableSemaphores[GetFrameSlot()];
+}
+
+vk::Semaphore CRenderSync::GetRenderFinishedSemaphore() const
+{
+	return m_RenderFinishedSemaphores[GetFrameSlot()];
+}
+
+bool CRenderSync::IsFrameComplete(const uint64_t frame)
+{
+	if (frame <= m_CompletedFrame)
+	{
+		return true;
+	}
+
+	if (frame > m_Frame)
+	{
+		return false;
+	}
+
+	// frames older than the slots still in use have been waited on by BeginFrame
+	if (frame + kMaxFramesInFlight <= m_Frame)
+	{
+		m_CompletedFrame = std::max(m_CompletedFrame, frame);
+		return true;
+	}
+
+	const uint32_t slot = static_cast<uint32_t>(frame % kMaxFramesInFlight);
+	if (m_FrameNumbers[slot] != frame || m_FrameValues[slot] == 0)
+	{
+		// not submitted yet
+		return false;
+	}
+
+	if (IsQueueValueComplete(ERenderQueue::Graphics, m_FrameValues[slot]))
+	{
+		m_CompletedFrame = frame;
+		return true;
+	}
+
+	return false;
+}
+
+EEngineStatus CRenderSync::WaitForFrame(const uint64_t frame)
+{
+	if (IsFrameComplete(frame))
+	{
+		return EEngineStatus::Ok;
+	}
+
+	const uint32_t slot = static_cast<uint32_t>(frame % kMaxFramesInFlight);
+	if (frame > m_Frame || m_FrameNumbers[slot] != frame || m_FrameValues[slot] == 0)
+	{
+		SDL_Log("[CRenderSync] Cannot wait for frame %llu, it has not been submitted", static_cast<unsigned long long>(frame));
+		return EEngineStatus::Failed;
+	}
+
+	if (WaitForQueueValue(ERenderQueue::Graphics, m_FrameValues[slot]) != EEngineStatus::Ok)
+	{
+		return EEngineStatus::Failed;
+	}
+
+	m_CompletedFrame = std::max(m_CompletedFrame, frame);
+	return EEngineStatus::Ok;
+}
+
+uint64_t CRenderSync::GetCompletedFrame()
+{
+	for (uint64_t frame = m_CompletedFrame + 1; frame <= m_Frame && IsFrameComplete(frame); frame++)
+	{
+	}
+	return m_CompletedFrame;
+}
+
+uint64_t CRenderSync::GetQueueValue(const ERenderQueue queue) const
+{
+	return m_SubmittedValues[static_cast<uint32_t>(queue)];
+}
+
+bool CRenderSync::IsQueueValueComplete(const ERenderQueue queue, const uint64_t value)
+{
+	const uint32_t queueIndex = static_cast<uint32_t>(queue);
+	if (value <= m_CompletedValues[queueIndex])
+	{
+		return true;
+	}
+
+	RefreshCompletedValue(queue);
+	return value <= m_CompletedValues[queueIndex];
+}
+
+EEngineStatus CRenderSync::WaitForQueueValue(const ERenderQueue queue, const uint64_t value)
+{
+	const uint32_t queueIndex = static_cast<uint32_t>(queue);
+	if (IsQueueValueComplete(queue, value))
+	{
+		return EEngineStatus::Ok;
+	}
+
+	if (value > m_SubmittedValues[queueIndex])
+	{
+		SDL_Log("[CRenderSync] Cannot wait for value %llu, it has not been submitted", static_cast<unsigned long long>(value));
+		return EEngineStatus::Failed;
+	}
+
+	vk::Result vkResult;
+
+	if (m_UseTimelineSemaphores)
+	{
+		const vk::SemaphoreWaitInfo waitInfo = { {}, 1, &m_Timelines[queueIndex], &value };
+		vkResult = m_Device.waitSemaphores(waitInfo, UINT64_MAX, *m_DispatchLoader);
+	}
+	else
+	{
+		// the first pending fence at or past the value covers it, submissions on a queue complete in order
+		const auto& pending = m_PendingFences[queueIndex];
+		const auto it = std::find_if(pending.begin(), pending.end(), [&](const std::pair<uint64_t, vk::Fence>& entry) { return entry.first >= value; });
+		if (it == pending.end())
+		{
+			return EEngineStatus::Failed;
+		}
+		vkResult = m_Device.waitForFences(1, &it->second, VK_TRUE, UINT64_MAX);
+	}
+
+	VKR(vkResult);
+
+	RefreshCompletedValue(queue);
+	return EEngineStatus::Ok;
+}
+
+bool CRenderSync::UsesTimelineSemaphores() const
+{
+	return m_UseTimelineSemaphores;
+}
@@ -0,0 +1,240 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#include "JobSystem.h"
+#include "Simd.h"
+
+static_assert(kSceneSimdWidth % kSimdLanes == 0, "scene arrays must be padded to the SIMD width");
+
+static uint32_t PadCount(const uint32_t count)
+{
+	return (count + kSceneSimdWidth - 1) / kSceneSimdWidth * kSceneSimdWidth;
+}
+
+// integrates one axis and reflects objects off the bounds, saving the old positions for interpolation
+static void IntegrateAxis(float* position, float* previous, float* velocity, const float boundsMin, const float boundsMax, const float timeStep, const uint32_t count)
+{
+	const SimdFloat dt = SimdSet(timeStep);
+	const SimdFloat lower = SimdSet(boundsMin);
+	const SimdFloat upper = SimdSet(boundsMax);
+	const SimdFloat lowerTwice = SimdSet(2.f * boundsMin);
+	const SimdFloat upperTwice = SimdSet(2.f * boundsMax);
+	const SimdFloat zero = SimdSet(0.f);
+
+	for (uint32_t i = 0; i < count; i += kSimdLanes)
+	{
+		const SimdFloat oldPosition = SimdLoad(position + i);
+		SimdFloat v = SimdLoad(velocity + i);
+		SimdFloat p = SimdAdd(oldPosition, SimdMul(v, dt));
+
+		const SimdMask below = SimdLess(p, lower);
+		const SimdMask above = SimdLess(upper, p);
+		p = SimdSelect(below, SimdSub(lowerTwice, p), SimdSelect(above, SimdSub(upperTwice, p), p));
+		v = SimdSelect(SimdOr(below, above), SimdSub(zero, v), v);
+		// objects faster than the box is wide would otherwise be reflected past the other side
+		p = SimdMax(lower, SimdMin(upper, p));
+
+		SimdStore(previous + i, oldPosition);
+		SimdStore(position + i, p);
+		SimdStore(velocity + i, v);
+	}
+}
+
+// advances the angles and wraps both interpolation ends together so that the rendered angle does not sweep back
+static void IntegrateAngle(float* angle, float* previous, const float* angularVelocity, const float timeStep, const uint32_t count)
+{
+	const SimdFloat dt = SimdSet(timeStep);
+	const SimdFloat zero = SimdSet(0.f);
+	const SimdFloat fullTurn = SimdSet(360.f);
+	const SimdFloat negativeTurn = SimdSet(-360.f);
+
+	for (uint32_t i = 0; i < count; i += kSimdLanes)
+	{
+		const SimdFloat oldAngle = SimdLoad(angle + i);
+		const SimdFloat a = SimdAdd(oldAngle, SimdMul(SimdLoad(angularVelocity + i), dt));
+		const SimdFloat wrap = SimdSelect(SimdGreaterEqual(a, fullTurn), negativeTurn, SimdSelect(SimdLess(a, zero), fullTurn, zero));
+
+		SimdStore(previous + i, SimdAdd(oldAngle, wrap));
+		SimdStore(angle + i, SimdAdd(a, wrap));
+	}
+}
+
+// the object list is ascending, so the reads stay sequential however sparse it is
+static void InterpolateGather(const float* previous, const float* current, const float interpolation, const uint32_t* objects, const uint32_t count, float* destination)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t object = objects[i];
+		destination[i] = previous[object] + (current[object] - previous[object]) * interpolation;
+	}
+}
+
+void CScene::Reserve(const uint32_t capacity)
+{
+	const uint32_t padded = PadCount(capacity);
+	if (padded <= m_PositionX.size())
+	{
+		return;
+	}
+
+	for (std::vector<float>* stream : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_Angle, &m_PreviousX, &m_PreviousY, &m_PreviousZ, &m_PreviousAngle,
+		&m_VelocityX, &m_VelocityY, &m_VelocityZ, &m_AngularVelocity, &m_Scale, &m_BoundsRadius })
+	{
+		// padding lanes stay zero: they do not move and have no extent
+		stream->resize(padded, 0.f);
+	}
+	m_Lods.resize(padded, 0);
+}
+
+void CScene::Clear()
+{
+	m_Count = 0;
+	m_MaxSpeed = 0.f;
+	m_Stats.ObjectCount = 0;
+	for (std::vector<float>* stream : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_Angle, &m_PreviousX, &m_PreviousY, &m_PreviousZ, &m_PreviousAngle,
+		&m_VelocityX, &m_VelocityY, &m_VelocityZ, &m_AngularVelocity, &m_Scale, &m_BoundsRadius })
+	{
+		std::fill(stream->begin(), stream->end(), 0.f);
+	}
+	std::fill(m_Lods.begin(), m_Lods.end(), static_cast<uint8_t>(0));
+}
+
+uint32_t CScene::AddObject(const glm::vec3& position, const glm::vec3& velocity, const float angle, const float angularVelocity, const float scale, const float boundsRadius)
+{
+	if (m_Count == m_PositionX.size())
+	{
+		Reserve(std::max<uint32_t>(kSceneSimdWidth, m_Count * 2));
+	}
+
+	const uint32_t object = m_Count++;
+	m_PositionX[object] = m_PreviousX[object] = position.x;
+	m_PositionY[object] = m_PreviousY[object] = position.y;
+	m_PositionZ[object] = m_PreviousZ[object] = position.z;
+	m_Angle[object] = m_PreviousAngle[object] = angle;
+	m_Lods[object] = 0;
+	m_VelocityX[object] = velocity.x;
+	m_VelocityY[object] = velocity.y;
+	m_VelocityZ[object] = velocity.z;
+	m_AngularVelocity[object] = angularVelocity;
+	m_Scale[object] = scale;
+	m_BoundsRadius[object] = boundsRadius * scale;
+	m_MaxSpeed = std::max(m_MaxSpeed, glm::length(velocity));
+
+	m_Stats.ObjectCount = m_Count;
+	return object;
+}
+
+void CScene::Spawn(const uint32_t count, const uint32_t seed, const float boundsRadius)
+{
+	Reserve(m_Count + count);
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	const auto range = [&](const float lower, const float upper) { return lower + (upper - lower) * unit(random); };
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const glm::vec3 position = {
+			range(kSceneBoundsMin.x, kSceneBoundsMax.x),
+			range(kSceneBoundsMin.y, kSceneBoundsMax.y),
+			range(kSceneBoundsMin.z, kSceneBoundsMax.z)
+		};
+		const glm::vec3 velocity = { range(-0.5f, 0.5f), range(-0.5f, 0.5f), range(-0.1f, 0.1f) };
+
+		AddObject(position, velocity, range(0.f, 360.f), range(-180.f, 180.f), range(0.02f, 0.06f), boundsRadius);
+	}
+}
+
+void CScene::Simulate(const float timeStep, CJobSystem* jobs)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	const uint32_t count = PadCount(m_Count);
+
+	static_assert(kSceneSimulateBatchSize % kSceneSimdWidth == 0, "simulation batches must start on a SIMD boundary");
+
+	// objects are independent, so large scenes are integrated in batches on every thread
+	jobs->ParallelFor(count, kSceneSimulateBatchSize, [&](const uint32_t begin, const uint32_t end)
+	{
+		const uint32_t batchCount = end - begin;
+		IntegrateAxis(m_PositionX.data() + begin, m_PreviousX.data() + begin, m_VelocityX.data() + begin, kSceneBoundsMin.x, kSceneBoundsMax.x, timeStep, batchCount);
+		IntegrateAxis(m_PositionY.data() + begin, m_PreviousY.data() + begin, m_VelocityY.data() + begin, kSceneBoundsMin.y, kSceneBoundsMax.y, timeStep, batchCount);
+		IntegrateAxis(m_PositionZ.data() + begin, m_PreviousZ.data() + begin, m_VelocityZ.data() + begin, kSceneBoundsMin.z, kSceneBoundsMax.z, timeStep, batchCount);
+		IntegrateAngle(m_Angle.data() + begin, m_PreviousAngle.data() + begin, m_AngularVelocity.data() + begin, timeStep, batchCount);
+	});
+
+	m_Stats.SimulateMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void CScene::WriteInstances(const float interpolation, const uint32_t* objects, const uint32_t objectCount, float* const streams[kSceneStreamCount])
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	InterpolateGather(m_PreviousX.data(), m_PositionX.data(), interpolation, objects, objectCount, streams[static_cast<uint32_t>(ESceneStream::PositionX)]);
+	InterpolateGather(m_PreviousY.data(), m_PositionY.data(), interpolation, objects, objectCount, streams[static_cast<uint32_t>(ESceneStream::PositionY)]);
+	InterpolateGather(m_PreviousZ.data(), m_PositionZ.data(), interpolation, objects, objectCount, streams[static_cast<uint32_t>(ESceneStream::PositionZ)]);
+	InterpolateGather(m_PreviousAngle.data(), m_Angle.data(), interpolation, objects, objectCount, streams[static_cast<uint32_t>(ESceneStream::Angle)]);
+
+	float* scale = streams[static_cast<uint32_t>(ESceneStream::Scale)];
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		scale[i] = m_Scale[objects[i]];
+	}
+
+	m_Stats.WrittenCount = objectCount;
+
+	m_Stats.WriteMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+uint32_t CScene::GetObjectCount() const
+{
+	return m_Count;
+}
+
+uint32_t CScene::GetPaddedObjectCount() const
+{
+	return PadCount(m_Count);
+}
+
+const float* CScene::GetPositionX() const
+{
+	return m_PositionX.data();
+}
+
+const float* CScene::GetPositionY() const
+{
+	return m_PositionY.data();
+}
+
+const float* CScene::GetPositionZ() const
+{
+	return m_PositionZ.data();
+}
+
+const float* CScene::GetScale() const
+{
+	return m_Scale.data();
+}
+
+const float* CScene::GetBoundsRadius() const
+{
+	return m_BoundsRadius.data();
+}
+
+uint8_t* CScene::GetLods()
+{
+	return m_Lods.data();
+}
+
+float CScene::GetMaxSpeed() const
+{
+	return m_MaxSpeed;
+}
+
+const SSceneStats& CScene::GetStats() const
+{
+	return m_Stats;
+}
@@ -0,0 +1,851 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "RenderBindless.h"
+#include "RenderDeletionQueue.h"
+#include "RenderMemory.h"
+#include "RenderSync.h"
+#include "SDL.h"
+
+const vk::PipelineStageFlags kTextureShaderStages = vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+// copy regions are placed at this alignment in the staging buffer, a multiple of every supported block size
+const vk::DeviceSize kTextureStagingAlignment = 16;
+
+struct STextureFormatBlock
+{
+	uint32_t Bytes;
+	uint32_t Dimension;
+};
+
+static bool GetFormatBlock(const vk::Format format, STextureFormatBlock& block)
+{
+	switch (format)
+	{
+	case vk::Format::eR8Unorm:
+		block = { 1, 1 };
+		return true;
+	case vk::Format::eR8G8Unorm:
+		block = { 2, 1 };
+		return true;
+	case vk::Format::eR8G8B8A8Unorm:
+	case vk::Format::eR8G8B8A8Srgb:
+	case vk::Format::eB8G8R8A8Unorm:
+	case vk::Format::eB8G8R8A8Srgb:
+		block = { 4, 1 };
+		return true;
+	case vk::Format::eR16G16B16A16Sfloat:
+		block = { 8, 1 };
+		return true;
+	case vk::Format::eBc1RgbaUnormBlock:
+	case vk::Format::eBc1RgbaSrgbBlock:
+	case vk::Format::eBc4UnormBlock:
+		block = { 8, 4 };
+		return true;
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc3SrgbBlock:
+	case vk::Format::eBc5UnormBlock:
+	case vk::Format::eBc7UnormBlock:
+	case vk::Format::eBc7SrgbBlock:
+		block = { 16, 4 };
+		return true;
+	default:
+		return false;
+	}
+}
+
+static uint32_t GetMipDimension(const uint32_t dimension, const uint32_t mip)
+{
+	return std::max(dimension >> mip, 1u);
+}
+
+static vk::DeviceSize GetMipBytes(const STextureFormatBlock& block, const uint32_t width, const uint32_t height, const uint32_t mip)
+{
+	const vk::DeviceSize blocksX = (GetMipDimension(width, mip) + block.Dimension - 1) / block.Dimension;
+	const vk::DeviceSize blocksY = (GetMipDimension(height, mip) + block.Dimension - 1) / block.Dimension;
+	return blocksX * blocksY * block.Bytes;
+}
+
+static void RecordImageBarrier(const vk::CommandBuffer commandBuffer, const vk::Image image, const uint32_t levelCount, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout, const vk::PipelineStageFlags srcStages, const vk::AccessFlags srcAccess, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+{
+	const vk::ImageMemoryBarrier barrier = {
+		srcAccess,
+		dstAccess,
+		oldLayout,
+		newLayout,
+		VK_QUEUE_FAMILY_IGNORED,
+		VK_QUEUE_FAMILY_IGNORED,
+		image,
+		{
+			vk::ImageAspectFlagBits::eColor,
+			0,
+			levelCount,
+			0,
+			1
+		}
+	};
+
+	commandBuffer.pipelineBarrier(srcStages, dstStages, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+EEngineStatus CTextureStreamer::Initialize(const vk::Device device, CRenderMemory* memory, CRenderSync* sync, CRenderDeletionQueue* deletionQueue, CRenderBindless* bindless)
+{
+	vk::Result vkResult;
+
+	m_Device = device;
+	m_Memory = memory;
+	m_Sync = sync;
+	m_DeletionQueue = deletionQueue;
+	m_Bindless = bindless;
+
+	const vk::SamplerCreateInfo samplerCreateInfo = {
+		{},
+		vk::Filter::eLinear,
+		vk::Filter::eLinear,
+		vk::SamplerMipmapMode::eLinear,
+		vk::SamplerAddressMode::eRepeat,
+		vk::SamplerAddressMode::eRepeat,
+		vk::SamplerAddressMode::eRepeat,
+		0.f,
+		false,
+		1.f,
+		false,
+		vk::CompareOp::eNever,
+		0.f,
+		VK_LOD_CLAMP_NONE
+	};
+
+	std::tie(vkResult, m_Sampler) = m_Device.createSampler(samplerCreateInfo);
+	VKR(vkResult);
+
+	// one staging region per frame slot, reused once BeginFrame has waited for the slot
+	const vk::BufferCreateInfo stagingCreateInfo = {
+		{},
+		kTextureStagingBytesPerFrame * kMaxFramesInFlight,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		vk::SharingMode::eExclusive
+	};
+
+	std::tie(vkResult, m_StagingBuffer) = m_Device.createBuffer(stagingCreateInfo);
+	VKR(vkResult);
+
+	const vk::MemoryRequirements memoryRequirements = m_Device.getBufferMemoryRequirements(m_StagingBuffer);
+	const vk::MemoryAllocateInfo stagingAllocInfo = {
+		memoryRequirements.size,
+		m_Memory->FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+	};
+
+	vkResult = m_Memory->Allocate(stagingAllocInfo, EMemoryCategory::Staging, m_StagingMemory);
+	VKR(vkResult);
+	vkResult = m_Device.bindBufferMemory(m_StagingBuffer, m_StagingMemory, 0);
+	VKR(vkResult);
+
+	void* stagingMapped;
+	vkResult = m_Device.mapMemory(m_StagingMemory, 0, VK_WHOLE_SIZE, {}, &stagingMapped);
+	VKR(vkResult);
+	m_StagingMapped = static_cast<uint8_t*>(stagingMapped);
+
+	// the heap textures live in, for the budget
+	const vk::ImageCreateInfo probeCreateInfo = {
+		{},
+		vk::ImageType::e2D,
+		vk::Format::eR8G8B8A8Unorm,
+		{ 64, 64, 1 },
+		1,
+		1,
+		vk::SampleCountFlagBits::e1,
+		vk::ImageTiling::eOptimal,
+		vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
+	};
+
+	vk::Image probeImage;
+	std::tie(vkResult, probeImage) = m_Device.createImage(probeCreateInfo);
+	VKR(vkResult);
+	const uint32_t probeType = m_Memory->FindMemoryType(m_Device.getImageMemoryRequirements(probeImage).memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+	m_Device.destroyImage(probeImage);
+	m_ImageMemoryHeap = probeType != UINT32_MAX ? m_Memory->GetMemoryTypeHeap(probeType) : 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_DecodeMutex);
+		m_StopWorkers = false;
+	}
+	for (uint32_t worker = 0; worker < kTextureStreamingWorkerCount; worker++)
+	{
+		m_Workers.emplace_back(&CTextureStreamer::WorkerMain, this);
+	}
+
+	SDL_Log("[CTextureStreamer] %u workers, %llu MiB staging per frame", kTextureStreamingWorkerCount, static_cast<unsigned long long>(kTextureStagingBytesPerFrame >> 20));
+
+	return EEngineStatus::Ok;
+}
+
+void CTextureStreamer::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_DecodeMutex);
+		m_StopWorkers = true;
+		m_DecodeRequests.clear();
+	}
+	m_DecodeCondition.notify_all();
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+	m_Workers.clear();
+	m_DecodeResults.clear();
+
+	// the caller has waited for the device to go idle and shuts the deletion queue down after this
+	for (uint32_t texture = 0; texture < m_Textures.size(); texture++)
+	{
+		if (m_Textures[texture].InUse)
+		{
+			Unload(texture);
+		}
+	}
+
+	if (m_StagingBuffer)
+	{
+		m_Device.destroyBuffer(m_StagingBuffer);
+		m_Memory->Free(m_StagingMemory);
+	}
+	if (m_Sampler)
+	{
+		m_Device.destroySampler(m_Sampler);
+	}
+}
+
+uint32_t CTextureStreamer::Load(const std::string& path)
+{
+	uint32_t index;
+	if (!m_FreeTextures.empty())
+	{
+		index = m_FreeTextures.back();
+		m_FreeTextures.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_Textures.size());
+		m_Textures.emplace_back();
+	}
+
+	STexture& texture = m_Textures[index];
+	const uint32_t generation = texture.Generation + 1;
+	texture = STexture();
+	texture.InUse = true;
+	texture.Generation = generation;
+	texture.Path = path;
+	texture.LastUsedFrame = m_Sync->GetFrame();
+
+	QueueDecode(index, kMaxTextureMips);
+	m_Stats.TextureCount++;
+
+	return index;
+}
+
+void CTextureStreamer::Unload(const uint32_t texture)
+{
+	if (texture >= m_Textures.size() || !m_Textures[texture].InUse)
+	{
+		return;
+	}
+
+	STexture& entry = m_Textures[texture];
+
+	if (m_Bindless != nullptr)
+	{
+		m_Bindless->ReleaseTexture(entry.BindlessIndex);
+	}
+	RetireImage(entry.Current);
+	RetireImage(entry.Pending);
+
+	m_Uploads.erase(std::remove(m_Uploads.begin(), m_Uploads.end(), texture), m_Uploads.end());
+
+	// decodes still in flight are dropped by the generation check
+	const uint32_t generation = entry.Generation;
+	entry = STexture();
+	entry.Generation = generation;
+
+	m_FreeTextures.push_back(texture);
+	m_Stats.TextureCount--;
+}
+
+void CTextureStreamer::Touch(const uint32_t texture)
+{
+	if (texture < m_Textures.size() && m_Textures[texture].InUse)
+	{
+		m_Textures[texture].LastUsedFrame = m_Sync->GetFrame();
+	}
+}
+
+void CTextureStreamer::Update(const vk::CommandBuffer commandBuffer)
+{
+	m_StagingOffset = 0;
+	m_Stats.UploadedBytes = 0;
+
+	ProcessDecodeResults(commandBuffer);
+	ContinueUploads(commandBuffer);
+	UpdateResidency(commandBuffer);
+
+	m_Stats.UploadsInFlight = static_cast<uint32_t>(m_Uploads.size());
+}
+
+ETextureState CTextureStreamer::GetState(const uint32_t texture) const
+{
+	return texture < m_Textures.size() && m_Textures[texture].InUse ? m_Textures[texture].State : ETextureState::Failed;
+}
+
+vk::ImageView CTextureStreamer::GetImageView(const uint32_t texture) const
+{
+	return texture < m_Textures.size() ? m_Textures[texture].Current.View : vk::ImageView();
+}
+
+uint32_t CTextureStreamer::GetBindlessIndex(const uint32_t texture) const
+{
+	return texture < m_Textures.size() ? m_Textures[texture].BindlessIndex : UINT32_MAX;
+}
+
+uint32_t CTextureStreamer::GetResidentMip(const uint32_t texture) const
+{
+	return texture < m_Textures.size() ? m_Textures[texture].Current.FirstMip : 0;
+}
+
+vk::Sampler CTextureStreamer::GetSampler() const
+{
+	return m_Sampler;
+}
+
+const STextureStreamingStats& CTextureStreamer::GetStats() const
+{
+	return m_Stats;
+}
+
+void CTextureStreamer::DecodeFile(const SDecodeRequest& request, SDecodeResult& result)
+{
+	result.Texture = request.Texture;
+	result.Generation = request.Generation;
+
+	std::ifstream file(request.Path, std::ios::binary);
+	if (!file.is_open())
+	{
+		SDL_Log("[CTextureStreamer] Unable to open %s", request.Path.c_str());
+		return;
+	}
+
+	STextureFileHeader& header = result.Header;
+	STextureFormatBlock block;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.Magic != kTextureFileMagic || header.Version != kTextureFileVersion ||
+		header.Width == 0 || header.Height == 0 || header.MipCount == 0 || header.MipCount > kMaxTextureMips ||
+		!GetFormatBlock(static_cast<vk::Format>(header.Format), block))
+	{
+		SDL_Log("[CTextureStreamer] %s is not a supported texture file", request.Path.c_str());
+		return;
+	}
+
+	STextureFileMip mips[kMaxTextureMips];
+	if (!file.read(reinterpret_cast<char*>(mips), sizeof(STextureFileMip) * header.MipCount))
+	{
+		SDL_Log("[CTextureStreamer] %s is truncated", request.Path.c_str());
+		return;
+	}
+
+	if (request.Mip == kMaxTextureMips)
+	{
+		// the tail starts at the first mip that fits the tail dimension, at least the last mip
+		result.FirstMip = header.MipCount - 1;
+		while (result.FirstMip > 0 && std::max(GetMipDimension(header.Width, result.FirstMip - 1), GetMipDimension(header.Height, result.FirstMip - 1)) <= kTextureMipTailDimension)
+		{
+			result.FirstMip--;
+		}
+		result.LastMip = header.MipCount - 1;
+	}
+	else
+	{
+		result.FirstMip = std::min(request.Mip, header.MipCount - 1);
+		result.LastMip = result.FirstMip;
+	}
+
+	vk::DeviceSize totalBytes = 0;
+	for (uint32_t mip = result.FirstMip; mip <= result.LastMip; mip++)
+	{
+		if (mips[mip].Size != GetMipBytes(block, header.Width, header.Height, mip))
+		{
+			SDL_Log("[CTextureStreamer] %s: mip %u has an unexpected size", request.Path.c_str(), mip);
+			return;
+		}
+		result.MipOffsets[mip] = totalBytes;
+		totalBytes += mips[mip].Size;
+	}
+
+	result.Data.resize(static_cast<size_t>(totalBytes));
+	for (uint32_t mip = result.FirstMip; mip <= result.LastMip; mip++)
+	{
+		file.seekg(static_cast<std::streamoff>(mips[mip].Offset));
+		if (!file.read(reinterpret_cast<char*>(result.Data.data() + result.MipOffsets[mip]), static_cast<std::streamsize>(mips[mip].Size)))
+		{
+			SDL_Log("[CTextureStreamer] %s: mip %u is truncated", request.Path.c_str(), mip);
+			result.Data.clear();
+			return;
+		}
+	}
+
+	result.Succeeded = true;
+}
+
+void CTextureStreamer::WorkerMain()
+{
+	for (;;)
+	{
+		SDecodeRequest request;
+		{
+			std::unique_lock<std::mutex> lock(m_DecodeMutex);
+			m_DecodeCondition.wait(lock, [this] { return m_StopWorkers || !m_DecodeRequests.empty(); });
+			if (m_StopWorkers)
+			{
+				return;
+			}
+			request = std::move(m_DecodeRequests.front());
+			m_DecodeRequests.pop_front();
+		}
+
+		SDecodeResult result;
+		DecodeFile(request, result);
+
+		std::lock_guard<std::mutex> lock(m_DecodeMutex);
+		m_DecodeResults.push_back(std::move(result));
+	}
+}
+
+void CTextureStreamer::QueueDecode(const uint32_t texture, const uint32_t mip)
+{
+	STexture& entry = m_Textures[texture];
+	entry.DecodeInFlight = true;
+	m_Stats.DecodesInFlight++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_DecodeMutex);
+		m_DecodeRequests.push_back({ texture, entry.Generation, entry.Path, mip });
+	}
+	m_DecodeCondition.notify_one();
+}
+
+void CTextureStreamer::ProcessDecodeResults(const vk::CommandBuffer commandBuffer)
+{
+	std::vector<SDecodeResult> results;
+	{
+		std::lock_guard<std::mutex> lock(m_DecodeMutex);
+		results.swap(m_DecodeResults);
+	}
+
+	for (SDecodeResult& result : results)
+	{
+		m_Stats.DecodesInFlight--;
+
+		if (result.Texture >= m_Textures.size() || m_Textures[result.Texture].Generation != result.Generation || !m_Textures[result.Texture].InUse)
+		{
+			// unloaded while decoding
+			continue;
+		}
+
+		STexture& texture = m_Textures[result.Texture];
+		texture.DecodeInFlight = false;
+
+		const bool initialLoad = texture.State == ETextureState::Loading;
+
+		if (!result.Succeeded)
+		{
+			if (initialLoad)
+			{
+				texture.State = ETextureState::Failed;
+			}
+			texture.UpgradeFailed = true;
+			continue;
+		}
+
+		if (initialLoad)
+		{
+			texture.Format = static_cast<vk::Format>(result.Header.Format);
+			texture.Width = result.Header.Width;
+			texture.Height = result.Header.Height;
+			texture.MipCount = result.Header.MipCount;
+			texture.TailMip = result.FirstMip;
+		}
+		else if (result.Header.Width != texture.Width || result.Header.Height != texture.Height || result.Header.MipCount != texture.MipCount ||
+			static_cast<vk::Format>(result.Header.Format) != texture.Format || result.FirstMip + 1 != texture.Current.FirstMip)
+		{
+			// the file changed on disk since the tail was read
+			texture.UpgradeFailed = true;
+			continue;
+		}
+
+		if (!BeginUpload(commandBuffer, texture, result) && initialLoad)
+		{
+			texture.State = ETextureState::Failed;
+		}
+	}
+}
+
+bool CTextureStreamer::BeginUpload(const vk::CommandBuffer commandBuffer, STexture& texture, SDecodeResult& result)
+{
+	if (!CreateImage(texture, result.FirstMip, texture.Pending))
+	{
+		texture.UpgradeFailed = true;
+		return false;
+	}
+
+	RecordImageBarrier(commandBuffer, texture.Pending.Image, texture.MipCount - result.FirstMip,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+		vk::PipelineStageFlagBits::eTopOfPipe, {},
+		vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+
+	if (texture.Current.Image)
+	{
+		// an upgrade keeps the coarser mips, they are already on the GPU
+		CopyMips(commandBuffer, texture, texture.Current, texture.Pending);
+	}
+
+	texture.Uploading = true;
+	texture.UploadData = std::move(result.Data);
+	std::copy(std::begin(result.MipOffsets), std::end(result.MipOffsets), std::begin(texture.UploadMipOffsets));
+	texture.UploadMip = result.FirstMip;
+	texture.UploadLastMip = result.LastMip;
+	texture.UploadRow = 0;
+
+	m_Uploads.push_back(static_cast<uint32_t>(&texture - m_Textures.data()));
+	return true;
+}
+
+void CTextureStreamer::ContinueUploads(const vk::CommandBuffer commandBuffer)
+{
+	while (!m_Uploads.empty())
+	{
+		STexture& texture = m_Textures[m_Uploads.front()];
+
+		if (!UploadRows(commandBuffer, texture))
+		{
+			// staging for this frame is used up
+			break;
+		}
+
+		SwapPending(commandBuffer, texture);
+		m_Uploads.pop_front();
+	}
+}
+
+bool CTextureStreamer::UploadRows(const vk::CommandBuffer commandBuffer, STexture& texture)
+{
+	STextureFormatBlock block;
+	GetFormatBlock(texture.Format, block);
+
+	const uint32_t slot = m_Sync->GetFrameSlot();
+	const vk::DeviceSize stagingBase = static_cast<vk::DeviceSize>(slot) * kTextureStagingBytesPerFrame;
+
+	while (texture.UploadMip <= texture.UploadLastMip)
+	{
+		const uint32_t mip = texture.UploadMip;
+		const uint32_t mipWidth = GetMipDimension(texture.Width, mip);
+		const uint32_t mipHeight = GetMipDimension(texture.Height, mip);
+		const uint32_t blockRows = (mipHeight + block.Dimension - 1) / block.Dimension;
+		const vk::DeviceSize rowBytes = static_cast<vk::DeviceSize>((mipWidth + block.Dimension - 1) / block.Dimension) * block.Bytes;
+
+		// large mips are split by block rows across frames
+		m_StagingOffset = (m_StagingOffset + kTextureStagingAlignment - 1) / kTextureStagingAlignment * kTextureStagingAlignment;
+		const vk::DeviceSize available = m_StagingOffset < kTextureStagingBytesPerFrame ? kTextureStagingBytesPerFrame - m_StagingOffset : 0;
+		const uint32_t rows = static_cast<uint32_t>(std::min<vk::DeviceSize>(blockRows - texture.UploadRow, available / rowBytes));
+
+		if (rows == 0)
+		{
+			return false;
+		}
+
+		const vk::DeviceSize bytes = rows * rowBytes;
+		memcpy(m_StagingMapped + stagingBase + m_StagingOffset, texture.UploadData.data() + texture.UploadMipOffsets[mip] + texture.UploadRow * rowBytes, static_cast<size_t>(bytes));
+
+		const uint32_t firstTexelRow = texture.UploadRow * block.Dimension;
+		const vk::BufferImageCopy region = {
+			stagingBase + m_StagingOffset,
+			0,
+			0,
+			{
+				vk::ImageAspectFlagBits::eColor,
+				mip - texture.Pending.FirstMip,
+				0,
+				1
+			},
+			{ 0, static_cast<int32_t>(firstTexelRow), 0 },
+			{ mipWidth, std::min(rows * block.Dimension, mipHeight - firstTexelRow), 1 }
+		};
+
+		commandBuffer.copyBufferToImage(m_StagingBuffer, texture.Pending.Image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+
+		m_StagingOffset += bytes;
+		m_Stats.UploadedBytes += bytes;
+
+		texture.UploadRow += rows;
+		if (texture.UploadRow == blockRows)
+		{
+			texture.UploadMip++;
+			texture.UploadRow = 0;
+		}
+	}
+
+	return true;
+}
+
+void CTextureStreamer::SwapPending(const vk::CommandBuffer commandBuffer, STexture& texture)
+{
+	RecordImageBarrier(commandBuffer, texture.Pending.Image, texture.MipCount - texture.Pending.FirstMip,
+		vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+		vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite,
+		kTextureShaderStages, vk::AccessFlagBits::eShaderRead);
+
+	// the old image may still be sampled by frames in flight
+	RetireImage(texture.Current);
+	texture.Current = texture.Pending;
+	texture.Pending = SImage();
+
+	if (m_Bindless != nullptr)
+	{
+		m_Bindless->ReleaseTexture(texture.BindlessIndex);
+		texture.BindlessIndex = m_Bindless->RegisterTexture(texture.Current.View, m_Sampler);
+	}
+
+	texture.State = ETextureState::Resident;
+	texture.Uploading = false;
+	texture.UploadData.clear();
+	texture.UploadData.shrink_to_fit();
+}
+
+void CTextureStreamer::UpdateResidency(const vk::CommandBuffer commandBuffer)
+{
+	const uint64_t frame = m_Sync->GetFrame();
+	const SMemoryHeapInfo& heap = m_Memory->GetHeapInfo(m_ImageMemoryHeap);
+
+	m_Stats.Budget = std::min(kTextureStreamingBudget, heap.Budget / 2);
+	if (m_Memory->IsHeapLow(m_ImageMemoryHeap))
+	{
+		// other allocations are crowding the heap, stop growing
+		m_Stats.Budget = std::min(m_Stats.Budget, m_Stats.ResidentBytes);
+	}
+
+	const auto isStale = [&](const STexture& texture) { return texture.LastUsedFrame + kTextureEvictionFrames < frame; };
+	const auto canEvict = [&](const STexture& texture)
+	{
+		return texture.InUse && texture.State == ETextureState::Resident && !texture.Uploading && !texture.DecodeInFlight && texture.Current.FirstMip < texture.TailMip;
+	};
+
+	// evicts the finest mip of the least recently used stale texture, returns false when nothing can go
+	const auto evictOne = [&]()
+	{
+		STexture* victim = nullptr;
+		for (STexture& texture : m_Textures)
+		{
+			if (canEvict(texture) && isStale(texture) && (victim == nullptr || texture.LastUsedFrame < victim->LastUsedFrame))
+			{
+				victim = &texture;
+			}
+		}
+		return victim != nullptr && EvictMip(commandBuffer, *victim);
+	};
+
+	while (m_Stats.ResidentBytes > m_Stats.Budget && evictOne())
+	{
+	}
+
+	// upgrade the most recently used textures first, one mip at a time
+	std::vector<uint32_t> candidates;
+	for (uint32_t index = 0; index < m_Textures.size(); index++)
+	{
+		const STexture& texture = m_Textures[index];
+		if (texture.InUse && texture.State == ETextureState::Resident && !texture.Uploading && !texture.DecodeInFlight && !texture.UpgradeFailed &&
+			texture.Current.FirstMip > 0 && !isStale(texture))
+		{
+			candidates.push_back(index);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [&](const uint32_t a, const uint32_t b) { return m_Textures[a].LastUsedFrame > m_Textures[b].LastUsedFrame; });
+
+	for (const uint32_t index : candidates)
+	{
+		if (m_Stats.DecodesInFlight >= kMaxTextureDecodesInFlight)
+		{
+			break;
+		}
+
+		// during the upgrade both the old and the new image are resident
+		const vk::DeviceSize upgradeBytes = EstimateImageBytes(m_Textures[index], m_Textures[index].Current.FirstMip - 1);
+		while (m_Stats.ResidentBytes + upgradeBytes > m_Stats.Budget && evictOne())
+		{
+		}
+		if (m_Stats.ResidentBytes + upgradeBytes > m_Stats.Budget)
+		{
+			break;
+		}
+
+		QueueDecode(index, m_Textures[index].Current.FirstMip - 1);
+	}
+}
+
+bool CTextureStreamer::EvictMip(const vk::CommandBuffer commandBuffer, STexture& texture)
+{
+	SImage smaller;
+	if (!CreateImage(texture, texture.Current.FirstMip + 1, smaller))
+	{
+		return false;
+	}
+
+	RecordImageBarrier(commandBuffer, smaller.Image, texture.MipCount - smaller.FirstMip,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+		vk::PipelineStageFlagBits::eTopOfPipe, {},
+		vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+
+	CopyMips(commandBuffer, texture, texture.Current, smaller);
+
+	texture.Pending = smaller;
+	SwapPending(commandBuffer, texture);
+
+	m_Stats.Evictions++;
+	return true;
+}
+
+void CTextureStreamer::CopyMips(const vk::CommandBuffer commandBuffer, const STexture& texture, const SImage& source, const SImage& destination) const
+{
+	const uint32_t sourceLevels = texture.MipCount - source.FirstMip;
+	const uint32_t firstMip = std::max(source.FirstMip, destination.FirstMip);
+
+	RecordImageBarrier(commandBuffer, source.Image, sourceLevels,
+		vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal,
+		kTextureShaderStages, {},
+		vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+
+	std::vector<vk::ImageCopy> regions;
+	for (uint32_t mip = firstMip; mip < texture.MipCount; mip++)
+	{
+		const vk::Extent3D extent = { GetMipDimension(texture.Width, mip), GetMipDimension(texture.Height, mip), 1 };
+		regions.push_back({
+			{ vk::ImageAspectFlagBits::eColor, mip - source.FirstMip, 0, 1 },
+			{ 0, 0, 0 },
+			{ vk::ImageAspectFlagBits::eColor, mip - destination.FirstMip, 0, 1 },
+			{ 0, 0, 0 },
+			extent
+		});
+	}
+
+	commandBuffer.copyImage(source.Image, vk::ImageLayout::eTransferSrcOptimal, destination.Image, vk::ImageLayout::eTransferDstOptimal, static_cast<uint32_t>(regions.size()), regions.data());
+
+	// the source stays in use until the destination replaces it
+	RecordImageBarrier(commandBuffer, source.Image, sourceLevels,
+		vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+		vk::PipelineStageFlagBits::eTransfer, {},
+		kTextureShaderStages, vk::AccessFlagBits::eShaderRead);
+}
+
+bool CTextureStreamer::CreateImage(const STexture& texture, const uint32_t firstMip, SImage& image)
+{
+	vk::Result vkResult;
+
+	const uint32_t levelCount = texture.MipCount - firstMip;
+
+	const vk::ImageCreateInfo imageCreateInfo = {
+		{},
+		vk::ImageType::e2D,
+		texture.Format,
+		{ GetMipDimension(texture.Width, firstMip), GetMipDimension(texture.Height, firstMip), 1 },
+		levelCount,
+		1,
+		vk::SampleCountFlagBits::e1,
+		vk::ImageTiling::eOptimal,
+		vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc,
+		vk::SharingMode::eExclusive
+	};
+
+	std::tie(vkResult, image.Image) = m_Device.createImage(imageCreateInfo);
+	if (vkResult != vk::Result::eSuccess)
+	{
+		image = SImage();
+		return false;
+	}
+
+	const vk::MemoryRequirements memoryRequirements = m_Device.getImageMemoryRequirements(image.Image);
+	const vk::MemoryAllocateInfo allocInfo = {
+		memoryRequirements.size,
+		m_Memory->FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal)
+	};
+
+	if (allocInfo.memoryTypeIndex == UINT32_MAX || m_Memory->Allocate(allocInfo, EMemoryCategory::Texture, image.Memory) != vk::Result::eSuccess ||
+		m_Device.bindImageMemory(image.Image, image.Memory, 0) != vk::Result::eSuccess)
+	{
+		DestroyImage(image);
+		return false;
+	}
+
+	image.Size = memoryRequirements.size;
+	image.FirstMip = firstMip;
+	m_Stats.ResidentBytes += image.Size;
+
+	const vk::ImageViewCreateInfo viewCreateInfo = {
+		{},
+		image.Image,
+		vk::ImageViewType::e2D,
+		texture.Format,
+		{},
+		{
+			vk::ImageAspectFlagBits::eColor,
+			0,
+			levelCount,
+			0,
+			1
+		}
+	};
+
+	std::tie(vkResult, image.View) = m_Device.createImageView(viewCreateInfo);
+	if (vkResult != vk::Result::eSuccess)
+	{
+		DestroyImage(image);
+		return false;
+	}
+
+	return true;
+}
+
+void CTextureStreamer::RetireImage(SImage& image)
+{
+	m_DeletionQueue->Destroy(image.View);
+	m_DeletionQueue->Destroy(image.Image);
+	m_DeletionQueue->Destroy(image.Memory);
+	m_Stats.ResidentBytes -= image.Size;
+	image = SImage();
+}
+
+void CTextureStreamer::DestroyImage(SImage& image)
+{
+	if (image.View)
+	{
+		m_Device.destroyImageView(image.View);
+	}
+	if (image.Image)
+	{
+		m_Device.destroyImage(image.Image);
+	}
+	if (image.Memory)
+	{
+		m_Memory->Free(image.Memory);
+	}
+	m_Stats.ResidentBytes -= image.Size;
+	image = SImage();
+}
+
+vk::DeviceSize CTextureStreamer::EstimateImageBytes(const STexture& texture, const uint32_t firstMip) const
+{
+	STextureFormatBlock block;
+	GetFormatBlock(texture.Format, block);
+
+	vk::DeviceSize bytes = 0;
+	for (uint32_t mip = firstMip; mip < texture.MipCount; mip++)
+	{
+		bytes += GetMipBytes(block, texture.Width, texture.Height, mip);
+	}
+	return bytes;
+}
@@ -0,0 +1,137 @@
+#include "VertexLayout.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/packing.hpp>
+
+const vk::Format kVertexFormatVk[kVertexFormatCount] = {
+	vk::Format::eR32G32B32Sfloat,
+	vk::Format::eR32G32Sfloat,
+	vk::Format::eR16G16B16A16Sfloat,
+	vk::Format::eR16G16B16A16Snorm,
+	vk::Format::eR16G16Snorm,
+	vk::Format::eR8G8B8A8Unorm
+};
+
+static void EncodeAttribute(const EVertexFormat format, const glm::vec4& value, uint8_t* destination)
+{
+	switch (format)
+	{
+	case EVertexFormat::Float3:
+		memcpy(destination, &value, 12);
+		break;
+	case EVertexFormat::Float2:
+		memcpy(destination, &value, 8);
+		break;
+	case EVertexFormat::Half4:
+	{
+		const glm::uint64 packed = glm::packHalf4x16(value);
+		memcpy(destination, &packed, 8);
+		break;
+	}
+	case EVertexFormat::Snorm16x4:
+	{
+		const glm::uint64 packed = glm::packSnorm4x16(value);
+		memcpy(destination, &packed, 8);
+		break;
+	}
+	case EVertexFormat::Snorm16x2:
+	{
+		const glm::uint32 packed = glm::packSnorm2x16(glm::vec2(value));
+		memcpy(destination, &packed, 4);
+		break;
+	}
+	case EVertexFormat::Unorm8x4:
+	{
+		const glm::uint32 packed = glm::packUnorm4x8(value);
+		memcpy(destination, &packed, 4);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+uint32_t SVertexLayout::GetStride() const
+{
+	uint32_t stride = 0;
+	for (const EVertexFormat format : Formats)
+	{
+		stride += kVertexFormatSizes[static_cast<uint32_t>(format)];
+	}
+	return stride;
+}
+
+uint32_t SVertexLayout::GetOffset(const EVertexAttribute attribute) const
+{
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(attribute); i++)
+	{
+		offset += kVertexFormatSizes[static_cast<uint32_t>(Formats[i])];
+	}
+	return offset;
+}
+
+vk::VertexInputBindingDescription SVertexLayout::GetBindingDescription(const uint32_t binding) const
+{
+	return {
+		binding,
+		GetStride(),
+		vk::VertexInputRate::eVertex
+	};
+}
+
+void SVertexLayout::GetAttributeDescriptions(const uint32_t binding, vk::VertexInputAttributeDescription* descriptions) const
+{
+	for (uint32_t i = 0; i < kVertexAttributeCount; i++)
+	{
+		descriptions[i] = {
+			i,
+			binding,
+			kVertexFormatVk[static_cast<uint32_t>(Formats[i])],
+			GetOffset(static_cast<EVertexAttribute>(i))
+		};
+	}
+}
+
+void SVertexLayout::Encode(const SVertexInput& vertex, uint8_t* destination) const
+{
+	const glm::vec4 values[kVertexAttributeCount] = {
+		glm::vec4(vertex.Position / PositionScale, 0.f),
+		glm::vec4(EncodeOctahedral(vertex.Normal), 0.f, 0.f),
+		glm::vec4(vertex.Color, 1.f)
+	};
+
+	for (uint32_t i = 0; i < kVertexAttributeCount; i++)
+	{
+		EncodeAttribute(Formats[i], values[i], destination);
+		destination += kVertexFormatSizes[static_cast<uint32_t>(Formats[i])];
+	}
+}
+
+const SVertexLayout* FindVertexLayout(const std::string& name)
+{
+	for (const SVertexLayout& layout : kVertexLayouts)
+	{
+		if (name == layout.Name)
+		{
+			return &layout;
+		}
+	}
+	return nullptr;
+}
+
+glm::vec2 EncodeOctahedral(const glm::vec3 normal)
+{
+	const glm::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+	if (n.z >= 0.f)
+	{
+		return glm::vec2(n.x, n.y);
+	}
+
+	// fold the lower hemisphere over the diagonals
+	return glm::vec2(
+		(1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+		(1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f));
+}
@@ -1,8 +1,17 @@
 #include "Viewport.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#include "JobSystem.h"
 #include "Render.h"
+#include "SDL_vulkan.h"
+#include "imgui.h"
 #include "imgui_impl_sdl.h"
 
+static_assert(kViewportCursorCount == ImGuiMouseCursor_COUNT, "one system cursor per ImGui cursor shape");
+
 EEngineStatus CViewport::Initialize()
 {
 	m_Window = SDL_CreateWindow(kViewportWindowTitle, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, kViewportInitialWidth, kViewportInitialHeight, SDL_WINDOW_VULKAN | SDL_WINDOW_ALLOW_HIGHDPI);
@@ -12,25 +21,110 @@ EEngineStatus CViewport::Initialize()
 		return EEngineStatus::Failed;
 	}
 
+	// the backend sets up the key map and clipboard; its NewFrame is replaced by ours, which stays off SDL
 	ImGui_ImplSDL2_InitForVulkan(m_Window);
 
+	m_Cursors[ImGuiMouseCursor_Arrow] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_ARROW);
+	m_Cursors[ImGuiMouseCursor_TextInput] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_IBEAM);
+	m_Cursors[ImGuiMouseCursor_ResizeAll] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_SIZEALL);
+	m_Cursors[ImGuiMouseCursor_ResizeNS] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_SIZENS);
+	m_Cursors[ImGuiMouseCursor_ResizeEW] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_SIZEWE);
+	m_Cursors[ImGuiMouseCursor_ResizeNESW] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_SIZENESW);
+	m_Cursors[ImGuiMouseCursor_ResizeNWSE] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_SIZENWSE);
+	m_Cursors[ImGuiMouseCursor_Hand] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_HAND);
+	m_Cursors[ImGuiMouseCursor_NotAllowed] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_NO);
+
+	m_UseGlobalMouseState = strncmp(SDL_GetCurrentVideoDriver(), "wayland", 7) != 0;
+
 	return EEngineStatus::Ok;
 }
 
-EEngineStatus CViewport::Update()
+void CViewport::PumpEvents(const uint32_t timeoutMs)
 {
 	SDL_Event event;
 
-	while (SDL_PollEvent(&event) != 0)
+	if (SDL_WaitEventTimeout(&event, static_cast<int>(timeoutMs)) != 0)
 	{
-		if (ImGui_ImplSDL2_ProcessEvent(&event))continue;
-		switch (event.type)
+		do
 		{
-		case SDL_QUIT:
+			if (event.type == SDL_QUIT)
+			{
+				// handled here so that a full queue cannot swallow it
+				gEngine->Quit();
+			}
+			else if (!m_InputQueue.Push({ event, std::chrono::high_resolution_clock::now() }))
+			{
+				m_DroppedEvents++;
+			}
+		} while (SDL_PollEvent(&event) != 0);
+	}
+
+	// sampled after the events, so that the frame never sees a state older than the events it handles
+	SWindowState state;
+	if ((SDL_GetWindowFlags(m_Window) & SDL_WINDOW_MINIMIZED) == 0)
+	{
+		SDL_GetWindowSize(m_Window, &state.Width, &state.Height);
+	}
+	SDL_Vulkan_GetDrawableSize(m_Window, &state.DrawableWidth, &state.DrawableHeight);
+	state.MouseButtons = SDL_GetMouseState(&state.MouseX, &state.MouseY);
+	state.Focused = SDL_GetKeyboardFocus() == m_Window;
+
+	if (state.Focused && m_UseGlobalMouseState)
+	{
+		// the window-relative position goes stale while the mouse is captured outside of the window
+		int windowX, windowY;
+		SDL_GetWindowPosition(m_Window, &windowX, &windowY);
+		SDL_GetGlobalMouseState(&state.MouseX, &state.MouseY);
+		state.MouseX -= windowX;
+		state.MouseY -= windowY;
+	}
+
+	std::lock_guard<std::mutex> lock(m_WindowStateMutex);
+	m_WindowState = state;
+}
+
+EEngineStatus CViewport::Update()
+{
+	using namespace std::chrono;
+
+	// without new events the frame reacts to nothing older than this
+	m_LastInputTime = high_resolution_clock::now();
+	m_Stats.Events = 0;
+	m_Stats.MaxQueueDelayMs = 0.f;
+
+	SInputEvent input;
+	while (m_InputQueue.Pop(input))
+	{
+		m_Stats.Events++;
+		m_Stats.MaxQueueDelayMs = std::max(m_Stats.MaxQueueDelayMs, duration<float, std::milli>(high_resolution_clock::now() - input.Time).count());
+		m_LastInputTime = input.Time;
+
+		SDL_Event& event = input.Event;
+		if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button >= SDL_BUTTON_LEFT && event.button.button <= SDL_BUTTON_RIGHT)
 		{
-			gEngine->Quit();
-			break;
+			// SDL numbers the buttons left, middle, right, ImGui left, right, middle
+			const uint32_t buttonIndices[] = { 0, 2, 1 };
+			m_MousePressed[buttonIndices[event.button.button - SDL_BUTTON_LEFT]] = true;
+		}
+		if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+		{
+			// the backend reads the modifiers from SDL's keyboard state, which the window thread is updating;
+			// the event carries them as they were
+			ImGui_ImplSDL2_ProcessEvent(&event);
+			ImGuiIO& io = ImGui::GetIO();
+			io.KeyShift = (event.key.keysym.mod & KMOD_SHIFT) != 0;
+			io.KeyCtrl = (event.key.keysym.mod & KMOD_CTRL) != 0;
+			io.KeyAlt = (event.key.keysym.mod & KMOD_ALT) != 0;
+#ifdef _WIN32
+			io.KeySuper = false;
+#else
+			io.KeySuper = (event.key.keysym.mod & KMOD_GUI) != 0;
+#endif
+			continue;
 		}
+		if (ImGui_ImplSDL2_ProcessEvent(&event))continue;
+		switch (event.type)
+		{
 		case SDL_MOUSEWHEEL:
 		{
 			gEngine->GetRender()->m_RotationSpeed += (static_cast<float>(event.wheel.y) * 1.f);
@@ -42,11 +136,106 @@ EEngineStatus CViewport::Update()
 		}
 	}
 
+	m_Stats.Dropped = m_DroppedEvents;
+
 	return EEngineStatus::Ok;
 }
 
+void CViewport::NewFrame()
+{
+	ImGuiIO& io = ImGui::GetIO();
+
+	SWindowState state;
+	{
+		std::lock_guard<std::mutex> lock(m_WindowStateMutex);
+		state = m_WindowState;
+	}
+
+	io.DisplaySize = ImVec2(static_cast<float>(state.Width), static_cast<float>(state.Height));
+	if (state.Width > 0 && state.Height > 0)
+	{
+		io.DisplayFramebufferScale = ImVec2(static_cast<float>(state.DrawableWidth) / state.Width, static_cast<float>(state.DrawableHeight) / state.Height);
+	}
+
+	const uint64_t counter = SDL_GetPerformanceCounter();
+	io.DeltaTime = m_LastFrameCounter != 0 ? static_cast<float>(static_cast<double>(counter - m_LastFrameCounter) / SDL_GetPerformanceFrequency()) : 1.f / 60.f;
+	m_LastFrameCounter = counter;
+
+	const uint32_t buttons[] = { SDL_BUTTON(SDL_BUTTON_LEFT), SDL_BUTTON(SDL_BUTTON_RIGHT), SDL_BUTTON(SDL_BUTTON_MIDDLE) };
+	for (uint32_t button = 0; button < 3; button++)
+	{
+		io.MouseDown[button] = m_MousePressed[button] || (state.MouseButtons & buttons[button]) != 0;
+		m_MousePressed[button] = false;
+	}
+
+	const bool warp = io.WantSetMousePos;
+	const int warpX = static_cast<int>(io.MousePos.x);
+	const int warpY = static_cast<int>(io.MousePos.y);
+	io.MousePos = state.Focused ? ImVec2(static_cast<float>(state.MouseX), static_cast<float>(state.MouseY)) : ImVec2(-FLT_MAX, -FLT_MAX);
+
+	// cursor shape from the previous frame, as the backend does; the window thread applies it
+	int cursor = m_RequestedCursor;
+	if ((io.ConfigFlags & ImGuiConfigFlags_NoMouseCursorChange) == 0)
+	{
+		cursor = io.MouseDrawCursor ? ImGuiMouseCursor_None : ImGui::GetMouseCursor();
+	}
+	// lets a drag leave the window without the OS taking over the mouse
+	const bool capture = ImGui::IsAnyMouseDown();
+
+	if (!warp && cursor == m_RequestedCursor && capture == m_RequestedCapture)
+	{
+		return;
+	}
+
+	const bool setCursor = cursor != m_RequestedCursor;
+	m_RequestedCursor = cursor;
+	m_RequestedCapture = capture;
+
+	gEngine->GetJobSystem()->Run([this, warp, warpX, warpY, setCursor, cursor, capture]()
+	{
+		if (warp)
+		{
+			SDL_WarpMouseInWindow(m_Window, warpX, warpY);
+		}
+
+		SDL_CaptureMouse(capture ? SDL_TRUE : SDL_FALSE);
+
+		if (setCursor)
+		{
+			if (cursor == ImGuiMouseCursor_None)
+			{
+				SDL_ShowCursor(SDL_FALSE);
+			}
+			else
+			{
+				SDL_SetCursor(m_Cursors[cursor] != nullptr ? m_Cursors[cursor] : m_Cursors[ImGuiMouseCursor_Arrow]);
+				SDL_ShowCursor(SDL_TRUE);
+			}
+		}
+	}, nullptr, EJobAffinity::MainThread);
+}
+
+std::chrono::high_resolution_clock::time_point CViewport::GetLastInputTime() const
+{
+	return m_LastInputTime;
+}
+
+const SInputStats& CViewport::GetStats() const
+{
+	return m_Stats;
+}
+
 EEngineStatus CViewport::Shutdown()
 {
+	// cursor requests still queued refer to the cursors
+	gEngine->GetJobSystem()->RunMainThreadJobs();
+
+	for (SDL_Cursor*& cursor : m_Cursors)
+	{
+		SDL_FreeCursor(cursor);
+		cursor = nullptr;
+	}
+
 	ImGui_ImplSDL2_Shutdown();
 	return EEngineStatus::Ok;
 }